@@ -0,0 +1,58 @@
+#pragma once
+
+#include "lib.h"
+
+#include "board.h"
+#include "search.h"
+#include "tt.h"
+
+/**
+ * @brief The Analyzer class
+ *
+ * This class searches every position of an EPD (or FEN) file and writes one
+ * JSON line per position, in input order. Positions are spread over worker
+ * threads, each one with its own boards and transposition table (or all of
+ * them sharing one given table).
+ */
+class Analyzer {
+  public:
+    /**
+     * @brief Construct a new Analyzer object
+     *
+     * @param limits search limits for every position
+     * @param threads number of worker threads
+     * @param megabytes size of the transposition table of each worker
+     * @param tt table shared by every worker instead, (optional)
+     */
+    Analyzer(const SearchLimits &limits, unsigned threads,
+             std::size_t megabytes = 4, TranspositionTable *tt = nullptr);
+    ~Analyzer();
+
+    /**
+     * @brief analyzes a whole file, blank lines and `#` comments are skipped
+     *
+     * @param filename path of the EPD file
+     * @param os where the JSON lines are written
+     * @return unsigned - number of positions analyzed
+     */
+    unsigned run(const std::string &filename, std::ostream &os);
+
+    /**
+     * @brief analyzes one EPD or FEN line
+     *
+     * @param line EPD or FEN
+     * @param number line number in the input
+     * @param limits search limits
+     * @param tt transposition table of the calling worker
+     * @return std::string - JSON object (without newline)
+     */
+    static std::string analyze(const std::string &line, unsigned number,
+                               const SearchLimits &limits,
+                               TranspositionTable &tt);
+
+  private:
+    SearchLimits limits;    // limits of every search
+    unsigned threads;       // number of workers
+    std::size_t megabytes;  // table size per worker
+    TranspositionTable *tt; // shared table or nullptr
+};
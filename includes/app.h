@@ -1,8 +1,22 @@
 #include "lib.h"
 
+#include "analyzer.h"
+#include "bench.h"
 #include "board.h"
+#include "game.h"
+#include "history.h"
+#include "match.h"
 #include "move.h"
+#include "notation.h"
+#include "pgn.h"
+#include "pool.h"
+#include "ponder.h"
+#include "profile.h"
 #include "result.h"
+#include "search.h"
+#include "split.h"
+#include "tt.h"
+#include "uci.h"
 
 /**
  * @brief The App class
@@ -20,41 +34,96 @@ class App {
     App(int argc, char *argv[]);
     ~App();
 
-    const std::string &fen() const;      // accessor
-    const std::string &moves() const;    // accessor
-    const std::string &filename() const; // accessor
-    const bool &verbose() const;         // accessor
-    const bool &quiet() const;           // accessor
-    const bool &help() const;            // accessor
-    const bool &version() const;         // accessor
-    const bool &license() const;         // accessor
+    const std::string &fen() const;       // accessor
+    const std::string &moves() const;     // accessor
+    const std::string &filename() const;  // accessor
+    const bool &verbose() const;          // accessor
+    const bool &quiet() const;            // accessor
+    const bool &ponder() const;           // accessor
+    const bool &uci() const;              // accessor
+    const std::string &analyze() const;   // accessor
+    const int &depth() const;             // accessor
+    const u_int64_t &nodes() const;       // accessor
+    const unsigned &multipv() const;      // accessor
+    const std::string &selfplay() const;  // accessor
+    const unsigned &games() const;        // accessor
+    const std::string &first() const;     // accessor
+    const std::string &second() const;    // accessor
+    const std::string &sprt() const;      // accessor
+    const std::string &hash_file() const; // accessor
+    const bool &hash_prefault() const;    // accessor
+    const unsigned &threads() const;      // accessor
+    const bool &affinity() const;         // accessor
+    const std::string &smp() const;       // accessor
+    const bool &bench() const;            // accessor
+    const bool &profile() const;          // accessor
+    const bool &help() const;             // accessor
+    const bool &version() const;          // accessor
+    const bool &license() const;          // accessor
 
-    std::string &fen();      // mutator
-    std::string &moves();    // mutator
-    std::string &filename(); // mutator
-    bool &verbose();         // mutator
-    bool &quiet();           // mutator
-    bool &help();            // mutator
-    bool &version();         // mutator
-    bool &license();         // mutator
+    std::string &fen();       // mutator
+    std::string &moves();     // mutator
+    std::string &filename();  // mutator
+    bool &verbose();          // mutator
+    bool &quiet();            // mutator
+    bool &ponder();           // mutator
+    bool &uci();              // mutator
+    std::string &analyze();   // mutator
+    int &depth();             // mutator
+    u_int64_t &nodes();       // mutator
+    unsigned &multipv();      // mutator
+    std::string &selfplay();  // mutator
+    unsigned &games();        // mutator
+    std::string &first();     // mutator
+    std::string &second();    // mutator
+    std::string &sprt();      // mutator
+    std::string &hash_file(); // mutator
+    bool &hash_prefault();    // mutator
+    unsigned &threads();      // mutator
+    bool &affinity();         // mutator
+    std::string &smp();       // mutator
+    bool &bench();            // mutator
+    bool &profile();          // mutator
+    bool &help();             // mutator
+    bool &version();          // mutator
+    bool &license();          // mutator
 
-    void fen(const std::string &fen);           // mutator
-    void moves(const std::string &moves);       // mutator
-    void filename(const std::string &filename); // mutator
-    void verbose(const bool verbose);           // mutator
-    void quiet(const bool quiet);               // mutator
-    void help(const bool help);                 // mutator
-    void version(const bool version);           // mutator
-    void license(const bool license);           // mutator
+    void fen(const std::string &fen);             // mutator
+    void moves(const std::string &moves);         // mutator
+    void filename(const std::string &filename);   // mutator
+    void verbose(const bool verbose);             // mutator
+    void quiet(const bool quiet);                 // mutator
+    void ponder(const bool ponder);               // mutator
+    void uci(const bool uci);                     // mutator
+    void analyze(const std::string &analyze);     // mutator
+    void depth(const int depth);                  // mutator
+    void nodes(const u_int64_t nodes);            // mutator
+    void multipv(const unsigned multipv);         // mutator
+    void selfplay(const std::string &selfplay);   // mutator
+    void games(const unsigned games);             // mutator
+    void first(const std::string &first);         // mutator
+    void second(const std::string &second);       // mutator
+    void sprt(const std::string &sprt);           // mutator
+    void hash_file(const std::string &hash_file); // mutator
+    void hash_prefault(const bool hash_prefault); // mutator
+    void threads(const unsigned threads);         // mutator
+    void affinity(const bool affinity);           // mutator
+    void smp(const std::string &smp);             // mutator
+    void bench(const bool bench);                 // mutator
+    void profile(const bool profile);             // mutator
+    void help(const bool help);                   // mutator
+    void version(const bool version);             // mutator
+    void license(const bool license);             // mutator
 
     /**
      * @brief gets the move played by CPU
      *
      * @param board board
+     * @param keys keys of the positions played before the current one
      * @param best if get best move
      * @return Move - move
      */
-    Move get_cpu_move(Board &board, bool best);
+    Move get_cpu_move(Board &board, const History &keys, bool best);
     /**
      * @brief run the app until either the user quits the app
      * or there is no legal move left for the current player
@@ -62,6 +131,40 @@ class App {
      * @return int - exit code
      */
     int run();
+    /**
+     * @brief replays every game of the pgn file given with `--filename`,
+     * the session then goes on from the end of the last game
+     *
+     * @param game game, left at the end of the last game
+     */
+    void load_games(Game &game);
+    /**
+     * @brief plays the moves given with `--moves` (SAN or LAN, move numbers
+     * allowed), exits on the first move that can not be played
+     *
+     * @param game game the moves are played in
+     */
+    void play_moves(Game &game);
+    /**
+     * @brief plays the match given with `--selfplay` and reports its results
+     *
+     * @return int - exit code
+     */
+    int play_match();
+    /**
+     * @brief loads the transposition table from the `--hash-file`, a missing
+     * file is a cold start and a bad one is reported and ignored
+     *
+     */
+    void load_hash();
+    /**
+     * @brief saves the transposition table to the `--hash-file`, failures
+     * are reported
+     *
+     * @return true - if the table was saved
+     * @return false - otherwise
+     */
+    bool save_hash();
 
     void get_help [[noreturn]] (const std::string &msg = "");
     void get_version [[noreturn]] ();
@@ -83,15 +186,37 @@ class App {
     friend std::ostream &operator<<(std::ostream &os, const App &app);
 
   private:
-    std::string fen_;      // starting fen or blank
-    std::string moves_;    // starting moves to be played on game launch
-    std::string filename_; // filename to load a play
-    bool verbose_;         // verbose mode
-    bool quiet_;           // quiet mode
-    bool help_;            // display help
-    bool version_;         // display version
-    bool license_;         // display small license
+    std::string fen_;       // starting fen or blank
+    std::string moves_;     // starting moves to be played on game launch
+    std::string filename_;  // filename to load a play
+    bool verbose_;          // verbose mode
+    bool quiet_;            // quiet mode
+    bool ponder_;           // think on the opponent's time
+    bool uci_;              // speak uci instead of the interactive prompt
+    std::string analyze_;   // epd file to analyze in batch
+    int depth_;             // depth of the batch searches (plies)
+    u_int64_t nodes_;       // node budget of the batch searches, 0 for none
+    unsigned multipv_;      // number of best moves of the batch searches
+    std::string selfplay_;  // epd file of the self-play openings
+    unsigned games_;        // number of self-play games, 0 for two per opening
+    std::string first_;     // configuration of the first engine
+    std::string second_;    // configuration of the second engine
+    std::string sprt_;      // elo0,elo1 of the self-play test
+    std::string hash_file_; // file the transposition table is kept in
+    bool hash_prefault_;    // fault the table pages in at start
+    unsigned threads_;      // workers of the thread pool, 0 for one per core
+    bool affinity_;         // pin the workers to cores
+    std::string smp_;       // parallel search of bench and uci, or blank
+    bool bench_;            // search the bench positions and exit
+    bool profile_;          // count the hot path phases, report at exit
+    bool help_;             // display help
+    bool version_;          // display version
+    bool license_;          // display small license
 
     int64_t white_thinking_time; // white thinking time
     int64_t black_thinking_time; // black thinking time
+
+    TranspositionTable tt; // shared by all cpu searches
+    SearchThread search;   // cpu search, runs while the user may stop it
+    Ponder pondering;      // background search on the opponent's time
 };
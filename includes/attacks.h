@@ -0,0 +1,164 @@
+#pragma once
+
+#include "lib.h"
+
+#include "position.h"
+
+/**
+ * @brief The Leaps struct
+ *
+ * Squares a leaper (knight or king) attacks from one square, as a mask and as
+ * a list in the order moves have always been generated.
+ */
+struct Leaps {
+    u_int64_t mask;      // one bit per square index (a1 is bit 0)
+    u_int8_t count;      // number of squares
+    u_int8_t squares[8]; // square indexes, in generation order
+};
+
+/**
+ * @brief The AttackTables struct
+ *
+ * Attacks from every square of the board, computed at compile time.
+ */
+struct AttackTables {
+    Leaps knights[64];
+    Leaps kings[64];
+    u_int64_t pawns[2][64];   // squares taken by a pawn of each color
+    u_int64_t diagonals[64];  // both diagonals, the square excluded
+};
+
+/**
+ * @brief computes the steps of a leaper that stay on the board
+ *
+ * @param index square index
+ * @param steps row and col steps, in generation order
+ * @return Leaps - attacked squares
+ */
+constexpr Leaps build_leaps(int index, const int (&steps)[8][2]) {
+    Leaps leaps = {};
+    for (const int *step : steps) {
+        int row = index / 8 + step[0], col = index % 8 + step[1];
+        if (row >= 0 && row < 8 && col >= 0 && col < 8) {
+            leaps.mask |= u_int64_t(1) << (row * 8 + col);
+            leaps.squares[leaps.count++] = u_int8_t(row * 8 + col);
+        }
+    }
+    return leaps;
+}
+
+/**
+ * @brief computes the attack tables (at compile time)
+ *
+ * @return AttackTables - tables
+ */
+constexpr AttackTables build_attack_tables() {
+    // the order of the historic next_left().next_above() chains
+    const int knight_steps[8][2] = {{1, -2}, {2, -1}, {-1, -2}, {-2, -1},
+                                    {1, 2},  {2, 1},  {-1, 2},  {-2, 1}};
+    const int king_steps[8][2] = {{0, -1}, {0, 1},  {1, 0},  {-1, 0},
+                                  {1, -1}, {-1, -1}, {1, 1}, {-1, 1}};
+
+    AttackTables tables = {};
+    for (int index = 0; index < 64; index++) {
+        int row = index / 8, col = index % 8;
+        tables.knights[index] = build_leaps(index, knight_steps);
+        tables.kings[index] = build_leaps(index, king_steps);
+        for (int side : {-1, 1}) {
+            if (col + side < 0 || col + side > 7) {
+                continue;
+            }
+            if (row < 7) {
+                tables.pawns[0][index] |= u_int64_t(1) << (index + 8 + side);
+            }
+            if (row > 0) {
+                tables.pawns[1][index] |= u_int64_t(1) << (index - 8 + side);
+            }
+        }
+        for (int other = 0; other < 64; other++) {
+            int rows = other / 8 - row, cols = other % 8 - col;
+            if (other != index && (rows == cols || rows == -cols)) {
+                tables.diagonals[index] |= u_int64_t(1) << other;
+            }
+        }
+    }
+    return tables;
+}
+
+inline constexpr AttackTables ATTACK_TABLES = build_attack_tables();
+
+/**
+ * @brief The Attacks class
+ *
+ * This class gives the squares attacked from a square (on the board) by
+ * each kind of piece, read from tables built at compile time. Masks have one
+ * bit per square index, a1 is bit 0.
+ */
+class Attacks {
+  public:
+    /**
+     * @brief squares attacked by a knight
+     *
+     * @param pos position of the knight
+     * @return const Leaps& - attacked squares
+     */
+    static constexpr const Leaps &knight(const Position &pos) {
+        return ATTACK_TABLES.knights[pos.index()];
+    }
+    /**
+     * @brief squares attacked by a king (castling aside)
+     *
+     * @param pos position of the king
+     * @return const Leaps& - attacked squares
+     */
+    static constexpr const Leaps &king(const Position &pos) {
+        return ATTACK_TABLES.kings[pos.index()];
+    }
+    /**
+     * @brief squares a pawn takes on, which are also the squares a pawn of
+     * the other color attacks this square from
+     *
+     * @param color color of the pawn
+     * @param pos position of the pawn
+     * @return u_int64_t - mask
+     */
+    static constexpr u_int64_t pawn(Color color, const Position &pos) {
+        return ATTACK_TABLES.pawns[color == Color::White ? 0 : 1][pos.index()];
+    }
+    /**
+     * @brief squares on the same diagonals, whatever stands on them
+     *
+     * @param pos position
+     * @return u_int64_t - mask
+     */
+    static constexpr u_int64_t diagonals(const Position &pos) {
+        return ATTACK_TABLES.diagonals[pos.index()];
+    }
+    /**
+     * @brief squares on the same col, whatever stands on them
+     *
+     * @param pos position
+     * @return u_int64_t - mask
+     */
+    static constexpr u_int64_t col(const Position &pos) {
+        return (u_int64_t(0x0101010101010101) << pos.col()) &
+               ~(u_int64_t(1) << pos.index());
+    }
+    /**
+     * @brief squares on the same row, whatever stands on them
+     *
+     * @param pos position
+     * @return u_int64_t - mask
+     */
+    static constexpr u_int64_t row(const Position &pos) {
+        return (u_int64_t(0xff) << (pos.row() * 8)) &
+               ~(u_int64_t(1) << pos.index());
+    }
+};
+
+static_assert(Attacks::knight(A1).mask == 0x0000000000020400,
+              "knight attacks from a1 should be b3 and c2");
+static_assert(Attacks::king(H8).count == 3, "a king in a corner has 3 moves");
+static_assert(Attacks::pawn(Color::White, E4) ==
+                  ((u_int64_t(1) << D5.index()) | (u_int64_t(1) << F5.index())),
+              "a white pawn on e4 takes on d5 and f5");
@@ -0,0 +1,58 @@
+#pragma once
+
+#include "lib.h"
+
+#include "board.h"
+#include "search.h"
+#include "tt.h"
+
+/**
+ * @brief The Bench class
+ *
+ * This class searches a fixed set of positions to a fixed depth on a single
+ * thread. The total number of nodes is a signature of the search and of the
+ * evaluation : it only changes when their behavior does, so any functional
+ * change has to update it on purpose. The nodes per second measure the speed
+ * of the host and of the build. The same positions can be searched by
+ * several threads, sharing the table (every thread searches the whole tree)
+ * or splitting the nodes (young brothers wait), to compare how both scale :
+ * the node count is no longer a signature then.
+ */
+class Bench {
+  public:
+    // depth of the bench searches (plies)
+    static const int DEPTH = 4;
+
+    static const int SharedHash = 0; // helper searches sharing the table
+    static const int Ybwc = 1;       // split points (young brothers wait)
+
+    /**
+     * @brief Construct a new Bench object
+     *
+     * @param depth depth of the searches (plies)
+     * @param threads threads per search
+     * @param smp how several threads search, SharedHash or Ybwc
+     */
+    Bench(int depth = DEPTH, unsigned threads = 1, int smp = SharedHash);
+    ~Bench();
+
+    /**
+     * @brief searches every position, each one with a cleared table
+     *
+     * @param os where one line per position and the totals are written
+     * @return u_int64_t - total number of nodes (the signature)
+     */
+    u_int64_t run(std::ostream &os);
+
+    /**
+     * @brief Get the positions of the bench
+     *
+     * @return const std::vector<std::string>& - FEN strings
+     */
+    static const std::vector<std::string> &positions();
+
+  private:
+    int depth;        // plies
+    unsigned threads; // threads per search
+    int smp;          // SharedHash or Ybwc
+};
@@ -2,96 +2,55 @@
 
 #include "lib.h"
 
+#include "history.h"
 #include "move.h"
 #include "position.h"
+#include "search.h"
 #include "square.h"
 
 /**
- * @brief The CastlingRights class
+ * @brief The UndoRecord struct
  *
- *This class represents the castling rights of a player.
+ * What a move changes that can not be found back from the board it leads to,
+ * enough for `Board::unmake_move` to take the move back.
  */
-class CastlingRights {
-  public:
-    /**
-     * @brief Construct a new Castling Rights object
-     *
-     */
-    CastlingRights();
-    ~CastlingRights();
-
-    /**
-     * @brief if castling is possible for king side
-     *
-     * @return true - if castling is possible
-     * @return false - otherwise
-     */
-    bool can_kingside_castle() const;
-    /**
-     * @brief if castling is possible for queen side
-     *
-     * @return true - if castling is possible
-     * @return false - otherwise
-     */
-    bool can_queenside_castle() const;
-
-    /**
-     * @brief disables castling rights for king side
-     *
-     */
-    void disable_kingside();
-    /**
-     * @brief disables castling rights for queen side
-     *
-     */
-    void disable_queenside();
-    /**
-     * @brief disables castling rights for both sides
-     *
-     */
-    void disable_all();
-
-    /**
-     * @brief enables castling rights for king side
-     *
-     */
-    void enable_kingside();
-    /**
-     * @brief enables castling rights for queen side
-     *
-     */
-    void enable_queenside();
-    /**
-     * @brief enables castling rights for both sides
-     *
-     */
-    void enable_all();
-
-  private:
-    bool kingside;
-    bool queenside;
+struct UndoRecord {
+    u_int64_t key;             // key before the move
+    Move move;                 // move played
+    u_int16_t halfmove_clock;  // clocks before the move
+    u_int16_t fullmove_number;
+    Color turn;                // side to move before the move
+    int8_t en_passant;         // en passant square before the move or -1
+    u_int8_t castling;         // castling rights before the move
+    u_int8_t moved;            // id of the piece moved, 0 for castling
+    u_int8_t captured;         // id of the piece taken (en passant too) or 0
+    u_int8_t promoted;         // id of the piece promoted to or 0
 };
 
 /**
  * @brief The board class
  *
- * This class represents the board of a chess game.
+ * This class represents the board of a chess game. Its whole state fits in
+ * 96 contiguous bytes without pointers or padding : boards are copied with a
+ * memcpy and their bytes are their binary snapshot.
  */
 class Board {
   public:
+    static const int WhiteKingside = 1; // castling rights bits
+    static const int WhiteQueenside = 2;
+    static const int BlackKingside = 4;
+    static const int BlackQueenside = 8;
+
+    static const int AllMoves = 0; // move generation types
+    static const int Captures = 1; // takes a piece (en passant included)
+    static const int Quiets = 2;   // onto an empty square, or castling
+    static const int Evasions = 3; // out of check (side to move in check)
+
     /**
      * @brief Construct a new Board object
      *
      */
     Board();
-    /**
-     * @brief Construct a new Board object
-     * needed since gnu++17 does not provide the wanted default constructor
-     *
-     * @param other other Board
-     */
-    Board(const Board &other);
-    ~Board();
 
     /**
      * @brief setup the board with default values
@@ -101,14 +60,25 @@ class Board {
     static Board new_board();
     /**
      * @brief setup the board with a starting fen string
+     * The six fields are checked in a single pass, the halfmove clock and the
+     * fullmove number may be left out together.
      *
      * @param fen starting fen
      * @return Board - new board
+     * @throw std::invalid_argument - naming the field that is wrong
      */
-    static Board from_fen(const std::string &fen);
-
-    CastlingRights *black_castling_rights; // black castling rights
-    CastlingRights *white_castling_rights; // white castling rights
+    static Board from_fen(std::string_view fen);
+    /**
+     * @brief setup the board with an EPD line : the four first fields of a
+     * fen, optionally the two counters, then operations (`bm`, `id`...)
+     *
+     * @param line EPD line
+     * @param operations where to put the operations, (optional)
+     * @return Board - new board
+     * @throw std::invalid_argument - naming the field that is wrong
+     */
+    static Board from_epd(std::string_view line,
+                          std::string_view *operations = nullptr);
 
     /**
      * @brief evaluates the board for a given color
@@ -132,31 +102,87 @@ class Board {
      * @return Board - new board
      */
     Board apply_eval_move(const Move &move, const bool &cpu = false);
+    /**
+     * @brief apply a valid move to the board as the cpu does, a pawn
+     * reaching the last row being promoted to the given piece
+     *
+     * @param move move to be applied
+     * @param promotion piece type a pawn is promoted to (Piece::Queen)
+     * @return Board - new board
+     */
+    Board apply_promotion(const Move &move, int promotion);
     /**
      * @brief Get the legal moves object as a vector
+     * Captures and quiets split the legal moves in two, evasions are only
+     * meant for a side in check (all moves are then generated as evasions).
+     * Moves come in the same order whatever the type.
      *
+     * @param type AllMoves, Captures, Quiets or Evasions, (optional)
      * @return std::vector<Move> - vector of legal moves
      */
-    std::vector<Move> get_legal_moves();
+    std::vector<Move> get_legal_moves(int type = AllMoves);
 
     /**
      * @brief Get the best move for the current player with `depth` number of
      * moves of lookahead.
      *
      * @param depth depth
+     * @param history keys of the positions played before this one
      * @return std::tuple<Move, u_int64_t, double> - best move, number of
      * nodes, evaluation value
      */
-    std::tuple<Move, u_int64_t, double> get_next_best_move(int depth);
+    std::tuple<Move, u_int64_t, double>
+    get_next_best_move(int depth, const History &history = History());
+    /**
+     * @brief Get the best move for the current player with `depth` number of
+     * moves of lookahead, sharing the given search context. If the context
+     * can be stopped, the search deepens iteratively and returns the best
+     * move found so far when stopped.
+     *
+     * @param depth depth
+     * @param context search context (history, table, stop flag)
+     * @return std::tuple<Move, u_int64_t, double> - best move, number of
+     * nodes, evaluation value
+     */
+    std::tuple<Move, u_int64_t, double>
+    get_next_best_move(int depth, SearchContext &context);
+    /**
+     * @brief Get the `count` best moves for the current player with exact
+     * values (multipv). Each pass searches the root moves not found yet with
+     * a window raised by the best of them, the table is shared by the passes
+     * and the lines found lead the next iteration. The lines also go to
+     * `context.stats.lines`, and the first one to `context.stats.pv`.
+     *
+     * @param depth depth
+     * @param count number of best moves wanted
+     * @param context search context (history, table, stop flag)
+     * @return std::vector<PvLine> - best moves, best first (at least one, a
+     * resign move if there is no legal move)
+     */
+    std::vector<PvLine> get_best_moves(int depth, unsigned count,
+                                       SearchContext &context);
     /**
      * @brief Get the worst move for the current player with `depth` number of
      * moves of lookahead.
      *
      * @param depth depth
+     * @param history keys of the positions played before this one
      * @return std::tuple<Move, u_int64_t, double> - worst move, number of
      * nodes, evaluation value
      */
-    std::tuple<Move, u_int64_t, double> get_next_worst_move(int depth);
+    std::tuple<Move, u_int64_t, double>
+    get_next_worst_move(int depth, const History &history = History());
+    /**
+     * @brief Get the worst move for the current player with `depth` number of
+     * moves of lookahead, sharing the given search context.
+     *
+     * @param depth depth
+     * @param context search context (history, table, stop flag)
+     * @return std::tuple<Move, u_int64_t, double> - worst move, number of
+     * nodes, evaluation value
+     */
+    std::tuple<Move, u_int64_t, double>
+    get_next_worst_move(int depth, SearchContext &context);
     /**
      * @brief Perform minimax on a certain position, and get the minimum or
      * maximum value for a board. To get the best move, you minimize the values
@@ -167,9 +193,67 @@ class Board {
      * make the best possible replies to your moves. Moves that are seemingly
      * good, but are easily countered, are categorically eliminated by this
      * algorithm.
+     *
+     * Positions repeated along the current line (or from the game history)
+     * and positions past the fifty-move rule are scored as draws. Results are
+     * shared through the transposition table of the context (if any), and the
+     * search unwinds as soon as the context is asked to stop. When the context
+     * belongs to a split search, the moves after the first one are searched
+     * in parallel (young brothers wait). Captures that lose material are
+     * searched first with less depth (see `search_move`), and the horizon
+     * is extended by a quiescence search.
      */
     double minimax(int depth, double alpha, double beta, bool is_maximizing,
-                   Color getting_move_for, u_int64_t *board_count);
+                   Color getting_move_for, SearchContext *context);
+    /**
+     * @brief searches the position after a move of this one with minimax.
+     * A losing capture (negative static exchange, as found when the moves
+     * were ordered) is searched a ply shallower first, and at its full depth
+     * only if it still gets inside the window.
+     *
+     * @param move legal move
+     * @param depth depth left at this position
+     * @param alpha lower bound
+     * @param beta upper bound
+     * @param is_maximizing if the player to move maximizes
+     * @param getting_move_for player the values are given for
+     * @param context search context
+     * @param losing if the move is a losing capture that may be reduced
+     * (never the first one)
+     * @return double - value of the move
+     */
+    double search_move(const Move &move, int depth, double alpha, double beta,
+                       bool is_maximizing, Color getting_move_for,
+                       SearchContext *context, bool losing);
+    /**
+     * @brief Quiescence search past the horizon of minimax : the player to
+     * move either stands pat on the evaluation or takes, captures that lose
+     * material (negative static exchange) being left out, until the position
+     * is quiet. A player in check does not stand pat but searches every
+     * evasion, and is mated when there is none. Its nodes are counted apart
+     * (`qnodes`).
+     *
+     * @param alpha lower bound
+     * @param beta upper bound
+     * @param is_maximizing if the player to move maximizes
+     * @param getting_move_for player the values are given for
+     * @param context search context
+     * @return double - value of the position
+     */
+    double quiesce(double alpha, double beta, bool is_maximizing,
+                   Color getting_move_for, SearchContext *context);
+    /**
+     * @brief Static exchange evaluation of a move : the material the player
+     * moving wins on the square it goes to, when both players take back
+     * there in turn with their least valuable attacker, each one free to
+     * stop when going on would lose. Sliders behind the pieces that take
+     * join in (x-rays), pawns taken en passant are counted, promotions are
+     * not.
+     *
+     * @param move legal move
+     * @return int - material won, negative if the move loses some
+     */
+    int see(const Move &move) const;
 
     /**
      * @brief Get the square object at a given position
@@ -344,6 +428,23 @@ class Board {
      */
     Board apply_move(const Move &move, const bool &cpu = false);
 
+    /**
+     * @brief Get the undo record of a move before it is played (the piece a
+     * pawn is promoted to is left for the caller, who knows it once played)
+     *
+     * @param move move about to be played
+     * @return UndoRecord - undo record
+     */
+    UndoRecord undo_record(const Move &move) const;
+    /**
+     * @brief takes back a piece move or a castling, whatever side is to move
+     * now : the board before the move of the record, bytes for bytes
+     *
+     * @param record undo record of the last move played on this board
+     * @return Board - previous board
+     */
+    Board unmake_move(const UndoRecord &record) const;
+
     /**
      * @brief plays a valid more on the board
      *
@@ -367,11 +468,41 @@ class Board {
      */
     double score();
     /**
-     * @brief returns the current board as a fen string
+     * @brief turns the rating bar of the board display on or off (the bar
+     * needs a few shallow searches per displayed position)
      *
-     * @return std::string - fen
+     * @param enabled if the rating bar is displayed
+     */
+    static void enable_rating(bool enabled);
+    /**
+     * @brief returns the pieces of every square, comma separated (the end
+     * position format of the subject, see `to_fen` for a real fen)
+     *
+     * @return std::string - squares
      */
     std::string end_fen() const;
+    /**
+     * @brief returns the six fields of the fen of the board (`from_fen` gives
+     * back the same board)
+     *
+     * @return std::string - fen
+     */
+    std::string to_fen() const;
+    /**
+     * @brief returns the bytes of the board, a binary snapshot that
+     * `from_snapshot` reads back on the same kind of machine
+     *
+     * @return std::string - sizeof(Board) bytes
+     */
+    std::string snapshot() const;
+    /**
+     * @brief setup the board from a binary snapshot
+     *
+     * @param bytes snapshot
+     * @return Board - board
+     * @throw std::invalid_argument - if the snapshot is not a valid board
+     */
+    static Board from_snapshot(std::string_view bytes);
     /**
      * @brief Get the turn color object
      *
@@ -381,9 +512,47 @@ class Board {
     /**
      * @brief Get the en passant object
      *
-     * @return Position* - position
+     * @return Position* - shared position, nullptr if none
      */
     Position *get_en_passant() const;
+    /**
+     * @brief Get the zobrist key of the position
+     *
+     * @return u_int64_t - key
+     */
+    u_int64_t get_key() const;
+    /**
+     * @brief computes the zobrist key of the position from scratch
+     *
+     * @return u_int64_t - key
+     */
+    u_int64_t compute_key() const;
+    /**
+     * @brief Get the number of plies since the last capture or pawn move
+     *
+     * @return unsigned - halfmove clock
+     */
+    unsigned get_halfmove_clock() const;
+    /**
+     * @brief Get the fullmove number (starts at 1, incremented after black)
+     *
+     * @return unsigned - fullmove number
+     */
+    unsigned get_fullmove_number() const;
+    /**
+     * @brief Get the castling rights of both players as a mask
+     * (see Zobrist::castling)
+     *
+     * @return int - castling rights mask
+     */
+    int get_castling_mask() const;
+    /**
+     * @brief if the game is drawn by the fifty-move rule
+     *
+     * @return true - if 100 plies were played without capture or pawn move
+     * @return false - otherwise
+     */
+    bool is_fifty_moves() const;
 
     /**
      * @brief removes all pieces from the board for a given color
@@ -437,13 +606,65 @@ class Board {
      */
     friend std::ostream &operator<<(std::ostream &os, Board &board);
 
+    friend class BoardBuilder;
+
   private:
-    Square squares[64];   // array of squares
-    Position *en_passant; // en passant position
-    Color turn;           // current turn color
+    /**
+     * @brief rates the board for both players, computed once per position
+     * and cached under its key (shared by `rating_bar` and `score`)
+     *
+     * @return std::pair<double, double> - current player and opponent values
+     */
+    std::pair<double, double> rating();
+    /**
+     * @brief reads a fen (or the fen part of an EPD line) in a single pass
+     *
+     * @param fen fen or EPD line
+     * @param epd if operations may follow the fields (and the counters are
+     * only read when they are numbers)
+     * @param operations where to put the operations, or nullptr
+     * @return Board - new board
+     */
+    static Board parse_fen(std::string_view fen, bool epd,
+                           std::string_view *operations);
 
-    unsigned short white_takes[7]; // black pieces count taken by white
-    unsigned short black_takes[7]; // white pieces count taken by black
+    /**
+     * @brief Get the piece on a square
+     *
+     * @param index index of the square, from a8 (0) to h1 (63)
+     * @return Piece* - shared piece, nullptr if empty
+     */
+    Piece *piece_at(int index) const;
+    /**
+     * @brief Get the pieces of the other color attacking a square
+     *
+     * @param pos position (on the board)
+     * @param ally_color ally color
+     * @param first if the search stops at the first attacker found
+     * @return u_int64_t - square indexes of the attackers (a1 is bit 0)
+     */
+    u_int64_t attackers(const Position &pos, const Color &ally_color,
+                        bool first) const;
+    /**
+     * @brief generates the legal moves of one type for one side, the
+     * color and the type being known at compile time
+     *
+     * @tparam Us color of the side to move
+     * @tparam Type AllMoves, Captures, Quiets or Evasions
+     * @param moves where to add the moves
+     */
+    template <Color Us, int Type> void generate_moves(std::vector<Move> &moves);
+
+    u_int64_t key;              // zobrist key of the position
+    u_int8_t squares[64];       // type | color of every piece, a8 to h1
+    u_int16_t halfmove_clock;   // plies since last capture or pawn move
+    u_int16_t fullmove_number;  // number of the current full move
+    Color turn;                 // current turn color
+    int8_t en_passant;          // en passant square (row * 8 + col) or -1
+    u_int8_t castling;          // castling rights bits
+    u_int8_t white_takes[7];    // black pieces count taken by white
+    u_int8_t black_takes[7];    // white pieces count taken by black
+    u_int8_t reserved[3];       // zero, the layout has no padding
 };
 
 /**
@@ -470,66 +691,66 @@ class BoardBuilder {
      * @brief places copies of a given piece on a row
      * 
      * @param piece piece
-     * @return BoardBuilder - board builder
+     * @return BoardBuilder& - board builder
      */
-    BoardBuilder row(const Piece &piece);
+    BoardBuilder &row(const Piece &piece);
     /**
      * @brief places copies of a given piece on a column
      * 
      * @param piece piece
-     * @return BoardBuilder - board builder
+     * @return BoardBuilder& - board builder
      */
-    BoardBuilder column(const Piece &piece);
+    BoardBuilder &column(const Piece &piece);
 
     /**
      * @brief adds a piece to the board by pointer
      * 
      * @param piece piece
-     * @return BoardBuilder - board builder
+     * @return BoardBuilder& - board builder
      */
-    BoardBuilder piece(Piece *piece);
+    BoardBuilder &piece(Piece *piece);
     /**
      * @brief enables castling rights
      * 
-     * @return BoardBuilder - board builder
+     * @return BoardBuilder& - board builder
      */
-    BoardBuilder enable_castling();
+    BoardBuilder &enable_castling();
     /**
      * @brief disables castling rights
      * 
-     * @return BoardBuilder - board builder
+     * @return BoardBuilder& - board builder
      */
-    BoardBuilder disable_castling();
+    BoardBuilder &disable_castling();
 
     /**
      * @brief enables queen side castling rights for a given color
      * 
      * @param color color
-     * @return BoardBuilder - board builder
+     * @return BoardBuilder& - board builder
      */
-    BoardBuilder enable_queenside_castle(const Color &color);
+    BoardBuilder &enable_queenside_castle(const Color &color);
     /**
      * @brief disables queen side castling rights for a given color
      * 
      * @param color color
-     * @return BoardBuilder - board builder
+     * @return BoardBuilder& - board builder
      */
-    BoardBuilder disable_queenside_castle(const Color &color);
+    BoardBuilder &disable_queenside_castle(const Color &color);
 
     /**
      * @brief enables king side castling rights for a given color
      * 
      * @param color color
-     * @return BoardBuilder - board builder
+     * @return BoardBuilder& - board builder
      */
-    BoardBuilder enable_kingside_castle(const Color &color);
+    BoardBuilder &enable_kingside_castle(const Color &color);
     /**
      * @brief disables king side castling rights for a given color
      * 
      * @param color color
-     * @return BoardBuilder - board builder
+     * @return BoardBuilder& - board builder
      */
-    BoardBuilder disable_kingside_castle(const Color &color);
+    BoardBuilder &disable_kingside_castle(const Color &color);
 
     /**
      * @brief returns the board once the builder is finished
@@ -539,5 +760,5 @@ class BoardBuilder {
     Board build() const;
 
   private:
-    Board *board; // board
+    Board board; // board being built
 };
@@ -0,0 +1,112 @@
+#pragma once
+
+#include "lib.h"
+
+#include "board.h"
+#include "history.h"
+#include "move.h"
+
+/**
+ * @brief The Game class
+ *
+ * This class represents the moves of a game from its starting board. Only
+ * the current board is kept, with a small undo record per move : taking a
+ * move back unmakes it, and any earlier board is found again by unmaking
+ * back to it or by replaying from the start. Moves taken back are kept
+ * until another move is played, so that the game can go forward again.
+ */
+class Game {
+  public:
+    /**
+     * @brief Construct a new Game object
+     *
+     * @param start starting board, (optional)
+     */
+    Game(const Board &start = Board::new_board());
+    ~Game();
+
+    /**
+     * @brief starts the game over from a board, forgetting every move
+     *
+     * @param start starting board
+     */
+    void reset(const Board &start);
+
+    const Board &board() const;  // accessor
+    Board &board();              // mutator
+    const Board &start() const;  // accessor
+    const History &keys() const; // accessor
+
+    /**
+     * @brief Get the number of moves played up to the current board
+     *
+     * @return std::size_t - plies
+     */
+    std::size_t ply() const;
+    /**
+     * @brief Get the number of moves known, the ones taken back included
+     *
+     * @return std::size_t - plies
+     */
+    std::size_t length() const;
+    /**
+     * @brief Get a move known
+     *
+     * @param ply 0 for the first move (less than `length()`)
+     * @return const Move& - move
+     */
+    const Move &move(std::size_t ply) const;
+
+    /**
+     * @brief plays a legal move (promotions are to a queen), the moves
+     * taken back are forgotten
+     *
+     * @param move move
+     */
+    void play(const Move &move);
+    /**
+     * @brief records a legal move played on the current board, the moves
+     * taken back are forgotten
+     *
+     * @param move move
+     * @param next board the move led to (after the turn changed)
+     */
+    void play(const Move &move, const Board &next);
+    /**
+     * @brief takes the last move played back (it is kept, see `jump`)
+     *
+     * @return true - if there was a move to take back
+     * @return false - otherwise
+     */
+    bool pop();
+    /**
+     * @brief goes to the board after `ply` moves, back by unmaking moves or
+     * forward by replaying the moves taken back
+     *
+     * @param ply number of moves (at most `length()`)
+     */
+    void jump(std::size_t ply);
+    /**
+     * @brief replays the first moves from the starting board
+     *
+     * @param ply number of moves to replay (at most `length()`)
+     * @return Board - board after these moves
+     */
+    Board replay(std::size_t ply) const;
+
+  private:
+    /**
+     * @brief plays a recorded move again, with its promotion
+     *
+     * @param board board the move was played on
+     * @param record record of the move
+     * @return Board - board after the move
+     */
+    static Board redo(const Board &board, const UndoRecord &record);
+
+    Board start_;                     // starting board
+    Board board_;                     // current board
+    std::vector<UndoRecord> records_; // one per move, taken back or not
+    std::size_t ply_;                 // moves played up to board_
+    History keys_;                    // keys of the boards before board_
+};
@@ -0,0 +1,79 @@
+#pragma once
+
+#include "lib.h"
+
+/**
+ * @brief The History class
+ *
+ * This class represents a stack of position keys, from the start of the game
+ * down to the position being searched. It is shared between the game loop
+ * (positions actually played) and the search (positions along the current
+ * line) so that repetitions can be detected in both. A stack may be laid on
+ * top of another one, read only, so that the threads of a parallel search
+ * share the keys down to the node they split instead of copying them.
+ */
+class History {
+  public:
+    /**
+     * @brief Construct a new empty History object
+     *
+     */
+    History();
+    /**
+     * @brief Construct a new empty History object on top of another one,
+     * whose keys come below its own and must not change while it lives
+     *
+     * @param base keys below the first pushed one
+     */
+    History(const History *base);
+    ~History();
+
+    /**
+     * @brief pushes the key of a position that has been left
+     *
+     * @param key position key
+     */
+    void push(u_int64_t key);
+    /**
+     * @brief removes the last pushed key (if any, the base is left alone)
+     *
+     */
+    void pop();
+    /**
+     * @brief number of keys on the stack, the base included
+     *
+     * @return std::size_t - size
+     */
+    std::size_t size() const;
+    /**
+     * @brief removes all pushed keys (the base is left alone)
+     *
+     */
+    void clear();
+
+    /**
+     * @brief if the position with the given key has already been reached at
+     * least `times` times. Only the last `halfmove_clock` plies are scanned
+     * since no position before an irreversible move can ever repeat.
+     *
+     * @param key key of the current position
+     * @param halfmove_clock plies since the last capture or pawn move
+     * @param times number of earlier occurrences needed
+     * @return true - if the position is repeated
+     * @return false - otherwise
+     */
+    bool repeated(u_int64_t key, unsigned halfmove_clock,
+                  unsigned times = 1) const;
+
+  private:
+    /**
+     * @brief Get a key counting from the top of the stack
+     *
+     * @param back 1 for the last key, up to `size()` for the first one
+     * @return u_int64_t - key
+     */
+    u_int64_t key_back(std::size_t back) const;
+
+    std::vector<u_int64_t> keys; // keys of the previous positions
+    const History *base;         // keys below the first one, or nullptr
+};
@@ -1,23 +1,31 @@
 #pragma once
 
 #include <algorithm>
+#include <atomic>
+#include <bit>
 #include <cassert>
 #include <cctype>
 #include <cerrno>
 #include <chrono>
+#include <cmath>
+#include <condition_variable>
 #include <csignal>
 #include <cstring>
+#include <fstream>
 #include <iostream>
 #include <map>
+#include <mutex>
 #include <sstream>
 #include <stdexcept>
 #include <string>
+#include <string_view>
 #include <thread>
 #include <tuple>
 #include <utility>
 #include <vector>
 
 #include <getopt.h>
+#include <poll.h>
 #include <unistd.h>
 
 #define __AUTHOR__ "ThomasByr"
@@ -86,7 +94,7 @@ class Rook;
  *
  * This class represents the color of a player/piece.
  */
-enum class Color { White, Black };
+enum class Color : u_int8_t { White, Black };
 
 /**
  * @brief The State class
@@ -158,14 +166,32 @@ std::string repeat(std::string str, const unsigned n);
 std::string operator*(std::string str, unsigned n);
 
 /**
- * @brief launches a thread to handle input
- * so that the main thread can continue
+ * @brief displays a prompt and reads a line, lines typed while the program
+ * was busy come first
  *
  * @param str place to store input
  * @param prompt prompt to display
  */
 void input(std::string &str, const std::string &prompt);
 
+/**
+ * @brief reads a line typed while the program is busy, waiting at most
+ * `timeout` milliseconds for it
+ *
+ * @param str place to store input
+ * @param timeout time to wait in ms
+ * @return true - if a line was read
+ * @return false - otherwise
+ */
+bool poll_input(std::string &str, int timeout);
+
+/**
+ * @brief gives back a line to be returned by the next call to `input`
+ *
+ * @param str line
+ */
+void unread_input(const std::string &str);
+
 /**
  * @brief removes whitespace from the beginning and end of a string
  *
@@ -190,4 +216,5 @@ std::string to_lower(const std::string &s);
  */
 std::string time_to_string(const int64_t &time);
 
-extern State state;
+// phase of the calling thread, reported on a segmentation fault
+extern thread_local State state;
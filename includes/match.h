@@ -0,0 +1,186 @@
+#pragma once
+
+#include "lib.h"
+
+#include "board.h"
+#include "history.h"
+#include "search.h"
+#include "tt.h"
+
+/**
+ * @brief The EngineConfig class
+ *
+ * This class represents one side of a match : how long it searches each move
+ * and how large its transposition table is.
+ */
+class EngineConfig {
+  public:
+    /**
+     * @brief Construct a new Engine Config object
+     *
+     * @param limits limits of every search
+     * @param megabytes size of the transposition table
+     */
+    EngineConfig(const SearchLimits &limits = SearchLimits(),
+                 std::size_t megabytes = 4);
+    ~EngineConfig();
+
+    /**
+     * @brief reads a configuration such as `nodes=20000,hash=8`, keys are
+     * `depth` (plies), `nodes`, `movetime` (ms) and `hash` (MB), the missing
+     * ones keep the values of `base`. Throws std::invalid_argument if the
+     * string can not be read.
+     *
+     * @param spec configuration string
+     * @param base default configuration
+     * @return EngineConfig - configuration
+     */
+    static EngineConfig from_string(const std::string &spec,
+                                    const EngineConfig &base);
+
+    SearchLimits limits;   // limits of every search
+    std::size_t megabytes; // size of the transposition table
+};
+
+/**
+ * @brief The MatchStats class
+ *
+ * This class counts the results of a match from the point of view of the
+ * first engine, and turns them into an Elo difference and a sequential
+ * probability ratio test.
+ */
+class MatchStats {
+  public:
+    static const int H0 = -1;      // no better than elo0, stop
+    static const int Continue = 0; // play more games
+    static const int H1 = 1;       // at least elo1 better, stop
+
+    MatchStats();
+    ~MatchStats();
+
+    /**
+     * @brief Get the number of games
+     *
+     * @return unsigned - wins + draws + losses
+     */
+    unsigned games() const;
+    /**
+     * @brief Get the mean score per game
+     *
+     * @return double - between 0 and 1
+     */
+    double score() const;
+    /**
+     * @brief Get the Elo difference
+     *
+     * @return double - Elo (0 if all games were won or lost)
+     */
+    double elo() const;
+    /**
+     * @brief Get the half width of the 95% confidence interval of `elo`
+     *
+     * @return double - Elo
+     */
+    double elo_error() const;
+    /**
+     * @brief Get the log likelihood ratio of H1 (elo1) against H0 (elo0),
+     * with the normal approximation of the game scores
+     *
+     * @param elo0 Elo difference of H0
+     * @param elo1 Elo difference of H1
+     * @return double - log likelihood ratio
+     */
+    double llr(double elo0, double elo1) const;
+    /**
+     * @brief Get the verdict of the test
+     *
+     * @param elo0 Elo difference of H0
+     * @param elo1 Elo difference of H1
+     * @param alpha false positive rate
+     * @param beta false negative rate
+     * @return int - H0, Continue or H1
+     */
+    int sprt(double elo0, double elo1, double alpha = 0.05,
+             double beta = 0.05) const;
+
+    /**
+     * @brief writes the results, the Elo and the test verdict
+     *
+     * @param os output stream
+     * @param elo0 Elo difference of H0
+     * @param elo1 Elo difference of H1
+     */
+    void report(std::ostream &os, double elo0, double elo1) const;
+
+    unsigned wins;   // games won by the first engine
+    unsigned draws;  // drawn games
+    unsigned losses; // games lost by the first engine
+};
+
+/**
+ * @brief The Match class
+ *
+ * This class plays games between two engine configurations, several at a
+ * time. Openings are read from an EPD (or FEN) file, each one is played twice
+ * with colors swapped. Every worker thread owns one transposition table per
+ * engine, cleared before each game. New games stop being started as soon as
+ * the sequential probability ratio test is conclusive.
+ */
+class Match {
+  public:
+    // games longer than this are adjudicated as draws
+    static const unsigned MAX_PLIES = 400;
+
+    /**
+     * @brief Construct a new Match object
+     *
+     * @param first first engine
+     * @param second second engine
+     * @param threads number of games played at a time
+     */
+    Match(const EngineConfig &first, const EngineConfig &second,
+          unsigned threads);
+    ~Match();
+
+    /**
+     * @brief bounds of the sequential probability ratio test (0 and 5 by
+     * default)
+     *
+     * @param elo0 Elo difference of H0
+     * @param elo1 Elo difference of H1
+     */
+    void sprt(double elo0, double elo1);
+
+    /**
+     * @brief plays the match, panics if the openings can not be read
+     *
+     * @param filename path of the openings file
+     * @param games number of games, 0 to play each opening twice
+     * @param log where one line per game is written (optional)
+     * @return MatchStats - results
+     */
+    MatchStats run(const std::string &filename, unsigned games,
+                   std::ostream *log = nullptr);
+
+    /**
+     * @brief plays one game
+     *
+     * @param opening starting position
+     * @param white engine playing white
+     * @param black engine playing black
+     * @param white_tt table of the white engine
+     * @param black_tt table of the black engine
+     * @param reason set to why the game ended
+     * @return double - score of white (1, 0.5 or 0)
+     */
+    static double play(const Board &opening, const EngineConfig &white,
+                       const EngineConfig &black, TranspositionTable &white_tt,
+                       TranspositionTable &black_tt, std::string &reason);
+
+  private:
+    EngineConfig first;  // first engine
+    EngineConfig second; // second engine
+    unsigned threads;    // games at a time
+    double elo0;         // Elo of H0
+    double elo1;         // Elo of H1
+};
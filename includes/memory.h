@@ -0,0 +1,58 @@
+#pragma once
+
+#include "lib.h"
+
+/**
+ * @brief The LargeMemory class
+ *
+ * This class allocates the large arrays of the search (transposition tables)
+ * on huge pages when the system gives them, so that probes scattered over
+ * gigabytes do not miss the TLB at every access. Explicit huge pages
+ * (`MAP_HUGETLB`) are tried first, then a mapping aligned on a huge page
+ * with `madvise(MADV_HUGEPAGE)` for transparent huge pages, then small
+ * pages, and an aligned heap block as a last resort. The memory is always
+ * zeroed, and pages are only faulted in on first use unless prefaulted.
+ */
+class LargeMemory {
+  public:
+    static const int HugeTlb = 0;     // explicit huge pages
+    static const int Transparent = 1; // transparent huge pages (madvise)
+    static const int SmallPages = 2;  // anonymous mapping, small pages
+    static const int Heap = 3;        // aligned heap block
+
+    // size of a huge page (x86-64 and aarch64 with 4 KiB pages)
+    static const std::size_t HUGE_PAGE = 2 * 1024 * 1024;
+
+    /**
+     * @brief allocates zeroed memory, on huge pages if possible
+     *
+     * @param bytes size of the block
+     * @param mode set to the kind of memory obtained
+     * @return void* - block, aligned on a cache line at least
+     */
+    static void *allocate(std::size_t bytes, int &mode);
+    /**
+     * @brief frees a block from `allocate`
+     *
+     * @param block block (nullptr is ignored)
+     * @param bytes size given to `allocate`
+     * @param mode kind of memory `allocate` obtained
+     */
+    static void release(void *block, std::size_t bytes, int mode);
+    /**
+     * @brief touches every page of a block so that no page fault is left
+     * for later, the content is unchanged (other threads may be writing)
+     *
+     * @param block block
+     * @param bytes size of the block
+     */
+    static void prefault(void *block, std::size_t bytes);
+
+    /**
+     * @brief Get the name of a kind of memory
+     *
+     * @param mode HugeTlb, Transparent, SmallPages or Heap
+     * @return const char* - name
+     */
+    static const char *name(int mode);
+};
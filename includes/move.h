@@ -44,6 +44,31 @@ class Move {
      */
     int update_from_string(const std::string &move_string);
 
+    /**
+     * @brief packs the move into 15 bits (type, from and to squares)
+     * so that it can be stored in a hash entry
+     *
+     * @return u_int16_t - packed move
+     */
+    u_int16_t pack() const;
+    /**
+     * @brief rebuilds a move packed by Move::pack
+     *
+     * @param packed packed move
+     * @return Move - move
+     */
+    static Move unpack(u_int16_t packed);
+
+    /**
+     * @brief if two moves are the same (same type and squares)
+     *
+     * @param other other move
+     * @return true - if equal
+     * @return false - otherwise
+     */
+    bool operator==(const Move &other) const;
+    bool operator!=(const Move &other) const;
+
     /**
      * @brief fmt a move
      *
@@ -0,0 +1,57 @@
+#pragma once
+
+#include "lib.h"
+
+#include "board.h"
+#include "move.h"
+
+/**
+ * @brief The Notation class
+ *
+ * This class reads moves written in standard algebraic notation (Nf3, exd5,
+ * Rad1, e8=Q+, O-O) or long algebraic notation (g1f3, e2-e4, Ng1xf3, e7e8q,
+ * e1g1) and resolves them against the legal moves of a board. Reading does
+ * not allocate : the text is scanned once into a small description which is
+ * then matched against the legal moves.
+ */
+class Notation {
+  public:
+    static const int Ok = 0;
+    static const int Unreadable = 1;
+    static const int Illegal = 2;
+    static const int Ambiguous = 3;
+
+    /**
+     * @brief reads a move, with the piece a pawn is promoted to (a queen
+     * when none is written, see `Board::apply_promotion`)
+     *
+     * @param board board the move is played on
+     * @param str move in SAN or LAN
+     * @param move filled with the legal move on success
+     * @param promotion set to the promotion piece type, (optional)
+     * @return int - Ok, Unreadable, Illegal or Ambiguous
+     */
+    static int parse(Board &board, std::string_view str, Move &move,
+                     int *promotion = nullptr);
+    /**
+     * @brief reads a move against already generated legal moves
+     *
+     * @param board board the move is played on
+     * @param str move in SAN or LAN
+     * @param legal_moves legal moves of `board`
+     * @param move filled with the legal move on success
+     * @param promotion set to the promotion piece type, (optional)
+     * @return int - Ok, Unreadable, Illegal or Ambiguous
+     */
+    static int parse(Board &board, std::string_view str,
+                     const std::vector<Move> &legal_moves, Move &move,
+                     int *promotion = nullptr);
+
+    /**
+     * @brief Get a description of a parse result
+     *
+     * @param result result of `parse`
+     * @return const char* - description
+     */
+    static const char *error(int result);
+};
@@ -0,0 +1,81 @@
+#pragma once
+
+#include "lib.h"
+
+/**
+ * @brief The PgnGame class
+ *
+ * This class represents one game of a PGN file. Tags and moves are views
+ * into the file, they stay valid as long as the reader that produced them.
+ */
+class PgnGame {
+  public:
+    PgnGame();
+    ~PgnGame();
+
+    /**
+     * @brief forgets the game but keeps the allocated memory
+     *
+     */
+    void clear();
+    /**
+     * @brief Get the value of a tag
+     *
+     * @param name tag name
+     * @return std::string_view - value, or empty if the tag is missing
+     */
+    std::string_view tag(std::string_view name) const;
+
+    std::vector<std::pair<std::string_view, std::string_view>> tags; // tags
+    std::vector<std::string_view> moves; // mainline moves (SAN)
+    std::string_view result;             // game termination marker
+};
+
+/**
+ * @brief The PgnReader class
+ *
+ * This class reads the games of a PGN file one by one. The file is mapped in
+ * memory and tokenized in place : comments, variations and annotations are
+ * skipped, nothing is copied, so arbitrarily large databases are read with
+ * the memory of a single game.
+ */
+class PgnReader {
+  public:
+    /**
+     * @brief Construct a new Pgn Reader object, panics if the file can not
+     * be mapped
+     *
+     * @param filename path of the PGN file
+     */
+    PgnReader(const std::string &filename);
+    ~PgnReader();
+
+    PgnReader(const PgnReader &) = delete;
+    PgnReader &operator=(const PgnReader &) = delete;
+
+    /**
+     * @brief reads the next game
+     *
+     * @param game filled with the game (cleared first)
+     * @return true - if a game was read
+     * @return false - at the end of the file
+     */
+    bool next(PgnGame &game);
+    /**
+     * @brief size of the file
+     *
+     * @return std::size_t - bytes
+     */
+    std::size_t size() const;
+
+  private:
+    /**
+     * @brief skips blanks, comments, NAGs, variations and escaped lines
+     *
+     */
+    void skip();
+
+    const char *data;   // mapped file
+    std::size_t length; // size of the file
+    std::size_t offset; // read position
+};
@@ -49,21 +49,24 @@ class Piece {
     Piece(Color color, Position position, bool starting_piece = false);
     virtual ~Piece();
     /**
-     * @brief create a new piece given a type, a color and a position
+     * @brief Get the piece of a type and a color at a position
+     * Pieces never change once built, so there is a single instance of each
+     * one, shared by every board and never freed : boards do not own them.
      *
      * @param type type of the piece
      * @param color color of the piece
      * @param pos position, (optional)
-     * @return Piece* - new Piece
+     * @return Piece* - shared piece
      */
     static Piece *from_id(int type, Color color, const Position pos = A1);
-
     /**
-     * @brief duplicate a piece
+     * @brief Get the shared piece of an id on a square (what boards store)
      *
-     * @return Piece* - new Piece
+     * @param id type | color, 0 for none
+     * @param index index of the square, from a8 (0) to h1 (63)
+     * @return Piece* - shared piece, nullptr if id is not a piece
      */
-    virtual Piece *clone() const = 0;
+    static Piece *from_square(int id, int index);
 
     /**
      * @brief Get the color object
@@ -85,16 +88,13 @@ class Piece {
      * @return int - type
      */
     int get_type() const;
-
     /**
-     * @brief returns a collection of all legal moves given all pseudo legal
-     * moves
+     * @brief get the type and the color of the piece
+     * Same as type | White or type | Black
      *
-     * @param result pseudo legal moves
-     * @param board board
-     * @return std::vector<Move> - legal moves
+     * @return int - id
      */
-    std::vector<Move> get_valid_moves(std::vector<Move> &result, Board &board);
+    int get_id() const;
 
     /**
      * @brief gets the name of the piece as a lowercase string
@@ -156,13 +156,6 @@ class Piece {
      */
     virtual bool is_kingside_rook() const = 0;
 
-    /**
-     * @brief returns a collection of all legal moves
-     *
-     * @param board board
-     * @return std::vector<Move> -  legal moves
-     */
-    virtual std::vector<Move> get_legal_moves(Board &board) = 0;
     /**
      * @brief if the move is legal
      * 
@@ -186,7 +179,7 @@ class Piece {
      * @brief moves a piece to an other position (assuming it is legal)
      * 
      * @param new_pos new position
-     * @return Piece* - new piece
+     * @return Piece* - shared piece at the new position
      */
     virtual Piece *move_to(Position new_pos) const = 0;
 
@@ -224,8 +217,6 @@ class Pawn : public Piece {
     Pawn(Color color, Position position, bool starting_piece = false);
     ~Pawn();
 
-    Pawn *clone() const;
-
     Pawn *move_to(Position new_pos) const;
 
     std::string get_name() const;
@@ -237,7 +228,6 @@ class Pawn : public Piece {
     bool is_queenside_rook() const;
     bool is_kingside_rook() const;
 
-    std::vector<Move> get_legal_moves(Board &board);
     bool is_legal_move(const Position &new_pos, Board &board);
     bool is_legal_attack(const Position &new_pos, Board &board);
 
@@ -250,8 +240,6 @@ class King : public Piece {
     King(Color color, Position position, bool starting_piece = false);
     ~King();
 
-    King *clone() const;
-
     King *move_to(Position new_pos) const;
 
     std::string get_name() const;
@@ -263,7 +251,6 @@ class King : public Piece {
     bool is_queenside_rook() const;
     bool is_kingside_rook() const;
 
-    std::vector<Move> get_legal_moves(Board &board);
     bool is_legal_move(const Position &new_pos, Board &board);
     bool is_legal_attack(const Position &new_pos, Board &board);
 
@@ -276,8 +263,6 @@ class Queen : public Piece {
     Queen(Color color, Position position, bool starting_piece = false);
     ~Queen();
 
-    Queen *clone() const;
-
     Queen *move_to(Position new_pos) const;
 
     std::string get_name() const;
@@ -289,7 +274,6 @@ class Queen : public Piece {
     bool is_queenside_rook() const;
     bool is_kingside_rook() const;
 
-    std::vector<Move> get_legal_moves(Board &board);
     bool is_legal_move(const Position &new_pos, Board &board);
     bool is_legal_attack(const Position &new_pos, Board &board);
 
@@ -302,8 +286,6 @@ class Knight : public Piece {
     Knight(Color color, Position position, bool starting_piece = false);
     ~Knight();
 
-    Knight *clone() const;
-
     Knight *move_to(Position new_pos) const;
 
     std::string get_name() const;
@@ -315,7 +297,6 @@ class Knight : public Piece {
     bool is_queenside_rook() const;
     bool is_kingside_rook() const;
 
-    std::vector<Move> get_legal_moves(Board &board);
     bool is_legal_move(const Position &new_pos, Board &board);
     bool is_legal_attack(const Position &new_pos, Board &board);
 
@@ -328,8 +309,6 @@ class Bishop : public Piece {
     Bishop(Color color, Position position, bool starting_piece = false);
     ~Bishop();
 
-    Bishop *clone() const;
-
     Bishop *move_to(Position new_pos) const;
 
     std::string get_name() const;
@@ -341,7 +320,6 @@ class Bishop : public Piece {
     bool is_queenside_rook() const;
     bool is_kingside_rook() const;
 
-    std::vector<Move> get_legal_moves(Board &board);
     bool is_legal_move(const Position &new_pos, Board &board);
     bool is_legal_attack(const Position &new_pos, Board &board);
 
@@ -354,8 +332,6 @@ class Rook : public Piece {
     Rook(Color color, Position position, bool starting_piece = false);
     ~Rook();
 
-    Rook *clone() const;
-
     Rook *move_to(Position new_pos) const;
 
     std::string get_name() const;
@@ -367,7 +343,6 @@ class Rook : public Piece {
     bool is_queenside_rook() const;
     bool is_kingside_rook() const;
 
-    std::vector<Move> get_legal_moves(Board &board);
     bool is_legal_move(const Position &new_pos, Board &board);
     bool is_legal_attack(const Position &new_pos, Board &board);
 
@@ -0,0 +1,102 @@
+#pragma once
+
+#include "lib.h"
+
+#include "board.h"
+#include "history.h"
+#include "move.h"
+#include "search.h"
+#include "tt.h"
+
+/**
+ * @brief The Ponder class
+ *
+ * This class runs a background search on the position the opponent is
+ * expected to leave us with, while the opponent (human or cpu) is thinking.
+ * If the expected reply is played, the search goes on and its result is used
+ * as the cpu move. Otherwise it is aborted, but everything it stored in the
+ * transposition table is kept.
+ */
+class Ponder {
+  public:
+    /**
+     * @brief Construct a new Ponder object
+     *
+     * @param tt transposition table shared with the main search
+     * @param depth depth of the ponder search
+     */
+    Ponder(TranspositionTable *tt, int depth);
+    ~Ponder();
+
+    Ponder(const Ponder &) = delete;
+    Ponder &operator=(const Ponder &) = delete;
+
+    /**
+     * @brief starts pondering, guessing the opponent reply from the
+     * transposition table
+     *
+     * @param board position where the opponent is to move
+     * @param keys keys of the positions played before `board`
+     * @return true - if a background search was started
+     * @return false - if no reply could be guessed or already pondering
+     */
+    bool start(Board &board, const History &keys);
+    /**
+     * @brief aborts the background search unless the game is still on the
+     * pondered line (waiting for the expected reply, or just after it)
+     *
+     * @param board current board
+     */
+    void update(const Board &board);
+    /**
+     * @brief aborts the background search (if any) and waits for it
+     *
+     */
+    void stop();
+
+    /**
+     * @brief if a background search is running (or done but not collected)
+     *
+     * @return true - if running
+     * @return false - otherwise
+     */
+    bool is_running() const;
+    /**
+     * @brief if the background search is about this very position
+     *
+     * @param board board
+     * @return true - if the result can be used for this board
+     * @return false - otherwise
+     */
+    bool is_pondering(const Board &board) const;
+    /**
+     * @brief Get the expected reply
+     *
+     * @return const Move& - move (invalid if not pondering)
+     */
+    const Move &expected_move() const;
+
+    /**
+     * @brief waits for the background search to finish and returns its
+     * result (only meaningful if `is_pondering` for the current board)
+     *
+     * @return std::tuple<Move, u_int64_t, double> - best move, number of
+     * nodes, evaluation value
+     */
+    std::tuple<Move, u_int64_t, double> result();
+    /**
+     * @brief Get the background search (to wait for it or stop it)
+     *
+     * @return SearchThread& - search
+     */
+    SearchThread &search_thread();
+
+  private:
+    TranspositionTable *tt; // shared transposition table
+    int depth;              // depth of the ponder search
+
+    SearchThread search;     // background search
+    Move expected;           // expected opponent reply
+    u_int64_t waiting_key;   // key of the position before the reply
+    u_int64_t pondering_key; // key of the position after the reply
+};
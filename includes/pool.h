@@ -0,0 +1,165 @@
+#pragma once
+
+#include "lib.h"
+
+#include <deque>
+#include <functional>
+#include <memory>
+
+/**
+ * @brief The ThreadPool class
+ *
+ * This class keeps worker threads alive for the whole process, so that
+ * searches, batch analysis and self-play never pay for creating a thread.
+ * Idle workers park on a condition variable until a job is submitted. When
+ * they are all busy (a search waiting for its helpers, for instance), an
+ * overflow worker is started and kept, up to `OVERFLOW_FACTOR` times the
+ * size asked for with `start` : past that, jobs wait in a queue for a free
+ * worker, and waiting for a job that has not started yet runs it on the
+ * waiting thread, so that a job waiting for another one never waits for a
+ * worker. Workers, overflow ones included, can be pinned to the cores the
+ * process may run on, one core each in turn.
+ */
+class ThreadPool {
+  public:
+    /**
+     * @brief The Task class
+     *
+     * This class lets the submitter of a job wait for its end.
+     */
+    class Task {
+      public:
+        Task();
+        ~Task();
+
+        /**
+         * @brief if a job was submitted and not waited for yet
+         *
+         * @return true - if there is a job
+         * @return false - otherwise
+         */
+        bool valid() const;
+        /**
+         * @brief if the job is over (false if there is no job)
+         *
+         * @return true - if over
+         * @return false - otherwise
+         */
+        bool finished() const;
+        /**
+         * @brief waits for the end of the job (if any), then forgets it. A
+         * job still in the queue is taken out and run by the caller
+         *
+         */
+        void wait();
+
+      private:
+        friend class ThreadPool;
+        class State;                  // done flag of one job
+        std::shared_ptr<State> state; // shared with the worker
+        ThreadPool *pool = nullptr;   // pool the job was submitted to
+    };
+
+    // workers there can be, as a multiple of the size asked for
+    static const unsigned OVERFLOW_FACTOR = 4;
+
+    /**
+     * @brief Construct a new Thread Pool object, without workers yet
+     *
+     */
+    ThreadPool();
+    ~ThreadPool();
+
+    ThreadPool(const ThreadPool &) = delete;
+    ThreadPool &operator=(const ThreadPool &) = delete;
+
+    /**
+     * @brief Get the pool of the process. It is never destroyed : its
+     * workers end with the process, and an exit while a job still runs (a
+     * second Ctrl-C during a search) does not wait for the job
+     *
+     * @return ThreadPool& - pool
+     */
+    static ThreadPool &global();
+
+    /**
+     * @brief starts workers until there are `threads` of them, pinned to a
+     * core each if `affinity` (workers started later are pinned as well),
+     * and allows up to `OVERFLOW_FACTOR` times as many
+     *
+     * @param threads number of workers
+     * @param affinity if pinning workers
+     */
+    void start(unsigned threads, bool affinity = false);
+    /**
+     * @brief runs a job on a parked worker, on an overflow worker started
+     * for it if none is idle, or once a worker is free if there are already
+     * as many workers as allowed
+     *
+     * @param job job
+     * @return Task - to wait for the job
+     */
+    Task submit(std::function<void()> job);
+
+    /**
+     * @brief Get the number of workers
+     *
+     * @return unsigned - workers, busy or parked
+     */
+    unsigned size() const;
+    /**
+     * @brief Get the number of workers there can be
+     *
+     * @return unsigned - workers
+     */
+    unsigned limit() const;
+    /**
+     * @brief if workers are pinned to cores
+     *
+     * @return true - if pinned
+     * @return false - otherwise
+     */
+    bool pinned() const;
+
+  private:
+    /**
+     * @brief The Job class
+     *
+     * A submitted job and the state its task waits on.
+     */
+    class Job {
+      public:
+        std::function<void()> run;          // job
+        std::shared_ptr<Task::State> state; // done flag
+    };
+
+    /**
+     * @brief starts one more worker (idle), the lock being held
+     *
+     */
+    void spawn();
+    /**
+     * @brief takes a job out of the queue if no worker started it yet
+     *
+     * @param state state of the job
+     * @param job set to the job
+     * @return true - if it was still queued
+     * @return false - otherwise
+     */
+    bool claim(const std::shared_ptr<Task::State> &state,
+               std::function<void()> &job);
+    /**
+     * @brief waits for jobs and runs them until the pool is destroyed
+     *
+     */
+    void work();
+
+    mutable std::mutex mutex;         // guards everything below
+    std::condition_variable wake;     // a job arrived or the pool ends
+    std::vector<std::thread> workers; // started workers
+    std::deque<Job> jobs;             // submitted, not started yet
+    std::vector<int> cores;           // cores to pin workers to
+    unsigned idle;                    // workers not running a job
+    unsigned wanted;                  // size asked for with `start`
+    bool stopping;                    // if the pool is being destroyed
+};
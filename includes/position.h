@@ -5,29 +5,44 @@
 /**
  * @brief The Position class
  *
- * This class represents a position of a piece in the game.
+ * This class represents a position of a piece in the game. It is a one byte
+ * square index (a1 is 0, h8 is 63), every position off the board is the same
+ * index 64. Geometry between two squares is read from tables computed at
+ * compile time.
  */
 class Position {
   public:
     /**
-     * @brief Construct a new Position object
+     * @brief Construct a new Position object (off the board)
      *
      */
-    Position();
+    constexpr Position() : square_(OFF_BOARD) {}
     /**
      * @brief Construct a new Position object
      *
-     * @param row row number 0..=7
-     * @param col col number 0..=7
+     * @param row row number 0..=7 (anything else is off the board)
+     * @param col col number 0..=7 (anything else is off the board)
      */
-    Position(int row, int col);
+    constexpr Position(int row, int col)
+        : square_(row >= 0 && row < 8 && col >= 0 && col < 8
+                      ? u_int8_t(row * 8 + col)
+                      : OFF_BOARD) {}
     /**
      * @brief Construct a new Position object
      *
      * @param position_string string representing a position
      */
     Position(const std::string &position_string);
-    ~Position();
+
+    /**
+     * @brief makes the position of a square index
+     *
+     * @param index 0..=63 (a1 to h8)
+     * @return Position - position
+     */
+    static constexpr Position from_index(int index) {
+        return Position(index / 8, index % 8);
+    }
 
     /**
      * @brief returns the position of the king when the game starts
@@ -50,31 +65,33 @@ class Position {
      * @return true - on board
      * @return false - otherwise
      */
-    bool is_on_board() const;
+    constexpr bool is_on_board() const { return square_ != OFF_BOARD; }
     /**
      * @brief if a position is off the board
      *
      * @return true - off board
      * @return false - otherwise
      */
-    bool is_off_board() const;
+    constexpr bool is_off_board() const { return square_ == OFF_BOARD; }
 
+    /**
+     * @brief returns the square index
+     *
+     * @return int - 0..=63, 64 if off the board
+     */
+    constexpr int index() const { return square_; }
     /**
      * @brief returns the row number
      *
-     * @return int - 0..=7
+     * @return int - 0..=7, -1 if off the board
      */
-    const int &row() const;
-    int &row();
-    void row(const int &row);
+    constexpr int row() const { return is_on_board() ? square_ / 8 : -1; }
     /**
      * @brief returns the col number
      *
-     * @return int  - 0..=7
+     * @return int  - 0..=7, -1 if off the board
      */
-    const int &col() const;
-    int &col();
-    void col(const int &col);
+    constexpr int col() const { return is_on_board() ? square_ % 8 : -1; }
 
     /**
      * @brief makes a new position with the same col but a new row
@@ -233,21 +250,13 @@ class Position {
     bool is_queenside_rook() const;
 
     /**
-     * @brief gets a collection of positions that are diagonal to the current
-     * position and heading towards the other position
-     *
-     * @param to other position
-     * @return std::vector<Position> - positions
-     */
-    std::vector<Position> diagonals_to(const Position &to) const;
-    /**
-     * @brief gets a collection of positions that are orthogonal to the current
-     * position and heading towards the other position
+     * @brief gets the squares strictly between two positions on the same
+     * row, col or diagonal
      *
      * @param to other position
-     * @return std::vector<Position> - positions
+     * @return u_int64_t - one bit per square index, 0 if not on a line
      */
-    std::vector<Position> orthogonals_to(const Position &to) const;
+    u_int64_t squares_between(const Position &to) const;
 
     /**
      * @brief if two positions represents a knight move
@@ -274,82 +283,87 @@ class Position {
      * @return true - equal
      * @return false - otherwise
      */
-    bool operator==(const Position &other) const;
-    bool operator!=(const Position &other) const;
+    constexpr bool operator==(const Position &other) const {
+        return square_ == other.square_;
+    }
+    constexpr bool operator!=(const Position &other) const {
+        return square_ != other.square_;
+    }
 
   private:
-    int row_; // 0-7 (0 is the white bottom row)
-    int col_; // 0-7 (0 is the white left column)
+    static const u_int8_t OFF_BOARD = 64;
+
+    u_int8_t square_; // row * 8 + col (row 0 is the white bottom row)
 };
 
-const Position A1 = Position(0, 0);
-const Position A2 = Position(1, 0);
-const Position A3 = Position(2, 0);
-const Position A4 = Position(3, 0);
-const Position A5 = Position(4, 0);
-const Position A6 = Position(5, 0);
-const Position A7 = Position(6, 0);
-const Position A8 = Position(7, 0);
+inline constexpr Position A1 = Position(0, 0);
+inline constexpr Position A2 = Position(1, 0);
+inline constexpr Position A3 = Position(2, 0);
+inline constexpr Position A4 = Position(3, 0);
+inline constexpr Position A5 = Position(4, 0);
+inline constexpr Position A6 = Position(5, 0);
+inline constexpr Position A7 = Position(6, 0);
+inline constexpr Position A8 = Position(7, 0);
 
-const Position B1 = Position(0, 1);
-const Position B2 = Position(1, 1);
-const Position B3 = Position(2, 1);
-const Position B4 = Position(3, 1);
-const Position B5 = Position(4, 1);
-const Position B6 = Position(5, 1);
-const Position B7 = Position(6, 1);
-const Position B8 = Position(7, 1);
+inline constexpr Position B1 = Position(0, 1);
+inline constexpr Position B2 = Position(1, 1);
+inline constexpr Position B3 = Position(2, 1);
+inline constexpr Position B4 = Position(3, 1);
+inline constexpr Position B5 = Position(4, 1);
+inline constexpr Position B6 = Position(5, 1);
+inline constexpr Position B7 = Position(6, 1);
+inline constexpr Position B8 = Position(7, 1);
 
-const Position C1 = Position(0, 2);
-const Position C2 = Position(1, 2);
-const Position C3 = Position(2, 2);
-const Position C4 = Position(3, 2);
-const Position C5 = Position(4, 2);
-const Position C6 = Position(5, 2);
-const Position C7 = Position(6, 2);
-const Position C8 = Position(7, 2);
+inline constexpr Position C1 = Position(0, 2);
+inline constexpr Position C2 = Position(1, 2);
+inline constexpr Position C3 = Position(2, 2);
+inline constexpr Position C4 = Position(3, 2);
+inline constexpr Position C5 = Position(4, 2);
+inline constexpr Position C6 = Position(5, 2);
+inline constexpr Position C7 = Position(6, 2);
+inline constexpr Position C8 = Position(7, 2);
 
-const Position D1 = Position(0, 3);
-const Position D2 = Position(1, 3);
-const Position D3 = Position(2, 3);
-const Position D4 = Position(3, 3);
-const Position D5 = Position(4, 3);
-const Position D6 = Position(5, 3);
-const Position D7 = Position(6, 3);
-const Position D8 = Position(7, 3);
+inline constexpr Position D1 = Position(0, 3);
+inline constexpr Position D2 = Position(1, 3);
+inline constexpr Position D3 = Position(2, 3);
+inline constexpr Position D4 = Position(3, 3);
+inline constexpr Position D5 = Position(4, 3);
+inline constexpr Position D6 = Position(5, 3);
+inline constexpr Position D7 = Position(6, 3);
+inline constexpr Position D8 = Position(7, 3);
 
-const Position E1 = Position(0, 4);
-const Position E2 = Position(1, 4);
-const Position E3 = Position(2, 4);
-const Position E4 = Position(3, 4);
-const Position E5 = Position(4, 4);
-const Position E6 = Position(5, 4);
-const Position E7 = Position(6, 4);
-const Position E8 = Position(7, 4);
+inline constexpr Position E1 = Position(0, 4);
+inline constexpr Position E2 = Position(1, 4);
+inline constexpr Position E3 = Position(2, 4);
+inline constexpr Position E4 = Position(3, 4);
+inline constexpr Position E5 = Position(4, 4);
+inline constexpr Position E6 = Position(5, 4);
+inline constexpr Position E7 = Position(6, 4);
+inline constexpr Position E8 = Position(7, 4);
 
-const Position F1 = Position(0, 5);
-const Position F2 = Position(1, 5);
-const Position F3 = Position(2, 5);
-const Position F4 = Position(3, 5);
-const Position F5 = Position(4, 5);
-const Position F6 = Position(5, 5);
-const Position F7 = Position(6, 5);
-const Position F8 = Position(7, 5);
+inline constexpr Position F1 = Position(0, 5);
+inline constexpr Position F2 = Position(1, 5);
+inline constexpr Position F3 = Position(2, 5);
+inline constexpr Position F4 = Position(3, 5);
+inline constexpr Position F5 = Position(4, 5);
+inline constexpr Position F6 = Position(5, 5);
+inline constexpr Position F7 = Position(6, 5);
+inline constexpr Position F8 = Position(7, 5);
 
-const Position G1 = Position(0, 6);
-const Position G2 = Position(1, 6);
-const Position G3 = Position(2, 6);
-const Position G4 = Position(3, 6);
-const Position G5 = Position(4, 6);
-const Position G6 = Position(5, 6);
-const Position G7 = Position(6, 6);
-const Position G8 = Position(7, 6);
+inline constexpr Position G1 = Position(0, 6);
+inline constexpr Position G2 = Position(1, 6);
+inline constexpr Position G3 = Position(2, 6);
+inline constexpr Position G4 = Position(3, 6);
+inline constexpr Position G5 = Position(4, 6);
+inline constexpr Position G6 = Position(5, 6);
+inline constexpr Position G7 = Position(6, 6);
+inline constexpr Position G8 = Position(7, 6);
 
-const Position H1 = Position(0, 7);
-const Position H2 = Position(1, 7);
-const Position H3 = Position(2, 7);
-const Position H4 = Position(3, 7);
-const Position H5 = Position(4, 7);
-const Position H6 = Position(5, 7);
-const Position H7 = Position(6, 7);
-const Position H8 = Position(7, 7);
+inline constexpr Position H1 = Position(0, 7);
+inline constexpr Position H2 = Position(1, 7);
+inline constexpr Position H3 = Position(2, 7);
+inline constexpr Position H4 = Position(3, 7);
+inline constexpr Position H5 = Position(4, 7);
+inline constexpr Position H6 = Position(5, 7);
+inline constexpr Position H7 = Position(6, 7);
+inline constexpr Position H8 = Position(7, 7);
@@ -0,0 +1,132 @@
+#pragma once
+
+#include "lib.h"
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#endif
+
+/**
+ * @brief The Profile class
+ *
+ * This class counts the calls and the cycles spent in the phases of the hot
+ * path (move generation, legality checks, moves applied, sorting and
+ * evaluation). Counters are kept per thread and merged when a thread ends, so
+ * that searches never share a cache line. Timings are inclusive : move
+ * generation contains the legality checks it makes, which contain moves
+ * applied.
+ *
+ * Nothing is compiled unless the build defines PROFILE (`make profile`),
+ * profiling then starts with `--profile` and is reported at exit.
+ */
+class Profile {
+  public:
+    static const int MoveGen = 0;
+    static const int Legality = 1;
+    static const int Apply = 2;
+    static const int Sorting = 3;
+    static const int Eval = 4;
+    static const int PHASES = 5;
+
+    /**
+     * @brief turns counting on or off
+     *
+     * @param enabled if counting
+     */
+    static void enable(bool enabled);
+    /**
+     * @brief if counting
+     *
+     * @return true - if counting
+     * @return false - otherwise
+     */
+    static bool enabled();
+    /**
+     * @brief if the counters are compiled in
+     *
+     * @return true - if built with PROFILE
+     * @return false - otherwise
+     */
+    static bool available();
+
+    /**
+     * @brief counts one call of a phase on the calling thread
+     *
+     * @param phase phase
+     * @param cycles cycles spent in the call
+     */
+    static void add(int phase, u_int64_t cycles);
+    /**
+     * @brief adds the counters of the calling thread to the totals
+     *
+     */
+    static void flush();
+    /**
+     * @brief writes the totals, which include the counters of the threads
+     * that ended (and of the main thread once `exit` has begun)
+     *
+     * @param os output stream
+     */
+    static void report(std::ostream &os);
+
+    /**
+     * @brief Get the name of a phase
+     *
+     * @param phase phase
+     * @return const char* - name
+     */
+    static const char *name(int phase);
+
+    /**
+     * @brief reads the cycle counter (or a nanosecond clock)
+     *
+     * @return u_int64_t - cycles
+     */
+    static inline u_int64_t cycles() {
+#if defined(__x86_64__) || defined(__i386__)
+        return __rdtsc();
+#else
+        return u_int64_t(std::chrono::duration_cast<std::chrono::nanoseconds>(
+                             std::chrono::steady_clock::now()
+                                 .time_since_epoch())
+                             .count());
+#endif
+    }
+};
+
+/**
+ * @brief The ProfileScope class
+ *
+ * This class counts the cycles from its construction to its destruction in a
+ * phase, when profiling is on.
+ */
+class ProfileScope {
+  public:
+    /**
+     * @brief Construct a new Profile Scope object
+     *
+     * @param phase phase
+     */
+    ProfileScope(int phase) {
+        this->phase = phase;
+        this->start = Profile::enabled() ? Profile::cycles() : 0;
+    }
+    ~ProfileScope() {
+        if (start != 0) {
+            Profile::add(phase, Profile::cycles() - start);
+        }
+    }
+
+    ProfileScope(const ProfileScope &) = delete;
+    ProfileScope &operator=(const ProfileScope &) = delete;
+
+  private:
+    int phase;       // phase
+    u_int64_t start; // cycles at construction, 0 if not counting
+};
+
+#ifdef PROFILE
+#define profile_scope(phase) ProfileScope _profile_scope(phase);
+#else
+#define profile_scope(phase)
+#endif
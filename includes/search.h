@@ -0,0 +1,314 @@
+#pragma once
+
+#include "lib.h"
+
+#include "history.h"
+#include "move.h"
+#include "pool.h"
+#include "tt.h"
+
+class SplitPoint;
+class SplitSearch;
+
+/**
+ * @brief The SearchLimits class
+ *
+ * This class represents when a search should end : after a number of
+ * iterations, of nodes or of milliseconds (whichever comes first), and how
+ * many threads split its nodes.
+ */
+class SearchLimits {
+  public:
+    /**
+     * @brief Construct a new Search Limits object
+     *
+     * @param depth depth of the search (0 is one ply)
+     */
+    SearchLimits(int depth = 4);
+    ~SearchLimits();
+
+    int depth;               // depth of the last iteration
+    u_int64_t nodes;         // node budget, 0 for none
+    int64_t movetime;        // time budget in ms, 0 for none
+    unsigned multipv;        // best moves given an exact score (1 or more)
+    unsigned threads;        // threads splitting the nodes (young brothers)
+    std::vector<Move> moves; // root moves to search, all of them if empty
+};
+
+/**
+ * @brief The IterationStats struct
+ *
+ * Depth, nodes and time of one completed iteration.
+ */
+struct IterationStats {
+    int plies;       // depth of the iteration
+    u_int64_t nodes; // nodes searched by the iteration
+    int64_t ms;      // time spent in the iteration
+};
+
+/**
+ * @brief The PvLine struct
+ *
+ * One of the best root moves of a multipv search, with its exact value and
+ * the variation it starts.
+ */
+struct PvLine {
+    Move move;            // root move
+    double value;         // value for the player to move
+    std::vector<Move> pv; // variation, starting with `move`
+};
+
+/**
+ * @brief The SearchStats class
+ *
+ * This class gathers the numbers of one search : nodes, cutoffs, table hits,
+ * split points of a parallel search, the nodes and time of every completed
+ * iteration and the principal variation of the last one.
+ */
+class SearchStats {
+  public:
+    SearchStats();
+    ~SearchStats();
+
+    /**
+     * @brief Get the total number of nodes
+     *
+     * @return u_int64_t - main search and quiescence nodes
+     */
+    u_int64_t total_nodes() const;
+    /**
+     * @brief Get the effective branching factor : the growth in nodes of the
+     * last iteration over the previous one (or the n-th root of the nodes of
+     * a single iteration of n plies)
+     *
+     * @return double - branching factor, 0 if no iteration completed
+     */
+    double branching_factor() const;
+    /**
+     * @brief Get the share of beta cutoffs made by the first move searched
+     *
+     * @return double - percentage, 0 if there was no cutoff
+     */
+    double first_move_cutoff_rate() const;
+    /**
+     * @brief Get the share of table probes that found the position
+     *
+     * @return double - percentage, 0 if there was no probe
+     */
+    double hash_hit_rate() const;
+    /**
+     * @brief Get the share of the younger brothers of split points that were
+     * searched by another thread than the one that split
+     *
+     * @return double - percentage, 0 if nothing was split
+     */
+    double steal_rate() const;
+
+    /**
+     * @brief adds the counters of another search of the same position (a
+     * helper thread, or the children of a split point), iterations and
+     * principal variation are kept
+     *
+     * @param other statistics to add
+     */
+    void merge(const SearchStats &other);
+
+    u_int64_t nodes;              // main search nodes
+    u_int64_t qnodes;             // quiescence nodes
+    u_int64_t cutoffs;            // beta cutoffs
+    u_int64_t first_move_cutoffs; // beta cutoffs by the first move
+    u_int64_t hash_probes;        // table lookups
+    u_int64_t hash_hits;          // table lookups that found the position
+    u_int64_t splits;             // nodes split between threads
+    u_int64_t tasks;              // younger brothers of the split points
+    u_int64_t steals;             // younger brothers taken by another thread
+    u_int64_t aborted;            // younger brothers cancelled by a cutoff
+
+    std::vector<IterationStats> iterations; // completed iterations
+    std::vector<Move> pv;                   // principal variation
+    std::vector<PvLine> lines;              // best moves of a multipv search
+
+    /**
+     * @brief writes the statistics on a few lines (verbose output), the
+     * principal variation is left to the caller who knows the position
+     *
+     * @param os output stream
+     * @param stats statistics
+     * @return std::ostream& - output stream
+     */
+    friend std::ostream &operator<<(std::ostream &os,
+                                    const SearchStats &stats);
+};
+
+/**
+ * @brief The SearchContext class
+ *
+ * This class holds what is shared by all the nodes of one search : the node
+ * counter, the keys of the positions on the current line, the transposition
+ * table and the flag another thread sets to abort the search. In a parallel
+ * search, every thread searches a subtree with a context of its own.
+ */
+class SearchContext {
+  public:
+    /**
+     * @brief Construct a new Search Context object
+     *
+     * @param history keys of the positions played before the root
+     * @param tt transposition table, (optional)
+     * @param stop flag to abort the search, (optional)
+     */
+    SearchContext(const History &history = History(),
+                  TranspositionTable *tt = nullptr,
+                  const std::atomic<bool> *stop = nullptr);
+    /**
+     * @brief Construct the context of a younger brother of a split point :
+     * the table, stop flag, budgets and parallel search of the thread that
+     * split, the keys down to the split node (shared, read only) and empty
+     * statistics
+     *
+     * @param parent split point
+     * @param worker worker of the thread searching the brother
+     */
+    SearchContext(const SplitPoint *parent, unsigned worker);
+    ~SearchContext();
+
+    /**
+     * @brief if the search has been asked to stop (or the split point above
+     * it was cut off). The flag is only polled every few nodes, but once it
+     * has been seen every following call returns true. In a parallel search
+     * the node budget is checked against the nodes of every thread.
+     *
+     * @return true - if the search should unwind now
+     * @return false - otherwise
+     */
+    bool should_stop();
+    /**
+     * @brief applies node and time budgets (the clock starts now) and the
+     * root moves to search
+     *
+     * @param limits limits of the search
+     */
+    void limit(const SearchLimits &limits);
+    /**
+     * @brief if the search may end before its last iteration (stop flag or
+     * budget), in which case it deepens iteratively
+     *
+     * @return true - if it can be cut short
+     * @return false - otherwise
+     */
+    bool can_stop() const;
+
+    SearchStats stats;             // nodes visited and other counters
+    int depth;                     // last completed iteration or -1
+    History history;               // keys of the line being searched
+    TranspositionTable *tt;        // shared table or nullptr
+    const std::atomic<bool> *stop; // abort request or nullptr
+    bool stopped;                  // if the abort request has been seen
+    SplitSearch *split;            // parallel search or nullptr
+    const SplitPoint *parent;      // split point above the subtree or nullptr
+    unsigned worker;               // worker of the thread (parallel search)
+    u_int64_t reported;            // nodes added to the parallel search count
+    std::vector<Move> root_moves;  // moves searched at the root, all if empty
+
+  private:
+    u_int64_t max_nodes; // node budget, 0 for none
+    int64_t deadline;    // end of the time budget (steady clock ms) or 0
+};
+
+/**
+ * @brief The SearchThread class
+ *
+ * This class runs one search on a worker of the thread pool (see
+ * ThreadPool::global). The search can be asked to
+ * stop at any time (from another thread or a signal handler), it then returns
+ * the best move found so far within a few hundred nodes.
+ */
+class SearchThread {
+  public:
+    /**
+     * @brief Construct a new Search Thread object
+     *
+     * @param tt transposition table used by the searches
+     */
+    SearchThread(TranspositionTable *tt);
+    ~SearchThread();
+
+    SearchThread(const SearchThread &) = delete;
+    SearchThread &operator=(const SearchThread &) = delete;
+
+    /**
+     * @brief starts a search in the background (waits for the previous one)
+     *
+     * @param board position to search
+     * @param history keys of the positions played before `board`
+     * @param depth depth of the search
+     * @param best if looking for the best move (or the worst one)
+     */
+    void start(const Board &board, const History &history, int depth,
+               bool best = true);
+    /**
+     * @brief starts a search in the background (waits for the previous one)
+     *
+     * @param board position to search
+     * @param history keys of the positions played before `board`
+     * @param limits when the search should end
+     * @param best if looking for the best move (or the worst one)
+     */
+    void start(const Board &board, const History &history,
+               const SearchLimits &limits, bool best = true);
+    /**
+     * @brief asks the running search to stop, does not wait
+     *
+     */
+    void stop();
+    /**
+     * @brief waits for the search to finish and returns its result
+     *
+     * @return std::tuple<Move, u_int64_t, double> - best move, number of
+     * nodes, evaluation value
+     */
+    std::tuple<Move, u_int64_t, double> wait();
+
+    /**
+     * @brief if a search was started and not collected by `wait` yet
+     *
+     * @return true - if started
+     * @return false - otherwise
+     */
+    bool is_running() const;
+    /**
+     * @brief if the search has finished (its result is ready)
+     *
+     * @return true - if finished
+     * @return false - otherwise
+     */
+    bool is_done() const;
+    /**
+     * @brief Get the statistics of the search (once done)
+     *
+     * @return const SearchStats& - statistics
+     */
+    const SearchStats &stats() const;
+    /**
+     * @brief Get the depth of the last completed iteration (once done)
+     *
+     * @return int - depth, or -1 if stopped during the first one
+     */
+    int depth() const;
+    /**
+     * @brief Get the stop flag (to be set from a signal handler)
+     *
+     * @return std::atomic<bool>* - flag
+     */
+    std::atomic<bool> *stop_flag();
+
+  private:
+    TranspositionTable *tt;  // transposition table
+    ThreadPool::Task task;   // job running the search
+    std::atomic<bool> abort; // stop request
+    std::atomic<bool> done;  // if the search is over
+
+    std::tuple<Move, u_int64_t, double> outcome; // result of the search
+    SearchStats statistics;                      // counters of the search
+    int reached;                                 // completed iterations
+};
@@ -0,0 +1,331 @@
+#pragma once
+
+#include "lib.h"
+
+#include "board.h"
+#include "move.h"
+#include "pool.h"
+#include "search.h"
+
+/**
+ * @brief The WorkDeque class
+ *
+ * This class is the work-stealing deque of Chase and Lev (with the memory
+ * orderings of Lê et al.) on a fixed ring : its owner pushes and pops at the
+ * bottom without a lock, other threads steal from the top, and a compare and
+ * swap on the top settles the race for the last element.
+ *
+ * @tparam T element, copied in and out of an atomic (a pointer)
+ */
+template <class T> class WorkDeque {
+  public:
+    // elements the ring can hold
+    static const int64_t CAPACITY = 4096;
+
+    WorkDeque() : top(0), bottom(0) {}
+    ~WorkDeque() {}
+
+    WorkDeque(const WorkDeque &) = delete;
+    WorkDeque &operator=(const WorkDeque &) = delete;
+
+    /**
+     * @brief pushes an element at the bottom (owner only)
+     *
+     * @param item element
+     * @return true - if pushed
+     * @return false - if the ring is full
+     */
+    bool push(T item) {
+        int64_t b = bottom.load(std::memory_order_relaxed);
+        int64_t t = top.load(std::memory_order_acquire);
+        if (b - t >= CAPACITY) {
+            return false;
+        }
+        ring[b % CAPACITY].store(item, std::memory_order_relaxed);
+        bottom.store(b + 1, std::memory_order_release); // publishes the item
+        return true;
+    }
+    /**
+     * @brief pops the last pushed element (owner only)
+     *
+     * @param item set to the element
+     * @return true - if an element was popped
+     * @return false - if the deque was empty (or its last element stolen)
+     */
+    bool pop(T &item) {
+        int64_t b = bottom.load(std::memory_order_relaxed) - 1;
+        bottom.store(b, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        int64_t t = top.load(std::memory_order_relaxed);
+        if (t > b) {
+            bottom.store(b + 1, std::memory_order_relaxed);
+            return false;
+        } // empty
+
+        item = ring[b % CAPACITY].load(std::memory_order_relaxed);
+        if (t < b) {
+            return true;
+        } // more than one element : no thief can reach this one
+
+        bool won = top.compare_exchange_strong(t, t + 1,
+                                               std::memory_order_seq_cst,
+                                               std::memory_order_relaxed);
+        bottom.store(b + 1, std::memory_order_relaxed);
+        return won;
+    }
+    /**
+     * @brief steals the oldest element (any thread), if `wanted` accepts it
+     *
+     * @param item set to the element
+     * @param wanted predicate on the element, checked before taking it
+     * @return true - if an element was stolen
+     * @return false - if empty, refused, or lost to another thread
+     */
+    template <class Predicate> bool steal(T &item, Predicate wanted) {
+        int64_t t = top.load(std::memory_order_acquire);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        int64_t b = bottom.load(std::memory_order_acquire);
+        if (t >= b) {
+            return false;
+        }
+        T candidate = ring[t % CAPACITY].load(std::memory_order_relaxed);
+        if (!wanted(candidate)) {
+            return false;
+        }
+        if (!top.compare_exchange_strong(t, t + 1, std::memory_order_seq_cst,
+                                         std::memory_order_relaxed)) {
+            return false;
+        }
+        item = candidate;
+        return true;
+    }
+    /**
+     * @brief if the deque looks empty (a hint, it may change at once)
+     *
+     * @return true - if empty
+     * @return false - otherwise
+     */
+    bool empty() const {
+        return top.load(std::memory_order_relaxed) >=
+               bottom.load(std::memory_order_relaxed);
+    }
+
+  private:
+    std::atomic<int64_t> top;      // next element to steal
+    std::atomic<int64_t> bottom;   // next free slot of the owner
+    std::atomic<T> ring[CAPACITY]; // elements, indexed modulo CAPACITY
+};
+
+class SplitPoint;
+
+/**
+ * @brief The SplitTask struct
+ *
+ * One younger brother of a split point : the move to search from it.
+ */
+struct SplitTask {
+    SplitPoint *split; // split point the move belongs to
+    Move move;         // move to search
+    bool losing;       // capture losing material (from the ordering)
+};
+
+/**
+ * @brief The SplitPoint class
+ *
+ * This class is a node whose eldest child has been searched and whose other
+ * children are searched in parallel (young brothers wait). Its window is
+ * narrowed as children finish, and a beta cutoff cancels the children that
+ * are still waiting or running, and everything below them. Split points
+ * live in the slots of their worker for the whole search, so that a thief
+ * may look at a task it then fails to take.
+ */
+class SplitPoint {
+  public:
+    // most moves a node can have
+    static const std::size_t MAX_MOVES = 256;
+
+    SplitPoint();
+    ~SplitPoint();
+
+    SplitPoint(const SplitPoint &) = delete;
+    SplitPoint &operator=(const SplitPoint &) = delete;
+
+    /**
+     * @brief prepares the split point for a node, without tasks yet
+     *
+     * @param board position of the node
+     * @param depth depth left at the node
+     * @param alpha lower bound after the eldest child
+     * @param beta upper bound after the eldest child
+     * @param is_maximizing if the player to move maximizes
+     * @param getting_move_for player the values are given for
+     * @param owner context of the thread that split (history of the node)
+     */
+    void reset(const Board &board, int depth, double alpha, double beta,
+               bool is_maximizing, Color getting_move_for,
+               const SearchContext *owner);
+
+    /**
+     * @brief if the node or one of the split points above it was cut off
+     *
+     * @return true - if its children can stop
+     * @return false - otherwise
+     */
+    bool cancelled() const;
+    /**
+     * @brief if the node is a split point or lies below it
+     *
+     * @param ancestor split point
+     * @return true - if below (or the same)
+     * @return false - otherwise
+     */
+    bool descends_from(const SplitPoint *ancestor) const;
+
+    Board board;                // position of the node
+    int depth;                  // depth left at the node
+    bool is_maximizing;         // if the player to move maximizes
+    Color getting_move_for;     // player the values are given for
+    const SearchContext *owner; // context of the thread that split
+    unsigned worker;            // worker of the thread that split
+
+    // split point above the node while this one is searched, or nullptr
+    std::atomic<const SplitPoint *> parent;
+
+    std::mutex mutex;              // guards the window, result and stats
+    std::condition_variable over;  // the last child finished
+    double alpha;                  // window, narrowed as children finish
+    double beta;                   // window, narrowed as children finish
+    double best_value;             // best value of the younger brothers
+    Move best_move;                // move of `best_value`
+    bool interrupted;              // a child was stopped from outside
+    SearchStats stats;             // counters of the finished children
+    std::atomic<unsigned> pending; // children not finished yet
+    std::atomic<bool> cutoff;      // a child failed high : cancel the rest
+
+    SplitTask tasks[MAX_MOVES]; // younger brothers, pointing to this node
+    std::size_t count;          // number of younger brothers
+};
+
+/**
+ * @brief The SplitSearch class
+ *
+ * This class lets the nodes of one search split between several threads.
+ * The thread that starts the search is worker 0, the other workers run on
+ * the thread pool for as long as the object lives. Every worker has a
+ * work-stealing deque : a worker that splits pushes the younger brothers on
+ * its own deque and searches them itself from the bottom, idle workers steal
+ * them from the top, and a worker waiting for its split point to finish
+ * only steals work from below that split point (helpful master), so that it
+ * is never held up by an unrelated subtree.
+ */
+class SplitSearch {
+  public:
+    // minimal depth left at a node for its children to be split
+    static const int MIN_DEPTH = 2;
+    // split points a worker can wait on at the same time
+    static const unsigned MAX_SPLITS = 16;
+
+    /**
+     * @brief Construct a new Split Search object, helpers start looking for
+     * work at once
+     *
+     * @param threads number of workers, the calling thread included
+     */
+    SplitSearch(unsigned threads);
+    ~SplitSearch();
+
+    SplitSearch(const SplitSearch &) = delete;
+    SplitSearch &operator=(const SplitSearch &) = delete;
+
+    /**
+     * @brief attaches a context to the search as worker 0 (the thread that
+     * runs the root)
+     *
+     * @param context root context
+     */
+    void attach(SearchContext &context);
+    /**
+     * @brief Get the number of workers
+     *
+     * @return unsigned - workers, the calling thread included
+     */
+    unsigned threads() const;
+    /**
+     * @brief adds nodes searched by one worker to the count of the whole
+     * search (the node budget is checked against it)
+     *
+     * @param nodes nodes not counted yet
+     * @return u_int64_t - nodes searched by every worker so far
+     */
+    u_int64_t spend(u_int64_t nodes);
+
+    /**
+     * @brief searches the younger brothers of a node (every move but the
+     * first one, already searched) in parallel, and returns when each one is
+     * done or cancelled
+     *
+     * @param board position of the node
+     * @param moves sorted legal moves of the node
+     * @param order ordering values of the moves, negative for the captures
+     * that lose material
+     * @param depth depth left at the node
+     * @param alpha lower bound, narrowed
+     * @param beta upper bound, narrowed
+     * @param is_maximizing if the player to move maximizes
+     * @param getting_move_for player the values are given for
+     * @param best_value best value so far, updated
+     * @param best_move best move so far, updated
+     * @param context context of the calling thread
+     * @return true - if the node was split
+     * @return false - if the worker has no split point left (nothing done)
+     */
+    bool split(const Board &board, const std::vector<Move> &moves,
+               const std::vector<int> &order, int depth, double &alpha,
+               double &beta, bool is_maximizing, Color getting_move_for,
+               double &best_value, Move &best_move, SearchContext *context);
+
+  private:
+    /**
+     * @brief The Worker class
+     *
+     * The deque and the split points of one worker.
+     */
+    class Worker {
+      public:
+        WorkDeque<SplitTask *> deque;  // younger brothers to search
+        SplitPoint points[MAX_SPLITS]; // split points, innermost last
+        unsigned used = 0;             // split points being waited on
+    };
+
+    /**
+     * @brief searches one younger brother and reports to its split point
+     *
+     * @param task task
+     * @param worker worker running it
+     */
+    void run(SplitTask *task, unsigned worker);
+    /**
+     * @brief steals a task from another worker
+     *
+     * @param worker thief
+     * @param below only tasks below this split point (nullptr for any)
+     * @param task set to the stolen task
+     * @return true - if a task was stolen
+     * @return false - otherwise
+     */
+    bool steal(unsigned worker, const SplitPoint *below, SplitTask *&task);
+    /**
+     * @brief steals and runs tasks until the search ends (helpers)
+     *
+     * @param worker worker
+     */
+    void help(unsigned worker);
+
+    std::vector<std::unique_ptr<Worker>> workers; // one per thread
+    std::vector<ThreadPool::Task> helpers;        // workers 1 and up (pool)
+    std::atomic<bool> finished;                   // the search is over
+    std::atomic<unsigned> sleeping;               // helpers waiting for work
+    std::atomic<u_int64_t> spent;                 // nodes of every worker
+    std::mutex mutex;                             // guards `work`
+    std::condition_variable work;                 // tasks were pushed
+};
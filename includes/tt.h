@@ -0,0 +1,163 @@
+#pragma once
+
+#include "lib.h"
+
+#include "memory.h"
+#include "move.h"
+
+/**
+ * @brief The HashEntry class
+ *
+ * This class represents what the transposition table knows about a position.
+ * The value is always given from the point of view of the player to move.
+ */
+class HashEntry {
+  public:
+    Move move;    // best (or refuting) move found, may be invalid
+    double value; // value of the position for the player to move
+    int depth;    // depth the position was searched to
+    int bound;    // TranspositionTable::Exact, LowerBound or UpperBound
+};
+
+/**
+ * @brief The TranspositionTable class
+ *
+ * This class represents a fixed size hash table of searched positions,
+ * indexed by zobrist key. Entries are written without locks but each one is
+ * checked against its own key (xor trick) so that a torn write by an other
+ * thread reads as a miss instead of garbage : the same table can be shared by
+ * concurrent searches. The table can be saved to a file and loaded back by a
+ * later process (see `save` and `load`). Entries live on huge pages when the
+ * system gives them (see LargeMemory).
+ */
+class TranspositionTable {
+  public:
+    static const int Exact = 0;
+    static const int LowerBound = 1;
+    static const int UpperBound = 2;
+
+    // version of the hash file format, bumped when entries change meaning
+    static const u_int32_t FileVersion = 1;
+
+    /**
+     * @brief Construct a new Transposition Table object
+     *
+     * @param megabytes size of the table (rounded down to a power of two)
+     */
+    TranspositionTable(std::size_t megabytes = 16);
+    ~TranspositionTable();
+
+    TranspositionTable(const TranspositionTable &) = delete;
+    TranspositionTable &operator=(const TranspositionTable &) = delete;
+
+    /**
+     * @brief reallocates the table, all entries are lost
+     *
+     * @param megabytes size of the table (rounded down to a power of two)
+     */
+    void resize(std::size_t megabytes);
+    /**
+     * @brief forgets every entry
+     *
+     */
+    void clear();
+    /**
+     * @brief number of entries in the table
+     *
+     * @return std::size_t - number of entries
+     */
+    std::size_t size() const;
+    /**
+     * @brief Get the kind of memory the entries live in
+     *
+     * @return const char* - name (see LargeMemory::name)
+     */
+    const char *memory() const;
+    /**
+     * @brief faults every page of the table in now, so that the first search
+     * does not pay for it
+     *
+     * @param always if the table should also be prefaulted on every resize
+     */
+    void prefault(bool always = false);
+
+    /**
+     * @brief looks a position up
+     *
+     * @param key zobrist key of the position
+     * @param entry filled with the stored entry on success
+     * @return true - if the position was found
+     * @return false - otherwise
+     */
+    bool probe(u_int64_t key, HashEntry &entry) const;
+    /**
+     * @brief records the result of a search
+     *
+     * @param key zobrist key of the position
+     * @param move best move found (can be invalid)
+     * @param value value for the player to move
+     * @param depth depth of the search
+     * @param bound Exact, LowerBound or UpperBound
+     */
+    void store(u_int64_t key, const Move &move, double value, int depth,
+               int bound);
+
+    /**
+     * @brief writes every entry to a hash file, the file is replaced
+     * atomically (written next to it, synced, renamed, then its directory
+     * synced) so that a process killed or a system crashing while saving
+     * leaves the previous file or the new one whole
+     *
+     * @param path path of the hash file
+     * @return std::size_t - number of entries written
+     * @throw std::runtime_error if the file cannot be written
+     */
+    std::size_t save(const std::string &path) const;
+    /**
+     * @brief reads the entries of a hash file back (the table keeps its
+     * size, entries are placed again by their keys and the deeper one wins),
+     * entries that do not sit in the slot of their key are dropped
+     *
+     * @param path path of the hash file
+     * @return std::size_t - number of entries loaded
+     * @throw std::runtime_error if the file cannot be read
+     * @throw std::invalid_argument if it is not a hash file of this version,
+     * of these zobrist keys, or if its checksum does not match
+     */
+    std::size_t load(const std::string &path);
+
+  private:
+    /**
+     * @brief one entry, `check` is the key xored with `data`. Plain words
+     * that zeroed memory holds as they are, read and written atomically
+     * through `std::atomic_ref` since threads share them
+     */
+    class Slot {
+      public:
+        u_int64_t check;
+        u_int64_t data;
+    };
+    static_assert(std::is_trivial_v<Slot> &&
+                      alignof(u_int64_t) >=
+                          std::atomic_ref<u_int64_t>::required_alignment,
+                  "slots should live in zeroed memory and be shared");
+
+    /**
+     * @brief start of a hash file, followed by `count` pairs of check and
+     * data words (native byte order)
+     */
+    class FileHeader {
+      public:
+        char magic[8];       // "chesstt" and a nul
+        u_int32_t version;   // FileVersion
+        u_int32_t word_size; // bytes per word (8)
+        u_int64_t zobrist;   // key of the starting position
+        u_int64_t count;     // number of slots that follow
+        u_int64_t checksum;  // of the slots that follow
+    };
+
+    Slot *slots;      // entries
+    std::size_t mask; // number of entries - 1
+    int mode;         // LargeMemory kind of the entries
+    bool touch;       // if resizes prefault the table
+};
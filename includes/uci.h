@@ -0,0 +1,145 @@
+#pragma once
+
+#include "lib.h"
+
+#include "board.h"
+#include "history.h"
+#include "move.h"
+#include "notation.h"
+#include "search.h"
+#include "tt.h"
+
+/**
+ * @brief The Uci class
+ *
+ * This class speaks the Universal Chess Interface on the standard streams,
+ * so that the engine can be driven by a GUI or a tournament manager. The
+ * transposition table and the search threads live as long as the process,
+ * searches run in the background while commands keep being read. Extra
+ * threads either search the same position and share the table, or split
+ * the nodes of the main search (`SMP` option).
+ */
+class Uci {
+  public:
+    /**
+     * @brief Construct a new Uci object
+     *
+     * @param tt transposition table kept warm between searches
+     * @param hash_file where `savehash` saves the table, (optional)
+     */
+    Uci(TranspositionTable *tt, const std::string &hash_file = "");
+    ~Uci();
+
+    Uci(const Uci &) = delete;
+    Uci &operator=(const Uci &) = delete;
+
+    /**
+     * @brief reads and executes commands until `quit` or end of input
+     *
+     * @return int - exit code
+     */
+    int run();
+    /**
+     * @brief executes one command
+     *
+     * @param line command line
+     * @return true - if more commands should be read
+     * @return false - on `quit`
+     */
+    bool execute(const std::string &line);
+
+    /**
+     * @brief Get the current position
+     *
+     * @return const Board& - board
+     */
+    const Board &position() const;
+
+    /**
+     * @brief writes a move in long algebraic notation
+     *
+     * @param board board the move is played on
+     * @param move move
+     * @return std::string - move string ("0000" if there is no move)
+     */
+    static std::string move_to_string(Board &board, const Move &move);
+    /**
+     * @brief writes a sequence of moves in long algebraic notation
+     *
+     * @param board board the first move is played on
+     * @param moves moves
+     * @return std::string - moves separated by spaces
+     */
+    static std::string pv_to_string(Board board,
+                                    const std::vector<Move> &moves);
+
+  private:
+    /**
+     * @brief `position [startpos | fen FEN] [moves MOVES...]`, the position
+     * is only changed if the fen and every move are valid
+     *
+     * @param args arguments
+     */
+    void set_position(std::istringstream &args);
+    /**
+     * @brief `go [searchmoves MOVES...] [ponder] [depth D] [nodes N]
+     * [movetime T] [wtime W] [btime B] [winc I] [binc I] [movestogo M]
+     * [infinite]`. With `infinite` (or `ponder`), bestmove is held until
+     * `stop` (or `ponderhit`) even if the search ends before.
+     *
+     * @param args arguments
+     */
+    void go(std::istringstream &args);
+    /**
+     * @brief `setoption name NAME [value VALUE]`
+     *
+     * @param args arguments
+     */
+    void set_option(std::istringstream &args);
+    /**
+     * @brief saves the transposition table to the hash file (non standard
+     * `savehash` command), the outcome is sent as an info string
+     *
+     */
+    void save_hash();
+    /**
+     * @brief stops the running search (if any) and waits for its bestmove
+     *
+     */
+    void stop();
+    /**
+     * @brief lets the running search send its bestmove once it is done
+     * (`ponderhit`, `stop`)
+     *
+     */
+    void release();
+    /**
+     * @brief waits for the searches, then sends info and bestmove
+     *
+     */
+    void report();
+    /**
+     * @brief writes one line on the standard output
+     *
+     * @param line line
+     */
+    void send(const std::string &line);
+
+    TranspositionTable *tt; // shared by all searches
+    std::string hash_file;  // where the table is saved, or empty
+    unsigned multipv;       // number of best moves reported
+    bool ybwc;              // threads split the nodes instead of helping
+    Board board;            // current position
+    History keys;           // keys of the positions before it
+
+    SearchThread search;                // main search
+    std::vector<SearchThread *> helpers; // helper searches (Threads - 1)
+    ThreadPool::Task reporter;           // waits for the search to end
+    std::mutex output;                   // one line at a time on stdout
+
+    std::mutex hold;                  // guards `held`
+    std::condition_variable released; // `held` was cleared
+    bool held;                        // bestmove waits for stop or ponderhit
+
+    std::chrono::steady_clock::time_point start; // start of the search
+};
@@ -0,0 +1,48 @@
+#pragma once
+
+#include "lib.h"
+
+#include "position.h"
+
+/**
+ * @brief The Zobrist class
+ *
+ * This class holds the random keys used to hash a board position.
+ * A position key is the xor of the keys of every feature of the board
+ * (pieces, castling rights, en passant file and side to move), so that
+ * it can be updated incrementally when a move is played.
+ */
+class Zobrist {
+  public:
+    /**
+     * @brief key of a piece standing on a square
+     *
+     * @param type type of the piece (Piece::King..Piece::Queen)
+     * @param color color of the piece
+     * @param pos position of the piece
+     * @return u_int64_t - key
+     */
+    static u_int64_t piece(int type, Color color, const Position &pos);
+    /**
+     * @brief key of a set of castling rights
+     * bit 0 and 1 are white kingside and queenside,
+     * bit 2 and 3 are black kingside and queenside
+     *
+     * @param rights castling rights mask 0..=15
+     * @return u_int64_t - key
+     */
+    static u_int64_t castling(int rights);
+    /**
+     * @brief key of an en passant square (only the file matters)
+     *
+     * @param pos en passant position
+     * @return u_int64_t - key
+     */
+    static u_int64_t en_passant(const Position &pos);
+    /**
+     * @brief key toggled when black is to move
+     *
+     * @return u_int64_t - key
+     */
+    static u_int64_t side();
+};
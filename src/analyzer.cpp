@@ -0,0 +1,207 @@
+#include "analyzer.h"
+
+#include <optional>
+
+#include "notation.h"
+#include "uci.h"
+
+/**
+ * @brief escapes a string for a JSON document
+ *
+ * @param str string
+ * @return std::string - quoted string
+ */
+static std::string json_string(const std::string &str) {
+    std::string result = "\"";
+    for (char c : str) {
+        if (c == '"' || c == '\\') {
+            result += '\\';
+        }
+        if (static_cast<unsigned char>(c) >= 0x20) {
+            result += c;
+        }
+    }
+    return result + "\"";
+}
+
+/**
+ * @brief reads the `id "..."` operation of an EPD line
+ *
+ * @param line EPD line
+ * @return std::string - id, or empty
+ */
+static std::string epd_id(const std::string &line) {
+    std::string::size_type start = line.find("id \"");
+    if (start == std::string::npos) {
+        return std::string();
+    }
+    start += 4;
+    std::string::size_type end = line.find('"', start);
+    return line.substr(start, end == std::string::npos ? end : end - start);
+}
+
+/**
+ * @brief reads the `bm ...;` (best moves) operation of an EPD line
+ *
+ * @param line EPD line
+ * @return std::string_view - moves separated by spaces, or empty
+ */
+static std::string_view epd_best_moves(std::string_view line) {
+    std::string_view::size_type start = line.find(" bm ");
+    if (start == std::string_view::npos) {
+        return std::string_view();
+    }
+    line.remove_prefix(start + 4);
+    return line.substr(0, line.find(';'));
+}
+
+Analyzer::Analyzer(const SearchLimits &limits, unsigned threads,
+                   std::size_t megabytes, TranspositionTable *tt)
+    : limits(limits) {
+    this->threads = std::max(threads, 1u);
+    this->megabytes = megabytes;
+    this->tt = tt;
+}
+
+Analyzer::~Analyzer() {}
+
+unsigned Analyzer::run(const std::string &filename, std::ostream &os) {
+    std::ifstream file(filename);
+    if (!file) {
+        panic("Could not open " + filename);
+    }
+
+    // positions with their line numbers
+    std::vector<std::pair<std::string, unsigned>> positions;
+    std::string line;
+    for (unsigned number = 1; std::getline(file, line); number++) {
+        line = trim(line);
+        if (!line.empty() && line[0] != '#') {
+            positions.emplace_back(line, number);
+        }
+    }
+
+    std::vector<std::string> results(positions.size());
+    std::vector<bool> ready(positions.size(), false);
+    std::mutex mutex;
+    std::condition_variable done;
+    std::atomic<std::size_t> next(0);
+
+    // workers take positions in order, the main thread writes them in order
+    std::vector<ThreadPool::Task> workers;
+    unsigned count = std::min<std::size_t>(threads, positions.size());
+    for (unsigned i = 0; i < count; i++) {
+        workers.push_back(ThreadPool::global().submit([&]() {
+            std::optional<TranspositionTable> own;
+            if (this->tt == nullptr) {
+                own.emplace(megabytes);
+            } // a table of its own only when none is shared
+            TranspositionTable &tt = this->tt != nullptr ? *this->tt : *own;
+            std::size_t index;
+            while ((index = next.fetch_add(1)) < positions.size()) {
+                std::string result =
+                    analyze(positions[index].first, positions[index].second,
+                            limits, tt);
+                std::lock_guard<std::mutex> lock(mutex);
+                results[index] = std::move(result);
+                ready[index] = true;
+                done.notify_all();
+            }
+        }));
+    }
+
+    for (std::size_t i = 0; i < positions.size(); i++) {
+        std::unique_lock<std::mutex> lock(mutex);
+        done.wait(lock, [&]() { return bool(ready[i]); });
+        std::string result = std::move(results[i]);
+        lock.unlock();
+        os << result << "\n";
+    }
+    os.flush();
+
+    for (ThreadPool::Task &worker : workers) {
+        worker.wait();
+    }
+    return unsigned(positions.size());
+}
+
+std::string Analyzer::analyze(const std::string &line, unsigned number,
+                              const SearchLimits &limits,
+                              TranspositionTable &tt) {
+    std::stringstream ss;
+    ss << "{\"line\": " << number;
+    std::string id = epd_id(line);
+    if (!id.empty()) {
+        ss << ", \"id\": " << json_string(id);
+    }
+
+    Board board;
+    try {
+        board = Board::from_epd(line);
+    } catch (std::invalid_argument &e) {
+        ss << ", \"error\": " << json_string(e.what()) << "}";
+        return ss.str();
+    }
+
+    auto start = std::chrono::steady_clock::now();
+    SearchContext context = SearchContext(History(), &tt);
+    context.limit(limits);
+    std::tuple<Move, u_int64_t, double> r;
+    if (limits.multipv > 1) {
+        std::vector<PvLine> lines =
+            board.get_best_moves(limits.depth, limits.multipv, context);
+        r = std::make_tuple(lines.front().move, context.stats.total_nodes(),
+                            lines.front().value);
+    } else {
+        r = board.get_next_best_move(limits.depth, context);
+    }
+    int64_t ms = std::chrono::duration_cast<std::chrono::milliseconds>(
+                     std::chrono::steady_clock::now() - start)
+                     .count();
+
+    ss << ", \"bestmove\": \""
+       << Uci::move_to_string(board, std::get<0>(r)) << "\"";
+    ss << ", \"score\": " << std::lround(std::get<2>(r));
+    ss << ", \"depth\": " << context.depth + 1;
+    ss << ", \"nodes\": " << std::get<1>(r);
+    ss << ", \"qnodes\": " << context.stats.qnodes;
+    ss << ", \"time\": " << ms;
+    ss << ", \"ebf\": "
+       << std::round(context.stats.branching_factor() * 100.) / 100.;
+    ss << ", \"pv\": \"" << Uci::pv_to_string(board, context.stats.pv)
+       << "\"";
+    if (limits.multipv > 1) {
+        ss << ", \"multipv\": [";
+        for (std::size_t i = 0; i < context.stats.lines.size(); i++) {
+            const PvLine &line = context.stats.lines[i];
+            ss << (i == 0 ? "" : ", ") << "{\"move\": \""
+               << Uci::move_to_string(board, line.move)
+               << "\", \"score\": " << std::lround(line.value)
+               << ", \"pv\": \"" << Uci::pv_to_string(board, line.pv)
+               << "\"}";
+        }
+        ss << "]";
+    } // the best moves, best first
+
+    // test suites : is the move found one of the expected ones
+    std::string_view best_moves = epd_best_moves(line);
+    if (!best_moves.empty()) {
+        std::vector<Move> legal_moves = board.get_legal_moves();
+        bool solved = false;
+        while (!best_moves.empty()) {
+            std::string_view::size_type end = best_moves.find(' ');
+            Move m;
+            if (Notation::parse(board, best_moves.substr(0, end), legal_moves,
+                                m) == Notation::Ok &&
+                m == std::get<0>(r)) {
+                solved = true;
+            }
+            best_moves.remove_prefix(end == std::string_view::npos
+                                         ? best_moves.size()
+                                         : end + 1);
+        }
+        ss << ", \"solved\": " << (solved ? "true" : "false");
+    }
+    ss << "}";
+    return ss.str();
+}
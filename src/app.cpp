@@ -1,5 +1,11 @@
 #include "app.h"
 
+// depth of the cpu searches
+static const int CPU_DEPTH = 4;
+
+// stop flag of the running cpu search, for Ctrl-C
+static std::atomic<std::atomic<bool> *> interruptible(nullptr);
+
 static void sig_handler(int signal) {
     static int64_t ms = 0;
     static std::chrono::milliseconds elapsed;
@@ -8,8 +14,21 @@ static void sig_handler(int signal) {
 
     state = State::HANDLING_SIGNAL;
 
+    std::atomic<bool> *stop_flag = nullptr;
+
     switch (signal) {
     case SIGINT:
+        // while the cpu thinks, Ctrl-C only stops the search
+        stop_flag = interruptible.load();
+        if (stop_flag != nullptr) {
+            stop_flag->store(true);
+            chk(write(STDOUT_FILENO, "\033[2K\r", 5));
+            std::cout << FG_YEL << "Ctrl-C received, stopping search." << RST
+                      << "\n";
+            std::cout.flush();
+            break;
+        }
+
         // count elapsed time since last SIGINT
         now = std::chrono::high_resolution_clock::now();
         elapsed =
@@ -47,15 +66,51 @@ static void sig_handler(int signal) {
     }
 }
 
-Move App::get_cpu_move(Board &board, bool best) {
-    std::tuple<Move, unsigned, double> r;
+/**
+ * @brief writes the profile counters, registered at exit by `--profile`
+ *
+ */
+static void profile_report() { Profile::report(std::cerr); }
+
+/**
+ * @brief waits for a search, reading the input meanwhile : "stop" (or Ctrl-C)
+ * makes it return its best move so far, anything else is kept for later
+ *
+ * @param search running search
+ */
+static void wait_for(SearchThread &search) {
+    interruptible.store(search.stop_flag());
+    std::string line;
+    while (!search.is_done()) {
+        if (!poll_input(line, 10)) {
+            continue;
+        }
+        if (to_lower(trim(line)) == "stop") {
+            search.stop();
+        } else {
+            unread_input(line);
+        }
+    }
+    interruptible.store(nullptr);
+}
+
+Move App::get_cpu_move(Board &board, const History &keys, bool best) {
+    std::tuple<Move, u_int64_t, double> r;
+    SearchStats stats;
 
     // get move and time
     auto start = std::chrono::high_resolution_clock::now();
-    if (best) {
-        r = board.get_next_best_move(4);
+    bool ponder_hit = best && this->pondering.is_pondering(board);
+    if (ponder_hit) {
+        // the expected reply was played, collect the background search
+        wait_for(this->pondering.search_thread());
+        r = this->pondering.result();
+        stats = this->pondering.search_thread().stats();
     } else {
-        r = board.get_next_worst_move(4);
+        this->search.start(board, keys, CPU_DEPTH, best);
+        wait_for(this->search);
+        r = this->search.wait();
+        stats = this->search.stats();
     }
     auto end = std::chrono::high_resolution_clock::now();
 
@@ -72,7 +127,7 @@ Move App::get_cpu_move(Board &board, bool best) {
     }
 
     Move m = std::get<0>(r);
-    unsigned count = std::get<1>(r);
+    u_int64_t count = std::get<1>(r);
     double score = std::get<2>(r);
     std::cout << "CPU evaluated " << count << " moves before choosing to ";
     std::cout.flush();
@@ -114,17 +169,42 @@ Move App::get_cpu_move(Board &board, bool best) {
 
     if (this->verbose()) {
         std::cout << "CPU score: " << score << std::endl;
-        std::cout << "Took " << time_to_string(ms) << "ms" << std::endl;
+        std::cout << "Took " << time_to_string(ms)
+                  << (ponder_hit ? " (ponder hit)" : "") << std::endl;
+        std::cout << stats;
+        if (!stats.pv.empty()) {
+            std::cout << "pv: " << Uci::pv_to_string(board, stats.pv) << "\n";
+        }
+        std::cout.flush();
     }
     return m;
 }
 
-App::App(int argc, char *argv[]) {
+App::App(int argc, char *argv[])
+    : tt(16), search(&tt), pondering(&tt, CPU_DEPTH) {
     fen_ = "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1";
     moves_ = "";
     filename_ = "";
     verbose_ = false;
     quiet_ = false;
+    ponder_ = false;
+    uci_ = false;
+    analyze_ = "";
+    depth_ = CPU_DEPTH + 1;
+    nodes_ = 0;
+    multipv_ = 1;
+    selfplay_ = "";
+    games_ = 0;
+    first_ = "";
+    second_ = "";
+    sprt_ = "0,5";
+    hash_file_ = "";
+    hash_prefault_ = false;
+    threads_ = 0;
+    affinity_ = false;
+    smp_ = "";
+    bench_ = false;
+    profile_ = false;
     help_ = false;
     version_ = false;
     license_ = false;
@@ -151,6 +231,42 @@ const bool &App::verbose() const { return verbose_; }
 
 const bool &App::quiet() const { return quiet_; }
 
+const bool &App::ponder() const { return ponder_; }
+
+const bool &App::uci() const { return uci_; }
+
+const std::string &App::analyze() const { return analyze_; }
+
+const int &App::depth() const { return depth_; }
+
+const u_int64_t &App::nodes() const { return nodes_; }
+
+const unsigned &App::multipv() const { return multipv_; }
+
+const std::string &App::selfplay() const { return selfplay_; }
+
+const unsigned &App::games() const { return games_; }
+
+const std::string &App::first() const { return first_; }
+
+const std::string &App::second() const { return second_; }
+
+const std::string &App::sprt() const { return sprt_; }
+
+const std::string &App::hash_file() const { return hash_file_; }
+
+const bool &App::hash_prefault() const { return hash_prefault_; }
+
+const unsigned &App::threads() const { return threads_; }
+
+const bool &App::affinity() const { return affinity_; }
+
+const std::string &App::smp() const { return smp_; }
+
+const bool &App::bench() const { return bench_; }
+
+const bool &App::profile() const { return profile_; }
+
 const bool &App::help() const { return help_; }
 
 const bool &App::version() const { return version_; }
@@ -167,6 +283,42 @@ bool &App::verbose() { return verbose_; }
 
 bool &App::quiet() { return quiet_; }
 
+bool &App::ponder() { return ponder_; }
+
+bool &App::uci() { return uci_; }
+
+std::string &App::analyze() { return analyze_; }
+
+int &App::depth() { return depth_; }
+
+u_int64_t &App::nodes() { return nodes_; }
+
+unsigned &App::multipv() { return multipv_; }
+
+std::string &App::selfplay() { return selfplay_; }
+
+unsigned &App::games() { return games_; }
+
+std::string &App::first() { return first_; }
+
+std::string &App::second() { return second_; }
+
+std::string &App::sprt() { return sprt_; }
+
+std::string &App::hash_file() { return hash_file_; }
+
+bool &App::hash_prefault() { return hash_prefault_; }
+
+unsigned &App::threads() { return threads_; }
+
+bool &App::affinity() { return affinity_; }
+
+std::string &App::smp() { return smp_; }
+
+bool &App::bench() { return bench_; }
+
+bool &App::profile() { return profile_; }
+
 bool &App::help() { return help_; }
 
 bool &App::version() { return version_; }
@@ -185,6 +337,50 @@ void App::verbose(const bool verbose) { verbose_ = std::move(verbose); }
 
 void App::quiet(const bool quiet) { quiet_ = std::move(quiet); }
 
+void App::ponder(const bool ponder) { ponder_ = std::move(ponder); }
+
+void App::uci(const bool uci) { uci_ = std::move(uci); }
+
+void App::analyze(const std::string &analyze) {
+    analyze_ = std::move(analyze);
+}
+
+void App::depth(const int depth) { depth_ = std::move(depth); }
+
+void App::nodes(const u_int64_t nodes) { nodes_ = std::move(nodes); }
+
+void App::multipv(const unsigned multipv) { multipv_ = std::move(multipv); }
+
+void App::selfplay(const std::string &selfplay) {
+    selfplay_ = std::move(selfplay);
+}
+
+void App::games(const unsigned games) { games_ = std::move(games); }
+
+void App::first(const std::string &first) { first_ = std::move(first); }
+
+void App::second(const std::string &second) { second_ = std::move(second); }
+
+void App::sprt(const std::string &sprt) { sprt_ = std::move(sprt); }
+
+void App::hash_file(const std::string &hash_file) {
+    hash_file_ = std::move(hash_file);
+}
+
+void App::hash_prefault(const bool hash_prefault) {
+    hash_prefault_ = std::move(hash_prefault);
+}
+
+void App::threads(const unsigned threads) { threads_ = std::move(threads); }
+
+void App::affinity(const bool affinity) { affinity_ = std::move(affinity); }
+
+void App::smp(const std::string &smp) { smp_ = std::move(smp); }
+
+void App::bench(const bool bench) { bench_ = std::move(bench); }
+
+void App::profile(const bool profile) { profile_ = std::move(profile); }
+
 void App::help(const bool help) { help_ = std::move(help); }
 
 void App::version(const bool version) { version_ = std::move(version); }
@@ -200,14 +396,33 @@ void App::parse_args(int argc, char *argv[]) {
         {"filename", required_argument, nullptr, 'n'},
         {"verbose", no_argument, nullptr, 'v'},
         {"quiet", no_argument, nullptr, 'q'},
+        {"ponder", no_argument, nullptr, 'p'},
+        {"uci", no_argument, nullptr, 'u'},
+        {"analyze", required_argument, nullptr, 'a'},
+        {"depth", required_argument, nullptr, 'd'},
+        {"nodes", required_argument, nullptr, 'N'},
+        {"multipv", required_argument, nullptr, 'k'},
+        {"selfplay", required_argument, nullptr, 's'},
+        {"games", required_argument, nullptr, 'g'},
+        {"first", required_argument, nullptr, 'A'},
+        {"second", required_argument, nullptr, 'B'},
+        {"sprt", required_argument, nullptr, 'S'},
+        {"hash-file", required_argument, nullptr, 'H'},
+        {"hash-prefault", no_argument, nullptr, 'F'},
+        {"threads", required_argument, nullptr, 't'},
+        {"affinity", no_argument, nullptr, 'x'},
+        {"smp", required_argument, nullptr, 'y'},
+        {"bench", no_argument, nullptr, 'b'},
+        {"profile", no_argument, nullptr, 'P'},
         {"help", no_argument, nullptr, 'h'},
         {"version", no_argument, nullptr, 'V'},
         {"license", no_argument, nullptr, 'L'},
         {nullptr, 0, nullptr, 0},
     };
 
-    const char *short_options = "f:m:n:vqhVL"; // short options
-    std::string bad_option;                    // bad option full name
+    const char *short_options =
+        "f:m:n:vqpua:d:N:k:s:g:A:B:S:H:Ft:xy:bPhVL"; // short options
+    std::string bad_option;                          // bad option full name
     std::stringstream ss;
 
     while ((opt = getopt_long(argc, argv, short_options, long_options,
@@ -228,6 +443,60 @@ void App::parse_args(int argc, char *argv[]) {
         case 'q': // quiet mode
             quiet_ = true;
             break;
+        case 'p': // ponder mode
+            ponder_ = true;
+            break;
+        case 'u': // uci mode
+            uci_ = true;
+            break;
+        case 'a': // epd file to analyze
+            analyze_ = optarg;
+            break;
+        case 'd': // depth of the batch searches
+            depth_ = std::atoi(optarg);
+            break;
+        case 'N': // node budget of the batch searches
+            nodes_ = std::strtoull(optarg, nullptr, 10);
+            break;
+        case 'k': // number of best moves of the batch searches
+            multipv_ = unsigned(std::strtoul(optarg, nullptr, 10));
+            break;
+        case 's': // epd file of the self-play openings
+            selfplay_ = optarg;
+            break;
+        case 'g': // number of self-play games
+            games_ = unsigned(std::strtoul(optarg, nullptr, 10));
+            break;
+        case 'A': // first self-play engine
+            first_ = optarg;
+            break;
+        case 'B': // second self-play engine
+            second_ = optarg;
+            break;
+        case 'S': // bounds of the self-play test
+            sprt_ = optarg;
+            break;
+        case 'H': // file the transposition table is kept in
+            hash_file_ = optarg;
+            break;
+        case 'F': // fault the table pages in at start
+            hash_prefault_ = true;
+            break;
+        case 't': // workers of the thread pool
+            threads_ = unsigned(std::strtoul(optarg, nullptr, 10));
+            break;
+        case 'x': // pin the workers to cores
+            affinity_ = true;
+            break;
+        case 'y': // parallel search of bench and uci
+            smp_ = optarg;
+            break;
+        case 'b': // bench mode
+            bench_ = true;
+            break;
+        case 'P': // profile the hot path
+            profile_ = true;
+            break;
         case 'h': // get help
             help_ = true;
             break;
@@ -265,6 +534,28 @@ void App::check_args() {
         get_help("--verbose and --quiet are mutually exclusive");
         panic("");
     }
+    if (depth_ < 1) {
+        get_help("--depth should be a positive number of plies");
+        panic("");
+    }
+    if (multipv_ < 1) {
+        get_help("--multipv should be a positive number of moves");
+        panic("");
+    }
+    if (threads_ == 0) {
+        threads_ = std::max(std::thread::hardware_concurrency(), 1u);
+    } // one worker per core by default
+    if (!smp_.empty() && smp_ != "shared" && smp_ != "ybwc") {
+        get_help("--smp should be shared or ybwc");
+        panic("");
+    }
+    if (profile_) {
+        if (!Profile::available()) {
+            get_help("--profile needs a build with profiling (make profile)");
+        }
+        Profile::enable(true);
+        std::atexit(profile_report);
+    }
 }
 
 void App::get_version() {
@@ -296,6 +587,24 @@ void App::get_help(const std::string &msg) {
     ss << "  -n, --filename FILENAME\n";
     ss << "  -v, --verbose\n";
     ss << "  -q, --quiet\n";
+    ss << "  -p, --ponder\n";
+    ss << "  -u, --uci\n";
+    ss << "  -a, --analyze  FILENAME\n";
+    ss << "  -d, --depth    DEPTH\n";
+    ss << "  -N, --nodes    NODES\n";
+    ss << "  -k, --multipv  K\n";
+    ss << "  -s, --selfplay FILENAME\n";
+    ss << "  -g, --games    GAMES\n";
+    ss << "  -A, --first    ENGINE\n";
+    ss << "  -B, --second   ENGINE\n";
+    ss << "  -S, --sprt     ELO0,ELO1\n";
+    ss << "  -H, --hash-file FILENAME\n";
+    ss << "  -F, --hash-prefault\n";
+    ss << "  -t, --threads  N\n";
+    ss << "  -x, --affinity\n";
+    ss << "  -y, --smp      shared|ybwc\n";
+    ss << "  -b, --bench\n";
+    ss << "  -P, --profile\n";
     ss << "  -h, --help\n";
     ss << "  -V, --version\n";
     ss << "  -L, --license\n";
@@ -352,21 +661,203 @@ std::ostream &operator<<(std::ostream &os, const App &app) {
        << "\n";
     os << "verbose: " << (app.verbose() ? "true" : "false") << "\n";
     os << "quiet: " << (app.quiet() ? "true" : "false") << "\n";
+    os << "ponder: " << (app.ponder() ? "true" : "false") << "\n";
+    os << "uci: " << (app.uci() ? "true" : "false") << "\n";
+    os << "analyze: " << (app.analyze().empty() ? "-" : app.analyze())
+       << "\n";
+    os << "depth: " << app.depth() << "\n";
+    os << "nodes: " << app.nodes() << "\n";
+    os << "multipv: " << app.multipv() << "\n";
+    os << "selfplay: " << (app.selfplay().empty() ? "-" : app.selfplay())
+       << "\n";
+    os << "games: " << app.games() << "\n";
+    os << "first: " << (app.first().empty() ? "-" : app.first()) << "\n";
+    os << "second: " << (app.second().empty() ? "-" : app.second()) << "\n";
+    os << "sprt: " << app.sprt() << "\n";
+    os << "hash-file: " << (app.hash_file().empty() ? "-" : app.hash_file())
+       << "\n";
+    os << "hash-prefault: " << (app.hash_prefault() ? "true" : "false")
+       << "\n";
+    os << "threads: " << app.threads() << "\n";
+    os << "affinity: " << (app.affinity() ? "true" : "false") << "\n";
+    os << "smp: " << (app.smp().empty() ? "-" : app.smp()) << "\n";
+    os << "bench: " << (app.bench() ? "true" : "false") << "\n";
+    os << "profile: " << (app.profile() ? "true" : "false") << "\n";
     os << "help: " << (app.help() ? "true" : "false") << "\n";
     os << "version: " << (app.version() ? "true" : "false") << "\n";
     os << "license: " << (app.license() ? "true" : "false") << "\n";
     return os;
 }
 
-void history_display(const std::vector<Move> &history) {
+void App::load_games(Game &game) {
+    PgnReader reader(this->filename());
+    PgnGame pgn;
+    unsigned games = 0, errors = 0;
+    std::size_t moves = 0;
+
+    auto start = std::chrono::steady_clock::now();
+    while (reader.next(pgn)) {
+        games++;
+        std::string_view fen = pgn.tag("FEN");
+        try {
+            game.reset(fen.empty() ? Board::new_board() : Board::from_fen(fen));
+        } catch (std::invalid_argument &e) {
+            std::cerr << "Game " << games << ": " << e.what() << std::endl;
+            errors++;
+            continue;
+        }
+
+        for (std::string_view san : pgn.moves) {
+            Move m;
+            int promotion;
+            int result = Notation::parse(game.board(), san, m, &promotion);
+            if (result != Notation::Ok) {
+                std::cerr << "Game " << games << ": "
+                          << Notation::error(result) << " " << san
+                          << " after " << game.ply() << " plies"
+                          << std::endl;
+                errors++;
+                break;
+            }
+            game.play(m, game.board().apply_promotion(m, promotion));
+        }
+        moves += game.ply();
+    }
+    int64_t ms = std::chrono::duration_cast<std::chrono::milliseconds>(
+                     std::chrono::steady_clock::now() - start)
+                     .count();
+
+    if (this->verbose()) {
+        std::cout << "replayed " << games << " games (" << moves
+                  << " plies, " << errors << " errors) from "
+                  << reader.size() / 1024 << " KiB in " << time_to_string(ms)
+                  << " (" << games * 1000 / std::max(ms, int64_t(1))
+                  << " games/s)" << std::endl;
+    }
+}
+
+void App::play_moves(Game &game) {
+    std::string_view moves = this->moves();
+    std::vector<Move> legal_moves;
+
+    while (!moves.empty()) {
+        std::string_view::size_type end = moves.find_first_of(" ,");
+        std::string_view token = moves.substr(0, end);
+        moves.remove_prefix(end == std::string_view::npos ? moves.size()
+                                                          : end + 1);
+
+        // move numbers ("1." or "1...")
+        std::string_view::size_type number = token.find_last_of('.');
+        if (number != std::string_view::npos) {
+            token.remove_prefix(number + 1);
+        }
+        if (token.empty()) {
+            continue;
+        }
+
+        Move m;
+        int promotion;
+        legal_moves = game.board().get_legal_moves();
+        int result = Notation::parse(game.board(), token, legal_moves, m,
+                                     &promotion);
+        if (result != Notation::Ok) {
+            get_help(std::string(Notation::error(result)) + " in --moves: " +
+                     std::string(token));
+        }
+        game.play(m, game.board().apply_promotion(m, promotion));
+    }
+}
+
+int App::play_match() {
+    // both engines default to the --depth and --nodes of batch searches
+    SearchLimits limits = SearchLimits(this->depth() - 1);
+    limits.nodes = this->nodes();
+    EngineConfig base = EngineConfig(limits);
+    EngineConfig first, second;
+    double elo0, elo1;
+    try {
+        first = EngineConfig::from_string(this->first(), base);
+        second = EngineConfig::from_string(this->second(), base);
+    } catch (std::invalid_argument &e) {
+        get_help(e.what());
+    }
+    char comma;
+    std::istringstream bounds(this->sprt());
+    if (!(bounds >> elo0 >> comma >> elo1) || comma != ',' || elo0 >= elo1) {
+        get_help("--sprt expects ELO0,ELO1 with ELO0 < ELO1");
+    }
+
+    Board::enable_rating(false);
+    Match match = Match(first, second, this->threads());
+    match.sprt(elo0, elo1);
+
+    auto start = std::chrono::steady_clock::now();
+    MatchStats stats = match.run(this->selfplay(), this->games(),
+                                 this->verbose() ? &std::cerr : nullptr);
+    int64_t ms = std::chrono::duration_cast<std::chrono::milliseconds>(
+                     std::chrono::steady_clock::now() - start)
+                     .count();
+
+    stats.report(std::cout, elo0, elo1);
+    if (this->verbose()) {
+        std::cerr << "played " << stats.games() << " games in "
+                  << time_to_string(ms) << " ("
+                  << stats.games() * 60000 / std::max(ms, int64_t(1))
+                  << " games/min)" << std::endl;
+    }
+    return EXIT_SUCCESS;
+}
+
+void App::load_hash() {
+    if (this->hash_file().empty() ||
+        access(this->hash_file().c_str(), F_OK) != 0) {
+        return;
+    } // nothing saved yet : cold start
+
+    auto start = std::chrono::steady_clock::now();
+    try {
+        std::size_t entries = this->tt.load(this->hash_file());
+        int64_t ms = std::chrono::duration_cast<std::chrono::milliseconds>(
+                         std::chrono::steady_clock::now() - start)
+                         .count();
+        if (this->verbose()) {
+            std::cerr << "loaded " << entries << " entries from "
+                      << this->hash_file() << " in " << time_to_string(ms)
+                      << std::endl;
+        }
+    } catch (std::exception &e) {
+        std::cerr << e.what() << ", starting with an empty table"
+                  << std::endl;
+    }
+}
+
+bool App::save_hash() {
+    if (this->hash_file().empty()) {
+        return false;
+    }
+    try {
+        std::size_t entries = this->tt.save(this->hash_file());
+        if (this->verbose()) {
+            std::cerr << "saved " << entries << " entries to "
+                      << this->hash_file() << std::endl;
+        }
+        return true;
+    } catch (std::exception &e) {
+        std::cerr << e.what() << std::endl;
+        return false;
+    }
+}
+
+void history_display(const Game &game) {
     // display history
-    for (std::vector<Move>::size_type i = 0; i < history.size(); i++) {
+    for (std::size_t i = 0; i < game.ply(); i++) {
         // this is to display two moves per line
-        if (i < history.size() - 1) {
-            std::cout << history[i] << " | " << history[i + 1] << std::endl;
+        if (i < game.ply() - 1) {
+            std::cout << game.move(i) << " | " << game.move(i + 1)
+                      << std::endl;
             i++;
         } else {
-            std::cout << history[i] << std::endl;
+            std::cout << game.move(i) << std::endl;
         }
     }
 }
@@ -376,33 +867,127 @@ int App::run() {
     ss << *this;
     std_debug(ss.str());
 
+    ThreadPool::global().start(this->threads(), this->affinity());
+    if (this->verbose()) {
+        std::cerr << "threads: " << ThreadPool::global().size() << " workers"
+                  << (ThreadPool::global().pinned() ? ", pinned to cores" : "")
+                  << std::endl;
+    } // parked until a search, an analysis or a game needs them
+
+    auto start = std::chrono::steady_clock::now();
+    if (this->hash_prefault()) {
+        this->tt.prefault(true);
+    } // the first search does not pay the page faults
+    if (this->verbose()) {
+        int64_t ms = std::chrono::duration_cast<std::chrono::milliseconds>(
+                         std::chrono::steady_clock::now() - start)
+                         .count();
+        std::cerr << "hash: " << this->tt.size() << " entries on "
+                  << this->tt.memory();
+        if (this->hash_prefault()) {
+            std::cerr << ", prefaulted in " << time_to_string(ms);
+        }
+        std::cerr << std::endl;
+    }
+    load_hash(); // a warm table from an earlier run
+
+    if (this->uci()) {
+        Uci engine(&this->tt, this->hash_file());
+        if (this->multipv() > 1) {
+            engine.execute("setoption name MultiPV value " +
+                           std::to_string(this->multipv()));
+        } // until the gui sets it
+        if (!this->smp().empty()) {
+            engine.execute(std::string("setoption name SMP value ") +
+                           (this->smp() == "ybwc" ? "YBWC" : "SharedHash"));
+            engine.execute("setoption name Threads value " +
+                           std::to_string(this->threads()));
+        }
+        int status = engine.run();
+        save_hash();
+        return status;
+    } // a gui or a tournament manager drives the engine
+
+    if (this->bench()) {
+        Board::enable_rating(false);
+        Bench bench = Bench(
+            Bench::DEPTH, this->smp().empty() ? 1 : this->threads(),
+            this->smp() == "ybwc" ? Bench::Ybwc : Bench::SharedHash);
+        bench.run(std::cout);
+        return EXIT_SUCCESS;
+    } // fixed positions, fixed depth, one thread unless --smp
+
+    if (!this->analyze().empty()) {
+        SearchLimits limits = SearchLimits(this->depth() - 1);
+        limits.nodes = this->nodes();
+        limits.multipv = this->multipv();
+        Analyzer analyzer =
+            Analyzer(limits, this->threads(), 4,
+                     this->hash_file().empty() ? nullptr : &this->tt);
+
+        auto start = std::chrono::steady_clock::now();
+        unsigned count = analyzer.run(this->analyze(), std::cout);
+        int64_t ms = std::chrono::duration_cast<std::chrono::milliseconds>(
+                         std::chrono::steady_clock::now() - start)
+                         .count();
+        if (this->verbose()) {
+            std::cerr << "analyzed " << count << " positions in "
+                      << time_to_string(ms) << " ("
+                      << count * 1000 / std::max(ms, int64_t(1))
+                      << " positions/s)" << std::endl;
+        }
+        save_hash();
+        return EXIT_SUCCESS;
+    } // batch analysis, one json line per position
+
+    if (!this->selfplay().empty()) {
+        return play_match();
+    } // engine against engine, no board to display
+
     std::signal(SIGINT, sig_handler);
     std::signal(SIGSEGV, sig_handler);
 
+    // scripted quiet games do not pay for the rating bar
+    Board::enable_rating(!this->quiet());
+
     // load board from FEN (default fen is set in constructor)
-    Board board = Board::from_fen(this->fen());
+    Game game;
+    try {
+        game.reset(Board::from_fen(this->fen()));
+    } catch (std::invalid_argument &e) {
+        get_help(std::string(e.what()) + " in --fen");
+    }
+
+    if (!this->filename().empty()) {
+        load_games(game);
+    }
+    if (!this->moves().empty()) {
+        play_moves(game);
+    }
+    Board &board = game.board(); // moves go through the game
     if (!this->quiet()) {
         std::cout << "\n" << board << std::endl;
     } // display board is not quiet
-
-    std::vector<Board> boards = std::vector<Board>();
-    std::vector<Move> history = std::vector<Move>();
     bool is_running = true;
 
     while (is_running) {
         std::string s;
-        input(s, ">>> ");      // async input
-        s = to_lower(trim(s)); // trim and lowercase
+        input(s, ">>> ");          // async input
+        std::string raw = trim(s); // as typed, for algebraic notation
+        s = to_lower(raw);         // lowercase
 
         state = State::PARSING_MOVE;
 
-        Move m; // invalid move
+        Move m;                // invalid move
+        bool cpu_move = false; // if the move was chosen by the cpu
         if (s.empty() || s == "best" || s == "b") {
             std::cout << "Waiting for CPU to choose best move..." << std::endl;
-            m = get_cpu_move(board, true);
+            m = get_cpu_move(board, game.keys(), true);
+            cpu_move = true;
         } else if (s == "worst" || s == "w") {
             std::cout << "Waiting for CPU to choose worst move..." << std::endl;
-            m = get_cpu_move(board, false);
+            m = get_cpu_move(board, game.keys(), false);
+            cpu_move = true;
         } else if (s == "show" || s == "s") {
             std::cout << board << std::endl;
             continue;
@@ -412,25 +997,47 @@ int App::run() {
             continue;
         } else if (s == "pass" || s == "p") {
             board = board.change_turn();
+            this->pondering.update(board);
             std::cout << board << std::endl;
             continue;
+        } else if (s == "stop") {
+            std::cout << "No search to stop." << std::endl;
+            continue;
         } else if (s == "/quit" || s == "/q" || s == "/") {
             is_running = false;
+        } else if (s == "save") {
+            if (this->hash_file().empty()) {
+                std::cout << "No --hash-file to save to" << std::endl;
+            } else if (save_hash()) {
+                std::cout << "Saved to " << this->hash_file() << std::endl;
+            }
+            continue;
         } else if (s == "history" || s == "h") {
-            history_display(history);
+            history_display(game);
             continue;
         } else if (s == "pop" || s == "back" || s == "b") {
-            if (boards.size() > 0) {
-                assert_debug(boards.size() == history.size());
-                board = boards.back();
-                boards.pop_back();
-                history.pop_back();
+            if (game.pop()) {
+                this->pondering.update(board);
                 std::cout << board << std::endl;
             } else {
                 std::cout << "No previous board to pop" << std::endl;
             }
             continue;
-        } else {
+        } else if (s.rfind("jump ", 0) == 0 || s.rfind("j ", 0) == 0) {
+            std::string number = trim(s.substr(s.find(' ')));
+            std::size_t ply = std::size_t(std::atol(number.c_str()));
+            if (number.empty() ||
+                number.find_first_not_of("0123456789") != std::string::npos ||
+                ply > game.length()) {
+                std::cout << "No board at ply " << number << " (0 to "
+                          << game.length() << ")" << std::endl;
+            } else {
+                game.jump(ply);
+                this->pondering.update(board);
+                std::cout << board << std::endl;
+            }
+            continue;
+        } else if (Notation::parse(board, raw, m) != Notation::Ok) {
             int t = m.update_from_string(s); // update move from string
             switch (t) {
             case Move::Invalid:
@@ -438,7 +1045,7 @@ int App::run() {
                 continue;
                 break;
             }
-        }
+        } // standard or long algebraic notation, then the other forms
 
         GameResult r; // invalid result
         std::cout << "\n";
@@ -446,12 +1053,31 @@ int App::run() {
         // play move and either continue or end game
         switch ((r = board.play_move(m)).result_type()) {
         case GameResult::Continuing:
-            boards.push_back(std::move(board));
-            board = r.next_board();
+            game.play(m, r.next_board());
             if (!this->quiet()) {
                 std::cout << board << std::endl;
             }
-            history.push_back(m);
+
+            if (game.keys().repeated(board.get_key(),
+                                     board.get_halfmove_clock(), 2)) {
+                std::cout << "Drawn game by threefold repetition."
+                          << std::endl;
+                is_running = false;
+            } else if (board.is_fifty_moves()) {
+                std::cout << "Drawn game by the fifty-move rule."
+                          << std::endl;
+                is_running = false;
+            }
+
+            // keep pondering only if the expected reply was played,
+            // then think on the opponent's time after our own moves
+            this->pondering.update(board);
+            if (this->ponder() && cpu_move && is_running &&
+                this->pondering.start(board, game.keys()) &&
+                this->verbose()) {
+                std::cout << "CPU ponders on "
+                          << this->pondering.expected_move() << std::endl;
+            }
             break;
         case GameResult::Victory:
             if (!this->quiet()) {
@@ -459,10 +1085,8 @@ int App::run() {
             }
             std::cout << !r.winner() << " loses. " << r.winner()
                       << " is victorious." << std::endl;
-            history.push_back(m);
             is_running = false;
-            boards.push_back(std::move(board));
-            board = r.next_board();
+            game.play(m, r.next_board());
             break;
         case GameResult::IllegalMove:
             if (is_running) {
@@ -471,10 +1095,8 @@ int App::run() {
             break;
         case GameResult::Stalemate:
             std::cout << "Drawn game." << std::endl;
-            history.push_back(m);
             is_running = false;
-            boards.push_back(std::move(board));
-            board = r.next_board();
+            game.play(m, r.next_board());
             break;
         default:
             panic("Unknown game result.");
@@ -482,9 +1104,12 @@ int App::run() {
         s.clear(); // clear input buffer for next move
     }
 
+    this->pondering.stop();
+    save_hash();
+
     if (this->verbose()) {
-        history_display(history);
-        std::cout << "\ntotal moves: " << history.size() << "\n";
+        history_display(game);
+        std::cout << "\ntotal moves: " << game.ply() << "\n";
         std::cout << "white cpu thinking time: "
                   << time_to_string(this->white_thinking_time) << "\n";
         std::cout << "black cpu thinking time: "
@@ -0,0 +1,97 @@
+#include "bench.h"
+
+#include "split.h"
+
+// size of the transposition table of the bench (MB)
+static const std::size_t BENCH_HASH = 16;
+
+Bench::Bench(int depth, unsigned threads, int smp) {
+    this->depth = std::max(depth, 1);
+    this->threads = std::max(threads, 1u);
+    this->smp = smp;
+}
+
+Bench::~Bench() {}
+
+const std::vector<std::string> &Bench::positions() {
+    // opening, middlegame, endgame and tactical positions
+    static const std::vector<std::string> fens = {
+        "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1",
+        "r1bqkbnr/pppp1ppp/2n5/4p3/4P3/5N2/PPPP1PPP/RNBQKB1R w KQkq - 2 3",
+        "r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq - 0 1",
+        "r4rk1/1pp1qppp/p1np1n2/2b1p1B1/2B1P1b1/P1NP1N2/1PP1QPPP/R4RK1 w - - 0 "
+        "10",
+        "8/2p5/3p4/KP5r/1R3p1k/8/4P1P1/8 w - - 0 1",
+        "r3k2r/Pppp1ppp/1b3nbN/nP6/BBP1P3/q4N2/Pp1P2PP/R2Q1RK1 w kq - 0 1",
+        "rnbq1k1r/pp1Pbppp/2p5/8/2B5/8/PPP1NnPP/RNBQK2R w KQ - 1 8",
+        "8/8/1p6/3k4/8/2K1P3/8/8 b - - 0 1",
+        "6k1/5ppp/8/8/8/8/5PPP/3R2K1 w - - 0 1",
+        "r1bqkb1r/pppp1ppp/2n2n2/4p2Q/2B1P3/8/PPPP1PPP/RNB1K1NR w KQkq - 4 4",
+    };
+    return fens;
+}
+
+u_int64_t Bench::run(std::ostream &os) {
+    TranspositionTable tt = TranspositionTable(BENCH_HASH);
+    u_int64_t total = 0;
+    int64_t total_ms = 0;
+    const std::vector<std::string> &fens = positions();
+    SearchStats parallel; // split counters of every position
+
+    std::vector<std::unique_ptr<SearchThread>> helpers;
+    std::unique_ptr<SplitSearch> split;
+    if (threads > 1 && smp == Ybwc) {
+        split = std::make_unique<SplitSearch>(threads);
+    } else {
+        for (unsigned i = 1; i < threads; i++) {
+            helpers.push_back(std::make_unique<SearchThread>(&tt));
+        }
+    }
+
+    for (std::size_t i = 0; i < fens.size(); i++) {
+        Board board = Board::from_fen(fens[i]);
+        tt.clear();
+
+        // no limit : a single iteration, the same nodes on every run
+        SearchContext context = SearchContext(History(), &tt);
+        if (split != nullptr) {
+            split->attach(context);
+        }
+        auto start = std::chrono::steady_clock::now();
+        for (std::unique_ptr<SearchThread> &helper : helpers) {
+            helper->start(board, History(), depth - 1);
+        } // the same tree, warming the shared table for the main search
+        u_int64_t nodes =
+            std::get<1>(board.get_next_best_move(depth - 1, context));
+        for (std::unique_ptr<SearchThread> &helper : helpers) {
+            helper->stop();
+            nodes += std::get<1>(helper->wait());
+        }
+        parallel.merge(context.stats);
+        int64_t ms = std::chrono::duration_cast<std::chrono::milliseconds>(
+                         std::chrono::steady_clock::now() - start)
+                         .count();
+        total += nodes;
+        total_ms += ms;
+
+        os << "position " << i + 1 << "/" << fens.size() << ": " << nodes
+           << " nodes, " << ms << " ms\n";
+    }
+
+    os << "\n";
+    if (threads > 1) {
+        os << "threads: " << threads << " ("
+           << (smp == Ybwc ? "young brothers wait" : "shared hash") << ")\n";
+    }
+    if (parallel.splits > 0) {
+        os << "splits: " << parallel.splits << ", younger brothers: "
+           << parallel.tasks << ", stolen: " << parallel.steals
+           << ", cancelled: " << parallel.aborted << "\n";
+    }
+    os << "depth: " << depth << "\n";
+    os << "nodes: " << total << "\n";
+    os << "time: " << total_ms << " ms\n";
+    os << "nps: " << total * 1000 / u_int64_t(std::max(total_ms, int64_t(1)))
+       << std::endl;
+    return total;
+}
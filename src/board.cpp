@@ -1,198 +1,148 @@
 #include "board.h"
 
+#include "attacks.h"
 #include "piece.h"
+#include "profile.h"
 #include "result.h"
-
-CastlingRights::CastlingRights() {
-    kingside = true;
-    queenside = true;
+#include "split.h"
+#include "zobrist.h"
+
+static_assert(std::is_trivially_copyable_v<Board> &&
+                  std::has_unique_object_representations_v<Board> &&
+                  sizeof(Board) == 96,
+              "boards should be 96 bytes copied with memcpy");
+static_assert(sizeof(UndoRecord) == 32,
+              "undo records should keep a long game in a few kilobytes");
+
+/**
+ * @brief Get the kingside castling bit of a player
+ *
+ * @param color color
+ * @return int - bit
+ */
+static int kingside_bit(const Color &color) {
+    return color == Color::White ? Board::WhiteKingside : Board::BlackKingside;
 }
 
-CastlingRights::~CastlingRights() {}
-
-bool CastlingRights::can_kingside_castle() const { return this->kingside; }
-
-bool CastlingRights::can_queenside_castle() const { return this->queenside; }
-
-void CastlingRights::disable_kingside() { this->kingside = false; }
-
-void CastlingRights::disable_queenside() { this->queenside = false; }
-
-void CastlingRights::disable_all() {
-    disable_kingside();
-    disable_queenside();
+/**
+ * @brief Get the queenside castling bit of a player
+ *
+ * @param color color
+ * @return int - bit
+ */
+static int queenside_bit(const Color &color) {
+    return color == Color::White ? Board::WhiteQueenside
+                                 : Board::BlackQueenside;
 }
 
-void CastlingRights::enable_kingside() { kingside = true; }
+BoardBuilder::BoardBuilder() { board.castling = 0; }
 
-void CastlingRights::enable_queenside() { queenside = true; }
-
-void CastlingRights::enable_all() {
-    enable_kingside();
-    enable_queenside();
-}
-
-BoardBuilder::BoardBuilder() {
-    Board *new_board = new Board();
-    new_board->white_castling_rights->disable_all();
-    new_board->black_castling_rights->disable_all();
-    board = new_board;
-}
-
-BoardBuilder::BoardBuilder(const Board &board) {
-    this->board = new Board(board);
-}
+BoardBuilder::BoardBuilder(const Board &board) : board(board) {}
 
 BoardBuilder::~BoardBuilder() {}
 
-BoardBuilder BoardBuilder::row(const Piece &piece) {
+BoardBuilder &BoardBuilder::row(const Piece &piece) {
     Position pos = piece.get_pos();
     while (pos.col() > 0) {
         pos = pos.next_left();
     } // move to leftmost position
 
     for (int i = 0; i < 8; i++) {
-        this->board->set_square(pos, Square::from_piece(piece.move_to(pos)));
+        this->board.set_square(pos, Square::from_piece(piece.move_to(pos)));
         pos = pos.next_right();
     } // move to rightmost position and set square
 
     return *this;
 }
 
-BoardBuilder BoardBuilder::column(const Piece &piece) {
+BoardBuilder &BoardBuilder::column(const Piece &piece) {
     Position pos = piece.get_pos();
     while (pos.row() > 0) {
         pos = pos.next_below();
     } // move to bottommost position
 
     for (int i = 0; i < 8; i++) {
-        this->board->set_square(pos, Square::from_piece(piece.move_to(pos)));
+        this->board.set_square(pos, Square::from_piece(piece.move_to(pos)));
         pos = pos.next_above();
     } // move to topmost position and set square
 
     return *this;
 }
 
-BoardBuilder BoardBuilder::piece(Piece *piece) {
+BoardBuilder &BoardBuilder::piece(Piece *piece) {
     Position pos = piece->get_pos();
-    this->board->set_square(pos, Square::from_piece(piece));
+    this->board.set_square(pos, Square::from_piece(piece));
     return *this;
 }
 
-BoardBuilder BoardBuilder::enable_castling() {
-    this->board->white_castling_rights->enable_all();
-    this->board->black_castling_rights->enable_all();
+BoardBuilder &BoardBuilder::enable_castling() {
+    this->board.castling = Board::WhiteKingside | Board::WhiteQueenside |
+                           Board::BlackKingside | Board::BlackQueenside;
     return *this;
 }
 
-BoardBuilder BoardBuilder::disable_castling() {
-    this->board->white_castling_rights->disable_all();
-    this->board->black_castling_rights->disable_all();
+BoardBuilder &BoardBuilder::disable_castling() {
+    this->board.castling = 0;
     return *this;
 }
 
-BoardBuilder BoardBuilder::enable_queenside_castle(const Color &color) {
-    switch (color) {
-    case Color::White:
-        this->board->white_castling_rights->enable_queenside();
-        break;
-    case Color::Black:
-        this->board->black_castling_rights->enable_queenside();
-        break;
-    }
+BoardBuilder &BoardBuilder::enable_queenside_castle(const Color &color) {
+    this->board.castling |= queenside_bit(color);
     return *this;
 }
 
-BoardBuilder BoardBuilder::disable_queenside_castle(const Color &color) {
-    switch (color) {
-    case Color::White:
-        this->board->white_castling_rights->disable_queenside();
-        break;
-    case Color::Black:
-        this->board->black_castling_rights->disable_queenside();
-        break;
-    }
+BoardBuilder &BoardBuilder::disable_queenside_castle(const Color &color) {
+    this->board.castling &= ~queenside_bit(color);
     return *this;
 }
 
-BoardBuilder BoardBuilder::enable_kingside_castle(const Color &color) {
-    switch (color) {
-    case Color::White:
-        this->board->white_castling_rights->enable_kingside();
-        break;
-    case Color::Black:
-        this->board->black_castling_rights->enable_kingside();
-        break;
-    }
+BoardBuilder &BoardBuilder::enable_kingside_castle(const Color &color) {
+    this->board.castling |= kingside_bit(color);
     return *this;
 }
 
-BoardBuilder BoardBuilder::disable_kingside_castle(const Color &color) {
-    switch (color) {
-    case Color::White:
-        this->board->white_castling_rights->disable_kingside();
-        break;
-    case Color::Black:
-        this->board->black_castling_rights->disable_kingside();
-        break;
-    }
+BoardBuilder &BoardBuilder::disable_kingside_castle(const Color &color) {
+    this->board.castling &= ~kingside_bit(color);
     return *this;
 }
 
-Board BoardBuilder::build() const { return *board; }
+Board BoardBuilder::build() const {
+    Board result = board;
+    result.key = result.compute_key(); // castling rights may have changed
+    return result;
+}
 
 Board::Board() {
-    for (int i = 0; i < 64; i++) {
-        squares[i] = EMPTY_SQUARE; // set all squares to empty
-    }
+    std::memset(static_cast<void *>(this), 0, sizeof(Board)); // empty squares
     turn = Color::White;
-    white_castling_rights = new CastlingRights();
-    black_castling_rights = new CastlingRights();
-    en_passant = nullptr;
-
-    for (unsigned i = 0; i < 7; i++) {
-        white_takes[i] = 0;
-        black_takes[i] = 0;
-    }
-}
-
-Board::Board(const Board &board) {
-    for (unsigned i = 0; i < 64; i++) {
-        squares[i] = Square(board.squares[i]); // copy all squares
-    }
-    turn = board.turn;
-    en_passant = board.en_passant;
-    white_castling_rights = new CastlingRights(*board.white_castling_rights);
-    black_castling_rights = new CastlingRights(*board.black_castling_rights);
-
-    for (unsigned i = 0; i < 7; i++) {
-        white_takes[i] = board.white_takes[i];
-        black_takes[i] = board.black_takes[i];
-    }
+    en_passant = -1;
+    castling = WhiteKingside | WhiteQueenside | BlackKingside | BlackQueenside;
+    fullmove_number = 1;
+    key = compute_key();
 }
 
 Board Board::new_board() {
     BoardBuilder builder;
 
     // fen = "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1"
-    Board board = builder.piece(new Rook(Color::Black, A8, true))
-                      .piece(new Knight(Color::Black, B8, true))
-                      .piece(new Bishop(Color::Black, C8, true))
-                      .piece(new Queen(Color::Black, D8, true))
-                      .piece(new King(Color::Black, E8, true))
-                      .piece(new Bishop(Color::Black, F8, true))
-                      .piece(new Knight(Color::Black, G8, true))
-                      .piece(new Rook(Color::Black, H8, true))
+    Board board = builder.piece(Piece::from_id(Piece::Rook, Color::Black, A8))
+                      .piece(Piece::from_id(Piece::Knight, Color::Black, B8))
+                      .piece(Piece::from_id(Piece::Bishop, Color::Black, C8))
+                      .piece(Piece::from_id(Piece::Queen, Color::Black, D8))
+                      .piece(Piece::from_id(Piece::King, Color::Black, E8))
+                      .piece(Piece::from_id(Piece::Bishop, Color::Black, F8))
+                      .piece(Piece::from_id(Piece::Knight, Color::Black, G8))
+                      .piece(Piece::from_id(Piece::Rook, Color::Black, H8))
                       .row(Pawn(Color::Black, A7, true))
                       .row(Pawn(Color::White, A2, true))
-                      .piece(new Rook(Color::White, A1, true))
-                      .piece(new Knight(Color::White, B1, true))
-                      .piece(new Bishop(Color::White, C1, true))
-                      .piece(new Queen(Color::White, D1, true))
-                      .piece(new King(Color::White, E1, true))
-                      .piece(new Bishop(Color::White, F1, true))
-                      .piece(new Knight(Color::White, G1, true))
-                      .piece(new Rook(Color::White, H1, true))
+                      .piece(Piece::from_id(Piece::Rook, Color::White, A1))
+                      .piece(Piece::from_id(Piece::Knight, Color::White, B1))
+                      .piece(Piece::from_id(Piece::Bishop, Color::White, C1))
+                      .piece(Piece::from_id(Piece::Queen, Color::White, D1))
+                      .piece(Piece::from_id(Piece::King, Color::White, E1))
+                      .piece(Piece::from_id(Piece::Bishop, Color::White, F1))
+                      .piece(Piece::from_id(Piece::Knight, Color::White, G1))
+                      .piece(Piece::from_id(Piece::Rook, Color::White, H1))
                       .enable_castling()
                       .build();
 
@@ -202,93 +152,323 @@ Board Board::new_board() {
     return board;
 }
 
-Board Board::from_fen(const std::string &fen) {
-    static const std::map<char, int> piece_map = {
-        {'k', Piece::King},   {'q', Piece::Queen},  {'r', Piece::Rook},
-        {'b', Piece::Bishop}, {'n', Piece::Knight}, {'p', Piece::Pawn},
-    };
+/**
+ * @brief Get the shared position of an en passant square : boards only keep
+ * its index and `get_en_passant` points here
+ *
+ * @param pos position on the board
+ * @return Position* - square
+ */
+static Position *en_passant_square(const Position &pos) {
+    static Position *positions = []() {
+        static Position table[64];
+        for (int i = 0; i < 64; i++) {
+            table[i] = Position(i / 8, i % 8);
+        }
+        return table;
+    }();
+    return &positions[pos.row() * 8 + pos.col()];
+}
 
-    BoardBuilder builder;
-    std::string fen_board = fen.substr(0, fen.find(' '));
-    int file = 0, rank = 7, piece_id;
+/**
+ * @brief Get the type of a piece from its fen letter
+ *
+ * @param c letter, upper case for white
+ * @return int - type, Piece::None if not a piece
+ */
+static int fen_piece_type(char c) {
+    switch (c) {
+    case 'K':
+    case 'k':
+        return Piece::King;
+    case 'Q':
+    case 'q':
+        return Piece::Queen;
+    case 'R':
+    case 'r':
+        return Piece::Rook;
+    case 'B':
+    case 'b':
+        return Piece::Bishop;
+    case 'N':
+    case 'n':
+        return Piece::Knight;
+    case 'P':
+    case 'p':
+        return Piece::Pawn;
+    default:
+        return Piece::None;
+    }
+}
+
+/**
+ * @brief Get the fen letter of a piece
+ *
+ * @param piece piece
+ * @return char - letter, upper case for white
+ */
+static char fen_piece_letter(const Piece *piece) {
+    static const char letters[] = "?kpnbrq";
+    char letter = letters[piece->get_type()];
+    return piece->get_color() == Color::White ? char(letter - 'a' + 'A')
+                                              : letter;
+}
+
+/**
+ * @brief takes the next field of a fen, which must follow a single space
+ *
+ * @param fen rest of the fen, the field is removed from it
+ * @param name name of the field (for errors)
+ * @return std::string_view - field
+ */
+static std::string_view fen_field(std::string_view &fen, const char *name) {
+    if (fen.empty() || fen[0] != ' ' || fen.size() == 1 || fen[1] == ' ') {
+        throw std::invalid_argument(std::string("Missing ") + name +
+                                    " in FEN");
+    }
+    fen.remove_prefix(1);
+    std::string_view field = fen.substr(0, fen.find(' '));
+    fen.remove_prefix(field.size());
+    return field;
+}
+
+/**
+ * @brief reads a counter of a fen (no sign, no leading zero, 16 bits)
+ *
+ * @param field field
+ * @param name name of the field (for errors)
+ * @return unsigned - value
+ */
+static unsigned fen_number(std::string_view field, const char *name) {
+    bool valid = !field.empty() && field.size() <= 5 &&
+                 (field[0] != '0' || field.size() == 1);
+    unsigned value = 0;
+    for (char c : field) {
+        valid = valid && c >= '0' && c <= '9';
+        value = value * 10 + unsigned(c - '0');
+    }
+    if (!valid || value > 0xffff) {
+        throw std::invalid_argument(std::string("Invalid ") + name +
+                                    " in FEN: '" + std::string(field) + "'");
+    }
+    return value;
+}
+
+Board Board::from_fen(std::string_view fen) {
+    return parse_fen(fen, false, nullptr);
+}
+
+Board Board::from_epd(std::string_view line, std::string_view *operations) {
+    return parse_fen(line, true, operations);
+}
 
-    for (const unsigned char c : fen_board) {
-        assert_debug(file <= 8 && rank >= -1);
+Board Board::parse_fen(std::string_view fen, bool epd,
+                       std::string_view *operations) {
+    Board board;
+    board.castling = 0;
+
+    // piece placement, from the 8th rank down to the 1st
+    std::string_view placement = fen.substr(0, fen.find(' '));
+    fen.remove_prefix(placement.size());
+    int rank = 7, file = 0;
+    bool digit = false; // two digits in a row are not allowed
+    for (char c : placement) {
         if (c == '/') {
-            file = 0;
+            if (file != 8) {
+                throw std::invalid_argument("Rank " + std::to_string(rank + 1) +
+                                            " of FEN has " +
+                                            std::to_string(file) + " squares");
+            }
+            if (rank == 0) {
+                throw std::invalid_argument("FEN has more than 8 ranks");
+            }
             rank--;
+            file = 0;
+            digit = false;
+            continue;
+        }
+        if (c >= '1' && c <= '8') {
+            if (digit) {
+                throw std::invalid_argument("Consecutive digits in rank " +
+                                            std::to_string(rank + 1) +
+                                            " of FEN");
+            }
+            file += c - '0';
+            digit = true;
         } else {
-            if (isdigit(c)) {
-                file += c - '0';
-            } else {
-                try {
-                    piece_id = piece_map.at(tolower(c));
-                } catch (std::out_of_range &e) {
-                    throw std::invalid_argument("Invalid piece in FEN");
-                }
-                assert_debug(file < 8 && rank > -1);
-                Color color = isupper(c) ? Color::White : Color::Black;
-                Position pos = Position(rank, file);
-
-                Piece *piece_ptr = Piece::from_id(piece_id, color, pos);
-                std::stringstream ss;
-                ss << "Placing " << piece_ptr->to_string() << " at " << pos;
-                std_debug(ss.str());
-
-                builder.piece(piece_ptr);
-                file++;
+            int type = fen_piece_type(c);
+            if (type == Piece::None) {
+                throw std::invalid_argument(std::string("Invalid piece '") + c +
+                                            "' in FEN");
+            }
+            if (file < 8) {
+                Color color = c < 'a' ? Color::White : Color::Black;
+                board.add_piece(
+                    Piece::from_id(type, color, Position(rank, file)));
             }
+            file++;
+            digit = false;
         }
+        if (file > 8) {
+            throw std::invalid_argument("Rank " + std::to_string(rank + 1) +
+                                        " of FEN has more than 8 squares");
+        }
+    }
+    if (rank != 0 || file != 8) {
+        throw std::invalid_argument(
+            placement.empty() ? std::string("Missing piece placement in FEN")
+                              : "FEN ends in rank " + std::to_string(rank + 1) +
+                                    " after " + std::to_string(file) +
+                                    " squares");
     }
 
-    // get turn
-    Color turn =
-        fen.find("w") != std::string::npos ? Color::White : Color::Black;
+    // side to move
+    std::string_view turn = fen_field(fen, "side to move");
+    if (turn != "w" && turn != "b") {
+        throw std::invalid_argument("Invalid side to move in FEN: '" +
+                                    std::string(turn) + "'");
+    }
+    board.turn = turn == "w" ? Color::White : Color::Black;
+
+    // castling rights, a subset of KQkq in this order
+    std::string_view castling = fen_field(fen, "castling rights");
+    if (castling != "-") {
+        static const std::string_view order = "KQkq";
+        std::string_view::size_type next = 0;
+        for (char c : castling) {
+            std::string_view::size_type i = order.find(c, next);
+            if (i == std::string_view::npos) {
+                throw std::invalid_argument(
+                    "Invalid castling rights in FEN: '" +
+                    std::string(castling) + "'");
+            }
+            next = i + 1;
+            board.castling |= 1 << i; // same order as the bits
+        }
+    }
 
-    // get castling rights
-    std::string castling_rights = fen.substr(fen.find(' ') + 1);
-    if (castling_rights.find('K') != std::string::npos) {
-        std_debug("Enabling white kingside castle");
-        builder.enable_kingside_castle(Color::White);
+    // en passant target, behind a pawn that just moved two squares
+    std::string_view en_passant = fen_field(fen, "en passant square");
+    if (en_passant != "-") {
+        char target = board.turn == Color::White ? '6' : '3';
+        if (en_passant.size() != 2 || en_passant[0] < 'a' ||
+            en_passant[0] > 'h' || en_passant[1] != target) {
+            throw std::invalid_argument("Invalid en passant square in FEN: '" +
+                                        std::string(en_passant) + "'");
+        }
+        board.en_passant =
+            int8_t((en_passant[1] - '1') * 8 + en_passant[0] - 'a');
     }
-    if (castling_rights.find('Q') != std::string::npos) {
-        std_debug("Enabling white queenside castle");
-        builder.enable_queenside_castle(Color::White);
+
+    // counters, both or none (operations of an EPD line are not numbers)
+    if (!fen.empty() &&
+        (!epd || (fen.size() > 1 && fen[1] >= '0' && fen[1] <= '9'))) {
+        board.halfmove_clock =
+            fen_number(fen_field(fen, "halfmove clock"), "halfmove clock");
+        board.fullmove_number =
+            fen_number(fen_field(fen, "fullmove number"), "fullmove number");
+        if (board.fullmove_number == 0) {
+            throw std::invalid_argument("Invalid fullmove number in FEN: '0'");
+        }
     }
-    if (castling_rights.find('k') != std::string::npos) {
-        std_debug("Enabling black kingside castle");
-        builder.enable_kingside_castle(Color::Black);
+
+    if (epd) {
+        while (!fen.empty() && fen[0] == ' ') {
+            fen.remove_prefix(1);
+        }
+        if (operations != nullptr) {
+            *operations = fen;
+        }
+    } else if (!fen.empty()) {
+        throw std::invalid_argument("Unexpected characters after FEN: '" +
+                                    std::string(fen) + "'");
     }
-    if (castling_rights.find('q') != std::string::npos) {
-        std_debug("Enabling black queenside castle");
-        builder.enable_queenside_castle(Color::Black);
+
+    board.key = board.compute_key();
+    return board;
+}
+
+std::string Board::to_fen() const {
+    std::string fen;
+    fen.reserve(96);
+
+    // squares are stored from a8 to h1, the order of the fen
+    int empty = 0;
+    for (int i = 0; i < 64; i++) {
+        Piece *piece = this->piece_at(i);
+        if (piece == nullptr) {
+            empty++;
+        } else {
+            if (empty > 0) {
+                fen += char('0' + empty);
+                empty = 0;
+            }
+            fen += fen_piece_letter(piece);
+        }
+        if (i % 8 == 7) {
+            if (empty > 0) {
+                fen += char('0' + empty);
+                empty = 0;
+            }
+            fen += i == 63 ? ' ' : '/';
+        }
     }
 
-    // get en passant
-    std::string en_passant =
-        castling_rights.substr(castling_rights.find(' ', 5) + 1);
-    std::stringstream ss;
-    Position *en_passant_pos;
-    // std::cout << en_passant << std::endl;
-    if (en_passant.find('-') == std::string::npos) {
-        en_passant_pos = new Position(en_passant.substr(0, 2));
-        ss << "En passant at " << *en_passant_pos;
-        std_debug(ss.str());
+    fen += this->turn == Color::White ? "w " : "b ";
+    int mask = this->get_castling_mask();
+    if (mask == 0) {
+        fen += '-';
+    }
+    for (int i = 0; i < 4; i++) {
+        if (mask & (1 << i)) {
+            fen += "KQkq"[i];
+        }
+    }
+    fen += ' ';
+    if (this->en_passant < 0) {
+        fen += '-';
     } else {
-        en_passant_pos = nullptr;
-        ss << "No en passant";
-        std_debug(ss.str());
+        fen += char('a' + this->en_passant % 8);
+        fen += char('1' + this->en_passant / 8);
     }
+    fen += ' ';
+    fen += std::to_string(this->halfmove_clock);
+    fen += ' ';
+    fen += std::to_string(this->fullmove_number);
+    return fen;
+}
 
-    Board board = builder.build();
-    board.set_turn(turn);
-    board.en_passant = en_passant_pos;
+std::string Board::snapshot() const {
+    return std::string(reinterpret_cast<const char *>(this), sizeof(Board));
+}
 
+Board Board::from_snapshot(std::string_view bytes) {
+    if (bytes.size() != sizeof(Board)) {
+        throw std::invalid_argument("Invalid board snapshot size: " +
+                                    std::to_string(bytes.size()));
+    }
+    Board board;
+    std::memcpy(static_cast<void *>(&board), bytes.data(), sizeof(Board));
+
+    // every field is an integer, so any bytes are safe to check
+    bool valid = board.turn == Color::White || board.turn == Color::Black;
+    for (u_int8_t id : board.squares) {
+        int type = id & Piece::type_mask, color = id & ~Piece::type_mask;
+        valid = valid && (id == 0 || (type >= Piece::King &&
+                                      type <= Piece::Queen &&
+                                      (color == Piece::White ||
+                                       color == Piece::Black)));
+    }
+    valid = valid && board.en_passant >= -1 && board.en_passant < 64 &&
+            board.castling < 16 && board.fullmove_number > 0 &&
+            board.reserved[0] == 0 && board.reserved[1] == 0 &&
+            board.reserved[2] == 0;
+    if (!valid || board.key != board.compute_key()) {
+        throw std::invalid_argument("Invalid board snapshot");
+    }
     return board;
 }
 
-Board::~Board() {}
-
 std::string Board::end_fen() const {
     std::string fen = "";
 
@@ -306,8 +486,8 @@ std::string Board::end_fen() const {
 
 double Board::value_for(const Color &ally_color) const {
     double sum = 0;
-    for (Square square : this->squares) {
-        Piece *piece = square.get_piece();
+    for (int i = 0; i < 64; i++) {
+        Piece *piece = this->piece_at(i);
         if (piece == nullptr) {
             continue;
         }
@@ -323,12 +503,42 @@ double Board::value_for(const Color &ally_color) const {
 
 Color Board::get_current_player_color() const { return this->turn; }
 
+Piece *Board::piece_at(int index) const {
+    return Piece::from_square(this->squares[index], index);
+}
+
 Square Board::get_square(const Position &pos) const {
-    return this->squares[((7 - pos.row()) * 8 + pos.col())];
+    return Square(this->piece_at((7 - pos.row()) * 8 + pos.col()));
+}
+
+Board Board::apply_promotion(const Move &move, int promotion) {
+    Piece *piece = this->get_piece(move.from());
+    Board result = this->apply_eval_move(move, true);
+    if (promotion != Piece::Queen && move.move_type() == Move::PieceMove &&
+        piece != nullptr && piece->get_type() == Piece::Pawn &&
+        (move.to().row() == 0 || move.to().row() == 7)) {
+        result.set_square(move.to(),
+                          Square::from_piece(Piece::from_id(
+                              promotion, piece->get_color(), move.to())));
+    } // the cpu promotes to a queen, put the piece asked for instead
+    return result;
 }
 
 void Board::set_square(const Position &pos, const Square &square) {
-    this->squares[((7 - pos.row()) * 8 + pos.col())] = square;
+    int index = (7 - pos.row()) * 8 + pos.col();
+    Piece *old_piece = this->piece_at(index);
+    Piece *new_piece = square.get_piece();
+
+    // keep the zobrist key in sync with the pieces on the board
+    if (old_piece != nullptr) {
+        key ^= Zobrist::piece(old_piece->get_type(), old_piece->get_color(),
+                              pos);
+    }
+    if (new_piece != nullptr) {
+        key ^= Zobrist::piece(new_piece->get_type(), new_piece->get_color(),
+                              pos);
+    }
+    this->squares[index] = new_piece == nullptr ? 0 : new_piece->get_id();
 }
 
 void Board::add_piece(Piece *piece) {
@@ -369,8 +579,8 @@ bool Board::has_no_piece(const Position &pos) {
 
 Position Board::get_king_position(const Color &color) const {
     Position king_pos = Position(-1, -1);
-    for (Square square : this->squares) {
-        Piece *piece = square.get_piece();
+    for (int i = 0; i < 64; i++) {
+        Piece *piece = this->piece_at(i);
         if (piece == nullptr) {
             continue;
         }
@@ -381,39 +591,158 @@ Position Board::get_king_position(const Color &color) const {
     return king_pos;
 }
 
-bool Board::is_threatened(const Position &pos, const Color &ally_color) {
-    for (int i = 0; i < 64; i++) {
-        Square square = this->squares[i];
-
-        int row = 7 - (i / 8);
-        int col = i % 8;
-        Position square_pos = Position(row, col);
-
-        // if the square position is either not in the same file or rank,
-        // not in the same diagonal, as the position we are checking,
-        // or does not represent a knight move, we can skip it
-        if (!square_pos.is_orthogonal_to(pos) &&
-            !square_pos.is_diagonal_to(pos) &&
-            !square_pos.is_knight_move(pos)) {
-            continue;
+u_int64_t Board::attackers(const Position &pos, const Color &ally_color,
+                           bool first) const {
+    int enemy = ally_color == Color::White ? Piece::Black : Piece::White;
+    // a square held by the other side is defended, not attacked
+    if ((this->squares[pos.index() ^ 56] & Piece::color_mask) == enemy) {
+        return 0;
+    }
+
+    u_int64_t result = 0;
+    auto leapers = [&](u_int64_t mask, int id) {
+        for (; mask != 0; mask &= mask - 1) {
+            int index = std::countr_zero(mask);
+            if (this->squares[index ^ 56] == id) {
+                result |= u_int64_t(1) << index;
+            }
         }
+        return first && result != 0;
+    };
+    if (leapers(Attacks::pawn(ally_color, pos), Piece::Pawn | enemy) ||
+        leapers(Attacks::knight(pos).mask, Piece::Knight | enemy) ||
+        leapers(Attacks::king(pos).mask, Piece::King | enemy)) {
+        return result;
+    }
 
-        Piece *piece = square.get_piece();
-        if (piece == nullptr) {
-            continue;
+    // sliding pieces : the first piece met in each direction
+    static const int directions[8][2] = {{1, 0}, {-1, 0}, {0, 1},  {0, -1},
+                                         {1, 1}, {1, -1}, {-1, 1}, {-1, -1}};
+    for (int d = 0; d < 8; d++) {
+        int slider = (d < 4 ? Piece::Rook : Piece::Bishop) | enemy;
+        int row = pos.row() + directions[d][0];
+        int col = pos.col() + directions[d][1];
+        for (; row >= 0 && row < 8 && col >= 0 && col < 8;
+             row += directions[d][0], col += directions[d][1]) {
+            int id = this->squares[(7 - row) * 8 + col];
+            if (id == 0) {
+                continue;
+            }
+            if (id == slider || id == (Piece::Queen | enemy)) {
+                result |= u_int64_t(1) << (row * 8 + col);
+                if (first) {
+                    return result;
+                }
+            }
+            break;
         }
-        if (piece->get_color() == ally_color) {
-            continue;
+    }
+    return result;
+}
+
+// material values of the piece types (as `get_material_value`), none first
+static const int EXCHANGE_VALUES[7] = {0, 20000, 100, 320, 330, 500, 900};
+
+/**
+ * @brief Get the pieces of both colors attacking a square, sliders being
+ * seen through empty squares only : a slider behind a piece that took on
+ * the square (x-ray) shows up once it is removed from `occupied`
+ *
+ * @param pos position (on the board)
+ * @param types squares of each piece type (a1 is bit 0)
+ * @param colors squares of the white and of the black pieces
+ * @param occupied squares still occupied
+ * @return u_int64_t - square indexes of the attackers (a1 is bit 0)
+ */
+static u_int64_t exchange_attackers(const Position &pos,
+                                    const u_int64_t (&types)[7],
+                                    const u_int64_t (&colors)[2],
+                                    u_int64_t occupied) {
+    u_int64_t result =
+        (Attacks::pawn(Color::Black, pos) & types[Piece::Pawn] & colors[0]) |
+        (Attacks::pawn(Color::White, pos) & types[Piece::Pawn] & colors[1]) |
+        (Attacks::knight(pos).mask & types[Piece::Knight]) |
+        (Attacks::king(pos).mask & types[Piece::King]);
+    u_int64_t sliders =
+        (Attacks::diagonals(pos) &
+         (types[Piece::Bishop] | types[Piece::Queen])) |
+        ((Attacks::col(pos) | Attacks::row(pos)) &
+         (types[Piece::Rook] | types[Piece::Queen]));
+    for (sliders &= occupied; sliders != 0; sliders &= sliders - 1) {
+        Position from = Position::from_index(std::countr_zero(sliders));
+        if ((pos.squares_between(from) & occupied) == 0) {
+            result |= sliders & -sliders;
         }
-        if (piece->is_legal_attack(pos, *this)) {
-            return true;
+    }
+    return result & occupied;
+}
+
+int Board::see(const Move &move) const {
+    if (move.move_type() != Move::PieceMove) {
+        return 0;
+    }
+    const Position &from = move.from();
+    const Position &to = move.to();
+    u_int64_t types[7] = {0}, colors[2] = {0}, occupied = 0;
+    for (int i = 0; i < 64; i++) {
+        if (this->squares[i] != 0) {
+            u_int64_t bit = u_int64_t(1) << (i ^ 56);
+            occupied |= bit;
+            types[this->squares[i] & Piece::type_mask] |= bit;
+            colors[(this->squares[i] & Piece::Black) != 0] |= bit;
         }
     }
-    return false;
+
+    int attacker = this->squares[from.index() ^ 56] & Piece::type_mask;
+    int victim = this->squares[to.index() ^ 56] & Piece::type_mask;
+    if (attacker == Piece::Pawn && victim == 0 &&
+        to.index() == this->en_passant) {
+        victim = Piece::Pawn;
+        occupied ^= u_int64_t(1) << (from.row() * 8 + to.col());
+    } // the pawn taken en passant is not on the square
+
+    // gain[d] : material won by the side making the d-th capture, if the
+    // exchange stopped right after it (a capture per piece at most)
+    int gain[33];
+    int d = 0;
+    gain[0] = EXCHANGE_VALUES[victim];
+    int side = (this->squares[from.index() ^ 56] & Piece::Black) != 0;
+    u_int64_t attacker_bit = u_int64_t(1) << from.index();
+    do {
+        d++;
+        gain[d] = EXCHANGE_VALUES[attacker] - gain[d - 1];
+        if (std::max(-gain[d - 1], gain[d]) < 0) {
+            break;
+        } // whoever is to take next already lost : the rest changes nothing
+
+        // the piece that took leaves its square, uncovering x-rays
+        occupied ^= attacker_bit;
+        u_int64_t attackers = exchange_attackers(to, types, colors, occupied);
+        side ^= 1;
+        attacker_bit = 0;
+        for (int type : {Piece::Pawn, Piece::Knight, Piece::Bishop,
+                         Piece::Rook, Piece::Queen, Piece::King}) {
+            u_int64_t candidates = attackers & types[type] & colors[side];
+            if (candidates != 0) {
+                attacker_bit = candidates & -candidates;
+                attacker = type;
+                break;
+            }
+        } // the least valuable attacker takes back
+    } while (attacker_bit != 0);
+
+    // each side may stop taking when going on loses
+    while (--d) {
+        gain[d - 1] = -std::max(-gain[d - 1], gain[d]);
+    }
+    return gain[0];
+}
+
+bool Board::is_threatened(const Position &pos, const Color &ally_color) {
+    return pos.is_on_board() && this->attackers(pos, ally_color, true) != 0;
 }
 
 bool Board::is_in_check(const Color &color) {
-    state = State::CHECKING_CHECK;
     Position king_pos = this->get_king_position(color);
     if (king_pos.is_off_board()) {
         return false;
@@ -424,6 +753,7 @@ bool Board::is_in_check(const Color &color) {
 
 bool Board::is_legal_move(const Move &move, const Color &player_color,
                           const bool &cpu) {
+    profile_scope(Profile::Legality);
     bool tmp;
     Piece *piece;
     Position *en_passant, from, to;
@@ -450,7 +780,7 @@ bool Board::is_legal_move(const Move &move, const Color &player_color,
             return false;
 
         case Piece::Pawn:
-            en_passant = this->en_passant;
+            en_passant = this->get_en_passant();
             if (en_passant == nullptr) {
                 tmp = false;
             } else {
@@ -460,10 +790,10 @@ bool Board::is_legal_move(const Move &move, const Color &player_color,
                      *en_passant == to) &&
                     piece->get_color() == player_color;
             }
-            return tmp ||
-                   (piece->is_legal_move(to, *this) &&
-                    piece->get_color() == player_color &&
-                    !this->apply_move(move, cpu).is_in_check(player_color));
+            // taking en passant may uncover the king as well
+            return (tmp || (piece->is_legal_move(to, *this) &&
+                            piece->get_color() == player_color)) &&
+                   !this->apply_move(move, cpu).is_in_check(player_color);
 
         default:
             return piece->is_legal_move(to, *this) &&
@@ -477,35 +807,206 @@ bool Board::is_legal_move(const Move &move, const Color &player_color,
 }
 
 Board Board::apply_eval_move(const Move &move, const bool &cpu) {
-    state = State::PLAYING_MOVES;
     return this->apply_move(move, cpu).change_turn();
 }
 
-std::vector<Move> Board::get_legal_moves() {
-    state = State::GETTING_LEGAL_MOVES;
-    std::vector<Move> result;
-    Color color = this->get_current_player_color();
+/**
+ * @brief adds a move to a list
+ *
+ * @param moves list
+ * @param type type of the move
+ * @param from starting square index (a1 is 0)
+ * @param to ending square index (a1 is 0)
+ */
+static void add_move(std::vector<Move> &moves, int type, int from = 0,
+                     int to = 0) {
+    Move move;
+    move.move_type() = type;
+    if (type == Move::PieceMove) {
+        move.from() = Position::from_index(from);
+        move.to() = Position::from_index(to);
+    }
+    moves.push_back(move);
+}
 
-    for (Square square : this->squares) {
-        if (square.is_empty()) {
-            continue;
+template <Color Us, int Type>
+void Board::generate_moves(std::vector<Move> &moves) {
+    constexpr int ally = Us == Color::White ? Piece::White : Piece::Black;
+    constexpr int up = Us == Color::White ? 8 : -8; // one row forward
+    constexpr int start_row = Us == Color::White ? 1 : 6;
+    constexpr int last_row = Us == Color::White ? 7 : 0;
+
+    u_int64_t occupied = 0, allies = 0;
+    for (int i = 0; i < 64; i++) {
+        if (this->squares[i] != 0) {
+            occupied |= u_int64_t(1) << (i ^ 56);
         }
-        Piece *piece = square.get_piece();
-        if (piece->get_color() != color) {
+        if (this->squares[i] & ally) {
+            allies |= u_int64_t(1) << (i ^ 56);
+        }
+    }
+    u_int64_t enemies = occupied & ~allies;
+
+    // squares the pieces may go to, the king goes anywhere but on allies
+    u_int64_t targets = ~allies;
+    if constexpr (Type == Captures) {
+        targets = enemies;
+    } else if constexpr (Type == Quiets) {
+        targets = ~occupied;
+    } else if constexpr (Type == Evasions) {
+        // only the king moves out of a double check, a single check may
+        // also be answered by taking the checker or stepping in between
+        Position king = this->get_king_position(Us);
+        u_int64_t checkers =
+            king.is_on_board() ? this->attackers(king, Us, false) : 0;
+        targets = 0;
+        if (std::popcount(checkers) == 1) {
+            targets = checkers | king.squares_between(Position::from_index(
+                                     std::countr_zero(checkers)));
+        }
+    }
+    u_int64_t king_targets = Type == Evasions ? ~allies : targets;
+
+    std::size_t first = moves.size();
+    Position *en_passant = this->get_en_passant();
+
+    // squares are visited from a8 to h1, and the moves of each piece in
+    // the order they have always had, so that searches do not change
+    for (int i = 0; i < 64; i++) {
+        if ((this->squares[i] & ally) == 0) {
             continue;
         }
-        std::vector<Move> moves = piece->get_legal_moves(*this);
-        for (Move m : moves) {
-            result.push_back(m);
+        int from = i ^ 56;
+        Position pos = Position::from_index(from);
+        auto slide = [&](u_int64_t line) {
+            for (line &= targets; line != 0; line &= line - 1) {
+                Position to = Position::from_index(std::countr_zero(line));
+                if ((pos.squares_between(to) & occupied) == 0) {
+                    add_move(moves, Move::PieceMove, from, to.index());
+                }
+            }
+        };
+
+        switch (this->squares[i] & Piece::type_mask) {
+        case Piece::Pawn:
+            if constexpr (Type != Quiets) {
+                if (en_passant != nullptr &&
+                    (Attacks::pawn(Us, pos) >> en_passant->index()) & 1 &&
+                    (Type != Evasions || targets != 0)) {
+                    add_move(moves, Move::PieceMove, from,
+                             en_passant->index());
+                }
+            }
+            if (pos.row() != last_row &&
+                !((occupied >> (from + up)) & 1)) {
+                if (pos.row() == start_row &&
+                    !((occupied >> (from + 2 * up)) & 1) &&
+                    (targets >> (from + 2 * up)) & 1) {
+                    add_move(moves, Move::PieceMove, from, from + 2 * up);
+                }
+                if ((targets >> (from + up)) & 1) {
+                    add_move(moves, Move::PieceMove, from, from + up);
+                }
+            }
+            for (u_int64_t takes = Attacks::pawn(Us, pos) & enemies & targets;
+                 takes != 0; takes &= takes - 1) {
+                add_move(moves, Move::PieceMove, from,
+                         std::countr_zero(takes));
+            }
+            break;
+
+        case Piece::Knight:
+            for (int k = 0; k < Attacks::knight(pos).count; k++) {
+                int to = Attacks::knight(pos).squares[k];
+                if ((targets >> to) & 1) {
+                    add_move(moves, Move::PieceMove, from, to);
+                }
+            }
+            break;
+
+        case Piece::King:
+            for (int k = 0; k < Attacks::king(pos).count; k++) {
+                int to = Attacks::king(pos).squares[k];
+                if ((king_targets >> to) & 1) {
+                    add_move(moves, Move::PieceMove, from, to);
+                }
+            }
+            if constexpr (Type == AllMoves || Type == Quiets) {
+                if (this->can_kingside_castle(Us)) {
+                    add_move(moves, Move::KingSideCastle);
+                }
+                if (this->can_queenside_castle(Us)) {
+                    add_move(moves, Move::QueenSideCastle);
+                } // both sides may be possible, already checked as legal
+            }
+            break;
+
+        case Piece::Bishop:
+            slide(Attacks::diagonals(pos));
+            break;
+
+        case Piece::Rook:
+            slide(Attacks::col(pos));
+            slide(Attacks::row(pos));
+            break;
+
+        case Piece::Queen:
+            slide(Attacks::col(pos));
+            slide(Attacks::row(pos));
+            slide(Attacks::diagonals(pos));
+            break;
         }
     }
-    return result;
+
+    // the moves that leave the king in check are dropped, order is kept
+    auto illegal = [&](const Move &move) {
+        profile_scope(Profile::Legality);
+        return move.move_type() == Move::PieceMove &&
+               this->apply_move(move, true).is_in_check(Us);
+    };
+    moves.erase(std::remove_if(moves.begin() + first, moves.end(), illegal),
+                moves.end());
+}
+
+std::vector<Move> Board::get_legal_moves(int type) {
+    profile_scope(Profile::MoveGen);
+    std::vector<Move> moves;
+    moves.reserve(64);
+    if (type == AllMoves && this->is_in_check(this->turn)) {
+        type = Evasions;
+    } // every legal move is an evasion, and fewer of them are tried
+
+    bool white = this->turn == Color::White;
+    switch (type) {
+    case AllMoves:
+        white ? this->generate_moves<Color::White, AllMoves>(moves)
+              : this->generate_moves<Color::Black, AllMoves>(moves);
+        break;
+    case Captures:
+        white ? this->generate_moves<Color::White, Captures>(moves)
+              : this->generate_moves<Color::Black, Captures>(moves);
+        break;
+    case Quiets:
+        white ? this->generate_moves<Color::White, Quiets>(moves)
+              : this->generate_moves<Color::Black, Quiets>(moves);
+        break;
+    case Evasions:
+        white ? this->generate_moves<Color::White, Evasions>(moves)
+              : this->generate_moves<Color::Black, Evasions>(moves);
+        break;
+    default:
+        panic("Invalid move generation type");
+    }
+    return moves;
 }
 
 Board Board::move_piece(const Position &from, const Position &to,
                         const bool &cpu) {
     Board result = Board(*this);
-    result.en_passant = nullptr;
+    if (result.en_passant >= 0) {
+        result.key ^= Zobrist::en_passant(*result.get_en_passant());
+    }
+    result.en_passant = -1;
 
     if (from.is_off_board() || to.is_off_board()) {
         return result;
@@ -535,6 +1036,7 @@ Board Board::move_piece(const Position &from, const Position &to,
             panic("Invalid color");
         }
     }
+    int castling_mask = result.get_castling_mask();
 
     Piece *piece = from_square.get_piece();
     result.set_square(from, Square::from_piece(nullptr));
@@ -545,7 +1047,8 @@ Board Board::move_piece(const Position &from, const Position &to,
         if (cpu) {
             // the cpu will always choose the queen
             // TODO: make the cpu choose the best piece
-            piece = new Queen(piece->get_color(), piece->get_pos());
+            piece = Piece::from_id(Piece::Queen, piece->get_color(),
+                                   piece->get_pos());
         } else {
             // ask the user what piece to promote to
             bool valid = false;
@@ -555,16 +1058,20 @@ Board Board::move_piece(const Position &from, const Position &to,
                 promote = to_lower(trim(promote));
 
                 if (promote.empty() || promote == "queen" || promote == "q") {
-                    piece = new Queen(piece->get_color(), piece->get_pos());
+                    piece = Piece::from_id(Piece::Queen, piece->get_color(),
+                                           piece->get_pos());
                     valid = true;
                 } else if (promote == "rook" || promote == "r") {
-                    piece = new Rook(piece->get_color(), piece->get_pos());
+                    piece = Piece::from_id(Piece::Rook, piece->get_color(),
+                                           piece->get_pos());
                     valid = true;
                 } else if (promote == "bishop" || promote == "b") {
-                    piece = new Bishop(piece->get_color(), piece->get_pos());
+                    piece = Piece::from_id(Piece::Bishop, piece->get_color(),
+                                           piece->get_pos());
                     valid = true;
                 } else if (promote == "knight" || promote == "n") {
-                    piece = new Knight(piece->get_color(), piece->get_pos());
+                    piece = Piece::from_id(Piece::Knight, piece->get_color(),
+                                           piece->get_pos());
                     valid = true;
                 } else {
                     std::cerr << "Invalid piece type" << std::endl;
@@ -574,32 +1081,36 @@ Board Board::move_piece(const Position &from, const Position &to,
     }
 
     if ((piece->is_starting_pawn()) && abs(from.row() - to.row()) == 2) {
-        result.en_passant = new Position(to.pawn_back(piece->get_color()));
+        Position behind = to.pawn_back(piece->get_color());
+        result.en_passant = int8_t(behind.row() * 8 + behind.col());
+        result.key ^= Zobrist::en_passant(behind);
     }
 
     result.add_piece(piece->move_to(to));
 
     // check for castling validity
-    CastlingRights *castling_rights;
-    switch (piece->get_color()) {
-    case Color::White:
-        castling_rights = result.white_castling_rights;
-        break;
-    case Color::Black:
-        castling_rights = result.black_castling_rights;
-        break;
-    default:
-        panic("Invalid color");
-    }
-
+    Color color = piece->get_color();
     if (piece->get_type() == Piece::King) {
-        castling_rights->disable_all();
+        result.castling &= ~(kingside_bit(color) | queenside_bit(color));
     } else if (piece->is_queenside_rook()) {
-        castling_rights->disable_queenside();
+        result.castling &= ~queenside_bit(color);
     } else if (piece->is_kingside_rook()) {
-        castling_rights->disable_kingside();
+        result.castling &= ~kingside_bit(color);
     }
 
+    // a rook taken on its starting square can no longer castle
+    if (to == A1) {
+        result.castling &= ~WhiteQueenside;
+    } else if (to == H1) {
+        result.castling &= ~WhiteKingside;
+    } else if (to == A8) {
+        result.castling &= ~BlackQueenside;
+    } else if (to == H8) {
+        result.castling &= ~BlackKingside;
+    }
+
+    result.key ^= Zobrist::castling(castling_mask) ^
+                  Zobrist::castling(result.get_castling_mask());
     return result;
 }
 
@@ -615,7 +1126,7 @@ bool Board::can_kingside_castle(const Color &color) {
         return this->has_no_piece(Position(0, 5)) &&
                this->has_no_piece(Position(0, 6)) &&
                *piece == Rook(color, Position(0, 7)) &&
-               this->white_castling_rights->can_kingside_castle() &&
+               (this->castling & kingside_bit(color)) &&
                !this->is_in_check(color) &&
                !this->is_threatened(right_of_king, color) &&
                !this->is_threatened(right_of_king.next_right(), color);
@@ -627,7 +1138,7 @@ bool Board::can_kingside_castle(const Color &color) {
         return this->has_no_piece(Position(7, 5)) &&
                this->has_no_piece(Position(7, 6)) &&
                *piece == Rook(color, Position(7, 7)) &&
-               this->black_castling_rights->can_kingside_castle() &&
+               (this->castling & kingside_bit(color)) &&
                !this->is_in_check(color) &&
                !this->is_threatened(right_of_king, color) &&
                !this->is_threatened(right_of_king.next_right(), color);
@@ -647,9 +1158,11 @@ bool Board::can_queenside_castle(const Color &color) {
                this->has_no_piece(Position(0, 2)) &&
                this->has_no_piece(Position(0, 3)) &&
                *piece == Rook(color, Position(0, 0)) &&
-               this->white_castling_rights->can_queenside_castle() &&
+               (this->castling & queenside_bit(color)) &&
                !this->is_in_check(color) &&
-               !this->is_threatened(Position::queen_position(color), color);
+               !this->is_threatened(Position::queen_position(color), color) &&
+               !this->is_threatened(
+                   Position::queen_position(color).next_left(), color);
     case Color::Black:
         piece = this->get_piece(Position(7, 0));
         if (piece == nullptr) {
@@ -659,20 +1172,22 @@ bool Board::can_queenside_castle(const Color &color) {
                this->has_no_piece(Position(7, 2)) &&
                this->has_no_piece(Position(7, 3)) &&
                *piece == Rook(color, Position(7, 0)) &&
-               this->black_castling_rights->can_queenside_castle() &&
+               (this->castling & queenside_bit(color)) &&
                !this->is_in_check(color) &&
-               !this->is_threatened(Position::queen_position(color), color);
+               !this->is_threatened(Position::queen_position(color), color) &&
+               !this->is_threatened(
+                   Position::queen_position(color).next_left(), color);
     }
     panic("Invalid color");
 }
 
 bool Board::has_sufficient_material(const Color &color) const {
     std::vector<Piece *> pieces;
-    for (Square square : this->squares) {
-        if (square.is_empty()) {
+    for (int i = 0; i < 64; i++) {
+        Piece *piece = this->piece_at(i);
+        if (piece == nullptr) {
             continue;
         }
-        Piece *piece = square.get_piece();
         if (piece->get_color() == color) {
             pieces.push_back(piece);
         }
@@ -740,8 +1255,8 @@ bool Board::is_endgame() {
     std::vector<Piece *> w_pieces;
     std::vector<Piece *> b_pieces;
 
-    for (Square square : this->squares) {
-        Piece *piece = square.get_piece();
+    for (int i = 0; i < 64; i++) {
+        Piece *piece = this->piece_at(i);
         if (piece == nullptr) {
             continue;
         }
@@ -758,15 +1273,20 @@ bool Board::is_endgame() {
 
 Board Board::change_turn() {
     this->turn = !this->turn;
+    this->key ^= Zobrist::side();
+    if (this->turn == Color::White) {
+        this->fullmove_number++;
+    }
     return *this; // return a copy of the board
 }
 
 Board Board::apply_move(const Move &move, const bool &cpu) {
-    state = State::PLAYING_MOVES;
+    profile_scope(Profile::Apply);
     Position *en_passant, king_pos, rook_pos, from, to;
     Piece *piece;
     Color player_color;
     Board result;
+    bool irreversible;
 
     switch (move.move_type()) {
     case Move::KingSideCastle:
@@ -782,8 +1302,10 @@ Board Board::apply_move(const Move &move, const bool &cpu) {
             rook_pos = Position(7, 7);
             break;
         }
-        return this->move_piece(king_pos, rook_pos.next_left(), cpu)
-            .move_piece(rook_pos, king_pos.next_right(), cpu);
+        result = this->move_piece(king_pos, rook_pos.next_left(), cpu)
+                     .move_piece(rook_pos, king_pos.next_right(), cpu);
+        result.halfmove_clock = this->halfmove_clock + 1;
+        return result;
 
     case Move::QueenSideCastle:
         king_pos = this->get_king_position(this->turn);
@@ -798,26 +1320,36 @@ Board Board::apply_move(const Move &move, const bool &cpu) {
             rook_pos = Position(7, 0);
             break;
         }
-        return this->move_piece(king_pos, rook_pos.next_left().next_left(), cpu)
-            .move_piece(rook_pos, king_pos.next_left(), cpu);
+        result =
+            this->move_piece(king_pos, rook_pos.next_right().next_right(), cpu)
+                .move_piece(rook_pos, king_pos.next_left(), cpu);
+        result.halfmove_clock = this->halfmove_clock + 1;
+        return result;
 
     case Move::PieceMove:
         from = move.from(), to = move.to();
         result = this->move_piece(from, to, cpu);
 
-        en_passant = this->en_passant;
+        en_passant = this->get_en_passant();
         piece = this->get_piece(from);
 
-        if (en_passant != nullptr && piece != nullptr) {
+        // the halfmove clock is reset by any capture or pawn move
+        irreversible = this->has_piece(to) ||
+                       (piece != nullptr && piece->get_type() == Piece::Pawn);
+        result.halfmove_clock = irreversible ? 0 : this->halfmove_clock + 1;
+
+        // only a pawn takes en passant, a king may step on the square too
+        if (en_passant != nullptr && piece != nullptr &&
+            piece->get_type() == Piece::Pawn) {
             player_color = piece->get_color();
             if ((*en_passant == from.pawn_up(player_color).next_left() ||
                  *en_passant == from.pawn_up(player_color).next_right()) &&
                 *en_passant == to) {
-                result.squares[(7 - en_passant->pawn_back(player_color).row()) *
-                                   8 +
-                               en_passant->col()] = EMPTY_SQUARE;
+                result.set_square(en_passant->pawn_back(player_color),
+                                  EMPTY_SQUARE);
             }
         }
+        assert_debug(result.key == result.compute_key());
         return result;
 
     case Move::Resign:
@@ -827,6 +1359,84 @@ Board Board::apply_move(const Move &move, const bool &cpu) {
     panic("Invalid move type");
 }
 
+UndoRecord Board::undo_record(const Move &move) const {
+    UndoRecord record = UndoRecord();
+    record.key = this->key;
+    record.move = move;
+    record.halfmove_clock = this->halfmove_clock;
+    record.fullmove_number = this->fullmove_number;
+    record.turn = this->turn;
+    record.en_passant = this->en_passant;
+    record.castling = this->castling;
+    if (move.move_type() != Move::PieceMove) {
+        return record;
+    }
+
+    int from = move.from().index(), to = move.to().index();
+    record.moved = this->squares[from ^ 56];
+    record.captured = this->squares[to ^ 56];
+    if ((record.moved & Piece::type_mask) == Piece::Pawn &&
+        to == this->en_passant && record.captured == 0) {
+        int behind = record.moved & Piece::White ? to - 8 : to + 8;
+        record.captured = this->squares[behind ^ 56];
+    } // taken en passant, behind the square moved to
+    return record;
+}
+
+Board Board::unmake_move(const UndoRecord &record) const {
+    Board result = Board(*this);
+    int from, to;
+    bool white = record.turn == Color::White;
+    int king = Piece::King | (white ? Piece::White : Piece::Black);
+    int rook = Piece::Rook | (white ? Piece::White : Piece::Black);
+    int back = white ? 0 : 56; // first square of the back row (a1 first)
+
+    switch (record.move.move_type()) {
+    case Move::KingSideCastle:
+        result.squares[(back + 6) ^ 56] = 0;
+        result.squares[(back + 5) ^ 56] = 0;
+        result.squares[(back + 4) ^ 56] = u_int8_t(king);
+        result.squares[(back + 7) ^ 56] = u_int8_t(rook);
+        break;
+
+    case Move::QueenSideCastle:
+        result.squares[(back + 2) ^ 56] = 0;
+        result.squares[(back + 3) ^ 56] = 0;
+        result.squares[(back + 4) ^ 56] = u_int8_t(king);
+        result.squares[(back + 0) ^ 56] = u_int8_t(rook);
+        break;
+
+    case Move::PieceMove:
+        from = record.move.from().index(), to = record.move.to().index();
+        result.squares[from ^ 56] = record.moved;
+        result.squares[to ^ 56] = record.captured;
+        if ((record.moved & Piece::type_mask) == Piece::Pawn &&
+            to == record.en_passant && record.captured != 0) {
+            result.squares[to ^ 56] = 0;
+            result.squares[((record.moved & Piece::White) ? to - 8 : to + 8) ^
+                           56] = record.captured;
+        } else if (record.captured != 0) {
+            u_int8_t *takes = (record.moved & Piece::White)
+                                  ? result.white_takes
+                                  : result.black_takes;
+            takes[record.captured & Piece::type_mask] -= 1;
+        } // pieces taken en passant are not counted
+        break;
+
+    default:
+        panic("Invalid move type");
+    }
+
+    result.key = record.key;
+    result.halfmove_clock = record.halfmove_clock;
+    result.fullmove_number = record.fullmove_number;
+    result.turn = record.turn;
+    result.en_passant = record.en_passant;
+    result.castling = record.castling;
+    assert_debug(result.key == result.compute_key());
+    return result;
+}
+
 GameResult Board::play_move(const Move &move, const bool &cpu) {
     state = State::PLAYING_MOVES;
     Color current_color = this->get_current_player_color();
@@ -856,18 +1466,42 @@ GameResult Board::play_move(const Move &move, const bool &cpu) {
     return result;
 }
 
-std::string Board::rating_bar(unsigned len) {
-    std::tuple<Move, unsigned, double> best0 = this->get_next_best_move(0);
-    std::tuple<Move, unsigned, double> worst0 = this->get_next_worst_move(0);
+// number of positions whose rating is remembered (power of two)
+static const std::size_t RATING_CACHE_SIZE = 256;
+
+/**
+ * @brief The RatingEntry struct
+ *
+ * Rating of a position, remembered under its key.
+ */
+struct RatingEntry {
+    u_int64_t key;
+    bool valid;
+    double yours;
+    double theirs;
+};
+
+static thread_local RatingEntry rating_cache[RATING_CACHE_SIZE];
+static std::atomic<bool> rating_enabled(true);
+
+void Board::enable_rating(bool enabled) { rating_enabled.store(enabled); }
+
+std::pair<double, double> Board::rating() {
+    RatingEntry &entry = rating_cache[this->key & (RATING_CACHE_SIZE - 1)];
+    if (entry.valid && entry.key == this->key) {
+        return std::make_pair(entry.yours, entry.theirs);
+    }
+
+    std::tuple<Move, u_int64_t, double> best0 = this->get_next_best_move(0);
+    std::tuple<Move, u_int64_t, double> worst0 = this->get_next_worst_move(0);
     Move best_m = std::get<0>(best0);
     double your_best_val = std::get<2>(best0),
            your_lowest_val = std::get<2>(worst0);
     double your_val = your_best_val + your_lowest_val;
 
-    std::tuple<Move, unsigned, double> best1 =
-        this->apply_move(best_m, true).change_turn().get_next_best_move(0);
-    std::tuple<Move, unsigned, double> worst1 =
-        this->apply_move(best_m, true).change_turn().get_next_worst_move(0);
+    Board next = this->apply_move(best_m, true).change_turn();
+    std::tuple<Move, u_int64_t, double> best1 = next.get_next_best_move(0);
+    std::tuple<Move, u_int64_t, double> worst1 = next.get_next_worst_move(0);
     double their_best_val = std::get<2>(best1),
            their_lowest_val = std::get<2>(worst1);
     double their_val = their_best_val + their_lowest_val;
@@ -882,6 +1516,21 @@ std::string Board::rating_bar(unsigned len) {
         your_val += 2 * their_val;
     }
 
+    entry.key = this->key;
+    entry.valid = true;
+    entry.yours = your_val;
+    entry.theirs = their_val;
+    return std::make_pair(your_val, their_val);
+}
+
+std::string Board::rating_bar(unsigned len) {
+    if (!rating_enabled.load()) {
+        return std::string();
+    }
+
+    double your_val, their_val;
+    std::tie(your_val, their_val) = this->rating();
+
     double your_percentage = your_val / (your_val + their_val);
     double their_percentage = their_val / (your_val + their_val);
 
@@ -912,47 +1561,60 @@ std::string Board::rating_bar(unsigned len) {
 }
 
 double Board::score() {
-    std::tuple<Move, unsigned, double> best0 = this->get_next_best_move(0);
-    std::tuple<Move, unsigned, double> worst0 = this->get_next_worst_move(0);
-    Move best_m = std::get<0>(best0);
-    double your_best_val = std::get<2>(best0),
-           your_lowest_val = std::get<2>(worst0);
-    double your_val = your_best_val + your_lowest_val;
+    double your_val, their_val;
+    std::tie(your_val, their_val) = this->rating();
+    return your_val - their_val;
+}
 
-    std::tuple<Move, unsigned, double> best1 =
-        this->apply_move(best_m, true).change_turn().get_next_best_move(0);
-    std::tuple<Move, unsigned, double> worst1 =
-        this->apply_move(best_m, true).change_turn().get_next_worst_move(0);
-    double their_best_val = std::get<2>(best1),
-           their_lowest_val = std::get<2>(worst1);
-    double their_val = their_best_val + their_lowest_val;
+Color Board::get_turn_color() const { return this->turn; }
 
-    if (your_val < 0) {
-        your_val *= -1;
-        their_val += 2 * your_val;
+Position *Board::get_en_passant() const {
+    if (this->en_passant < 0) {
+        return nullptr;
     }
+    return en_passant_square(
+        Position(this->en_passant / 8, this->en_passant % 8));
+}
 
-    if (their_val < 0) {
-        their_val *= -1;
-        your_val += 2 * their_val;
-    }
+u_int64_t Board::get_key() const { return this->key; }
 
-    return your_val - their_val;
+u_int64_t Board::compute_key() const {
+    u_int64_t result = 0;
+    for (int i = 0; i < 64; i++) {
+        Piece *piece = this->piece_at(i);
+        if (piece != nullptr) {
+            result ^= Zobrist::piece(piece->get_type(), piece->get_color(),
+                                     Position(7 - i / 8, i % 8));
+        }
+    }
+    result ^= Zobrist::castling(this->get_castling_mask());
+    if (this->en_passant >= 0) {
+        result ^= Zobrist::en_passant(*this->get_en_passant());
+    }
+    if (this->turn == Color::Black) {
+        result ^= Zobrist::side();
+    }
+    return result;
 }
 
-Color Board::get_turn_color() const { return this->turn; }
+unsigned Board::get_halfmove_clock() const { return this->halfmove_clock; }
+
+unsigned Board::get_fullmove_number() const { return this->fullmove_number; }
 
-Position *Board::get_en_passant() const { return this->en_passant; }
+int Board::get_castling_mask() const { return this->castling; }
+
+bool Board::is_fifty_moves() const { return this->halfmove_clock >= 100; }
 
 Board Board::remove_all(const Color &color) const {
     Board result = Board(*this);
 
     for (unsigned i = 0; i < 64; i++) {
-        Piece *piece = result.squares[i].get_piece();
+        Piece *piece = result.piece_at(i);
         if (piece != nullptr && piece->get_color() == color) {
-            result.squares[i] = EMPTY_SQUARE;
+            result.squares[i] = 0;
         }
     }
+    result.key = result.compute_key();
     return result;
 }
 
@@ -960,25 +1622,30 @@ Board Board::queen_all(const Color &color) const {
     Board result = Board(*this);
 
     for (unsigned i = 0; i < 64; i++) {
-        Piece *piece = result.squares[i].get_piece();
+        Piece *piece = result.piece_at(i);
         if (piece != nullptr && piece->get_type() != Piece::King &&
             piece->get_color() == color) {
-            result.squares[i] = Square(new Queen(color, piece->get_pos()));
+            result.squares[i] = u_int8_t(piece->get_id() -
+                                         piece->get_type() + Piece::Queen);
         }
     }
+    result.key = result.compute_key();
     return result;
 }
 
 Board Board::set_turn(const Color &color) const {
     Board result = Board(*this);
+    if (result.turn != color) {
+        result.key ^= Zobrist::side();
+    }
     result.turn = color;
     return result;
 }
 
 int Board::get_material_advantage(const Color &color) const {
     int sum = 0;
-    for (Square square : this->squares) {
-        Piece *piece = square.get_piece();
+    for (int i = 0; i < 64; i++) {
+        Piece *piece = this->piece_at(i);
         if (piece == nullptr) {
             continue;
         }
@@ -1048,7 +1715,7 @@ std::ostream &operator<<(std::ostream &os, Board &board) {
             std::string s;
             Piece *piece = board.get_piece(pos);
             if (piece != nullptr) {
-                s = " " + piece->to_string() + " ";
+                s = std::string(" ").append(piece->to_string()).append(" ");
             } else {
                 switch (square_color) {
                 case Color::White:
@@ -1114,7 +1781,9 @@ std::ostream &operator<<(std::ostream &os, Board &board) {
             os << " " << board.get_turn_color() << " to move";
         } else if (row == 4) {
             // display the rating bar
-            os << " [" << rating_bar << "]";
+            if (!rating_bar.empty()) {
+                os << " [" << rating_bar << "]";
+            }
         }
 
         square_color = !square_color;
@@ -1124,149 +1793,609 @@ std::ostream &operator<<(std::ostream &os, Board &board) {
     return os;
 }
 
-bool cmp(Board &board, Move a, Move b) {
-    Position a_pos_from = a.from();
-    Position a_pos_to = a.to();
-    Position b_pos_from = b.from();
-    Position b_pos_to = b.to();
+// ordering values of the moves are offset by this, once for the other
+// moves and twice for winning and even captures
+static const int CAPTURE_ORDER = 100000;
+
+/**
+ * @brief Get the ordering value of a move : winning and even captures
+ * first (most valuable victim first), then the other moves (most valuable
+ * piece first), then losing captures (least losing first)
+ *
+ * @param board position
+ * @param move legal move
+ * @return int - value, negative for a losing capture
+ */
+static int order_value(Board &board, const Move &move) {
+    Piece *piece_from = board.get_piece(move.from());
+    Piece *piece_to = board.get_piece(move.to());
+    if (piece_to == nullptr && piece_from != nullptr &&
+        piece_from->get_type() == Piece::Pawn &&
+        move.move_type() == Move::PieceMove) {
+        Position *en_passant = board.get_en_passant();
+        if (en_passant != nullptr && move.to() == *en_passant) {
+            piece_to = piece_from;
+        }
+    } // en passant : the pawn taken is worth the one taking
+    if (piece_to != nullptr) {
+        int victim = piece_to->get_material_value();
+        if (piece_from == nullptr ||
+            victim < piece_from->get_material_value()) {
+            int exchange = board.see(move);
+            if (exchange < 0) {
+                return exchange;
+            } // the piece taken is worth less than what the exchange costs
+        } // taking a piece worth at least the taker never loses material
+        return 2 * CAPTURE_ORDER + victim;
+    }
+    return CAPTURE_ORDER +
+           (piece_from != nullptr ? piece_from->get_material_value() : 0);
+}
 
-    Piece *a_piece_from = board.get_piece(a_pos_from);
-    Piece *a_piece_to = board.get_piece(a_pos_to);
-    Piece *b_piece_from = board.get_piece(b_pos_from);
-    Piece *b_piece_to = board.get_piece(b_pos_to);
+/**
+ * @brief sorts moves by their ordering value (computed once per move)
+ *
+ * @param board position
+ * @param moves legal moves
+ * @param losing if losing captures are kept, (optional)
+ * @param values set to the ordering values of the sorted moves, (optional)
+ */
+static void sort_moves(Board &board, std::vector<Move> &moves,
+                       bool losing = true, std::vector<int> *values = nullptr) {
+    std::vector<std::pair<int, Move>> ordered;
+    ordered.reserve(moves.size());
+    for (const Move &move : moves) {
+        int value = order_value(board, move);
+        if (losing || value >= 0) {
+            ordered.push_back({value, move});
+        }
+    }
+    std::sort(ordered.begin(), ordered.end(),
+              [](const std::pair<int, Move> &a,
+                 const std::pair<int, Move> &b) { return a.first > b.first; });
+    moves.clear();
+    if (values != nullptr) {
+        values->clear();
+    }
+    for (const std::pair<int, Move> &entry : ordered) {
+        moves.push_back(entry.second);
+        if (values != nullptr) {
+            values->push_back(entry.first);
+        }
+    }
+}
 
-    // if move a is a take, but b is not, a is better
-    if (a_piece_to != nullptr && b_piece_to == nullptr) {
-        return true;
+/**
+ * @brief moves the hash move (if any and legal) in front of the others
+ *
+ * @param legal_moves sorted legal moves
+ * @param hash_move move from the transposition table
+ * @param values ordering values of the moves, moved along, (optional)
+ */
+static void hash_move_first(std::vector<Move> &legal_moves,
+                            const Move &hash_move,
+                            std::vector<int> *values = nullptr) {
+    if (hash_move.move_type() == Move::Invalid) {
+        return;
     }
-    // if move b is a take, but a is not, b is better
-    if (b_piece_to != nullptr && a_piece_to == nullptr) {
-        return false;
+    auto it = std::find(legal_moves.begin(), legal_moves.end(), hash_move);
+    if (it != legal_moves.end()) {
+        if (values != nullptr) {
+            std::size_t i = std::size_t(it - legal_moves.begin());
+            std::rotate(values->begin(), values->begin() + i,
+                        values->begin() + i + 1);
+        }
+        std::rotate(legal_moves.begin(), it, it + 1);
     }
-    // if both moves are takes, compare the piece values
-    if (a_piece_to != nullptr && b_piece_to != nullptr) {
-        return a_piece_to->get_material_value() >
-               b_piece_to->get_material_value();
+}
+
+/**
+ * @brief keeps the root moves the search is restricted to (if any)
+ *
+ * @param legal_moves legal moves of the root
+ * @param context search context
+ */
+static void keep_root_moves(std::vector<Move> &legal_moves,
+                            const SearchContext &context) {
+    if (context.root_moves.empty()) {
+        return;
     }
-    // if both moves are not takes, compare the piece values
-    if (a_piece_from != nullptr && b_piece_from != nullptr) {
-        return a_piece_from->get_material_value() >
-               b_piece_from->get_material_value();
+    std::erase_if(legal_moves, [&context](const Move &m) {
+        return std::find(context.root_moves.begin(), context.root_moves.end(),
+                         m) == context.root_moves.end();
+    });
+}
+
+/**
+ * @brief follows the best moves stored in the table from a position
+ *
+ * @param board position after the first move
+ * @param first first move of the variation
+ * @param tt transposition table (can be nullptr)
+ * @param length maximum number of moves
+ * @return std::vector<Move> - principal variation
+ */
+static std::vector<Move> principal_variation(Board board, const Move &first,
+                                             const TranspositionTable *tt,
+                                             int length) {
+    std::vector<Move> pv = {first};
+    std::vector<u_int64_t> seen;
+    HashEntry entry;
+    while (tt != nullptr && int(pv.size()) < length &&
+           std::find(seen.begin(), seen.end(), board.get_key()) ==
+               seen.end() &&
+           tt->probe(board.get_key(), entry)) {
+        std::vector<Move> legal_moves = board.get_legal_moves();
+        if (std::find(legal_moves.begin(), legal_moves.end(), entry.move) ==
+            legal_moves.end()) {
+            break;
+        } // no move, stale entry or collision
+        seen.push_back(board.get_key());
+        pv.push_back(entry.move);
+        board = board.apply_eval_move(entry.move, true);
     }
+    return pv;
+}
 
-    return false;
+std::tuple<Move, u_int64_t, double>
+Board::get_next_best_move(int depth, const History &history) {
+    SearchContext context = SearchContext(history);
+    return this->get_next_best_move(depth, context);
 }
 
-std::tuple<Move, u_int64_t, double> Board::get_next_best_move(int depth) {
+std::tuple<Move, u_int64_t, double>
+Board::get_next_best_move(int depth, SearchContext &context) {
     state = State::GETTING_LEGAL_MOVES;
     std::vector<Move> legal_moves = this->get_legal_moves();
+    keep_root_moves(legal_moves, context);
 
     state = State::SORTING_MOVES;
-    std::sort(legal_moves.begin(), legal_moves.end(),
-              [&](Move a, Move b) { return cmp(*this, a, b); });
+    sort_moves(*this, legal_moves);
+    HashEntry entry;
+    if (context.tt != nullptr && context.tt->probe(this->key, entry)) {
+        hash_move_first(legal_moves, entry.move);
+    }
     state = State::PLAYING_MOVES;
 
     double best_move_value = -999999.;
     Move best_move = Move();
     best_move.move_type() = Move::Resign;
+    if (!legal_moves.empty()) {
+        best_move = legal_moves.front();
+    } // a search stopped right away still plays something
 
     Color color = this->get_current_player_color();
-    u_int64_t board_count = 0;
+    context.history.push(this->key);
+
+    // a search that can be stopped deepens one ply at a time, so that there
+    // always is a complete (or at least started) iteration to answer with
+    int first_depth = context.can_stop() ? 0 : depth;
+    for (int d = first_depth; d <= depth && !context.stopped; d++) {
+        double iteration_value = -999999.;
+        Move iteration_move = best_move;
+        unsigned searched = 0;
+        u_int64_t iteration_start = context.stats.total_nodes();
+        auto start = std::chrono::steady_clock::now();
 
-    for (Move m : legal_moves) {
-        double child_board_value = this->apply_eval_move(m, true).minimax(
-            depth, -1000000., 1000000., false, color, &board_count);
+        for (Move m : legal_moves) {
+            double child_board_value = this->apply_eval_move(m, true).minimax(
+                d, -1000000., 1000000., false, color, &context);
+            if (context.stopped) {
+                break;
+            }
+            searched++;
 
-        if (child_board_value >= best_move_value) {
-            best_move = m;
-            best_move_value = child_board_value;
+            if (child_board_value >= iteration_value) {
+                iteration_move = m;
+                iteration_value = child_board_value;
+            }
+        }
+
+        // the previous best move is searched first : once it is done, the
+        // partial iteration is at least as good as the previous one
+        if (searched > 0) {
+            best_move = iteration_move;
+            best_move_value = iteration_value;
+            hash_move_first(legal_moves, best_move);
+        }
+        if (!context.stopped) {
+            context.depth = d;
+            if (context.tt != nullptr && context.root_moves.empty()) {
+                context.tt->store(this->key, best_move, best_move_value, d + 1,
+                                  TranspositionTable::Exact);
+            } // the best of some of the moves only is not the root's value
+            IterationStats iteration;
+            iteration.plies = d + 1;
+            iteration.nodes = context.stats.total_nodes() - iteration_start;
+            iteration.ms =
+                std::chrono::duration_cast<std::chrono::milliseconds>(
+                    std::chrono::steady_clock::now() - start)
+                    .count();
+            context.stats.iterations.push_back(iteration);
+        }
+    }
+    context.history.pop();
+
+    if (best_move.move_type() != Move::Resign) {
+        context.stats.pv =
+            principal_variation(this->apply_eval_move(best_move, true),
+                                best_move, context.tt, context.depth + 1);
+    }
+    return std::make_tuple(best_move, context.stats.total_nodes(),
+                           best_move_value);
+}
+
+std::vector<PvLine> Board::get_best_moves(int depth, unsigned count,
+                                          SearchContext &context) {
+    state = State::GETTING_LEGAL_MOVES;
+    std::vector<Move> legal_moves = this->get_legal_moves();
+    keep_root_moves(legal_moves, context);
+
+    state = State::SORTING_MOVES;
+    sort_moves(*this, legal_moves);
+    HashEntry entry;
+    if (context.tt != nullptr && context.tt->probe(this->key, entry)) {
+        hash_move_first(legal_moves, entry.move);
+    }
+    state = State::PLAYING_MOVES;
+
+    Move resign = Move();
+    resign.move_type() = Move::Resign;
+    std::vector<PvLine> lines; // of the last completed iteration
+    if (legal_moves.empty()) {
+        lines.push_back({resign, -999999., {}});
+        return lines;
+    }
+    count = unsigned(std::min<std::size_t>(count, legal_moves.size()));
+
+    Color color = this->get_current_player_color();
+    context.history.push(this->key);
+
+    int first_depth = context.can_stop() ? 0 : depth;
+    for (int d = first_depth; d <= depth && !context.stopped; d++) {
+        std::vector<PvLine> found;
+        u_int64_t iteration_start = context.stats.total_nodes();
+        auto start = std::chrono::steady_clock::now();
+
+        // one pass per line : the best of the moves not found yet, moves
+        // that can not beat the best of the pass so far fail low cheaply
+        while (found.size() < count && !context.stopped) {
+            double alpha = -1000000.;
+            PvLine pass = {resign, -999999., {}};
+            for (Move m : legal_moves) {
+                if (std::find_if(found.begin(), found.end(),
+                                 [&](const PvLine &line) {
+                                     return line.move == m;
+                                 }) != found.end()) {
+                    continue;
+                }
+                Board child = this->apply_eval_move(m, true);
+                double value = child.minimax(d, alpha, 1000000., false,
+                                             color, &context);
+                if (context.stopped) {
+                    break;
+                }
+                if (pass.move.move_type() == Move::Resign ||
+                    value > pass.value) {
+                    pass.move = m;
+                    pass.value = value;
+                }
+                alpha = std::max(alpha, value);
+            }
+            if (context.stopped) {
+                break;
+            }
+            Board child = this->apply_eval_move(pass.move, true);
+            pass.pv = principal_variation(child, pass.move, context.tt, d + 1);
+            found.push_back(pass);
+        }
+
+        // lines found (even by a stopped iteration) are searched first next
+        for (auto it = found.rbegin(); it != found.rend(); it++) {
+            hash_move_first(legal_moves, it->move);
         }
+        if (!context.stopped) {
+            lines = found;
+            context.depth = d;
+            if (context.tt != nullptr && context.root_moves.empty()) {
+                context.tt->store(this->key, lines.front().move,
+                                  lines.front().value, d + 1,
+                                  TranspositionTable::Exact);
+            }
+            IterationStats iteration;
+            iteration.plies = d + 1;
+            iteration.nodes = context.stats.total_nodes() - iteration_start;
+            iteration.ms =
+                std::chrono::duration_cast<std::chrono::milliseconds>(
+                    std::chrono::steady_clock::now() - start)
+                    .count();
+            context.stats.iterations.push_back(iteration);
+        } else if (lines.empty()) {
+            lines = found;
+        } // stopped during the first iteration : whatever was found
     }
+    context.history.pop();
+
+    if (lines.empty()) {
+        lines.push_back({legal_moves.front(), -999999., {}});
+    } // a search stopped right away still plays something
+    context.stats.pv = lines.front().pv;
+    context.stats.lines = lines;
+    return lines;
+}
 
-    return std::make_tuple(best_move, board_count, best_move_value);
+std::tuple<Move, u_int64_t, double>
+Board::get_next_worst_move(int depth, const History &history) {
+    SearchContext context = SearchContext(history);
+    return this->get_next_worst_move(depth, context);
 }
 
-std::tuple<Move, u_int64_t, double> Board::get_next_worst_move(int depth) {
+std::tuple<Move, u_int64_t, double>
+Board::get_next_worst_move(int depth, SearchContext &context) {
     state = State::GETTING_LEGAL_MOVES;
     std::vector<Move> legal_moves = this->get_legal_moves();
+    keep_root_moves(legal_moves, context);
 
     state = State::SORTING_MOVES;
-    std::sort(legal_moves.begin(), legal_moves.end(),
-              [&](Move a, Move b) { return cmp(*this, a, b); });
+    sort_moves(*this, legal_moves);
     state = State::PLAYING_MOVES;
 
     double best_move_value = -999999.;
     Move best_move = Move();
     best_move.move_type() = Move::Resign;
+    if (!legal_moves.empty()) {
+        best_move = legal_moves.front();
+    } // a search stopped right away still plays something
 
     Color color = this->get_current_player_color();
-    u_int64_t board_count = 0;
+    context.history.push(this->key);
 
     for (Move m : legal_moves) {
         double child_board_value = this->apply_eval_move(m, true).minimax(
-            depth, -1000000., 1000000., true, !color, &board_count);
+            depth, -1000000., 1000000., true, !color, &context);
+        if (context.stopped) {
+            break;
+        }
 
         if (child_board_value >= best_move_value) {
             best_move = m;
             best_move_value = child_board_value;
         }
     }
+    context.history.pop();
+    if (!context.stopped) {
+        context.depth = depth;
+    }
 
-    return std::make_tuple(best_move, board_count, best_move_value);
+    return std::make_tuple(best_move, context.stats.total_nodes(),
+                           best_move_value);
 }
 
 double Board::minimax(int depth, double alpha, double beta, bool is_maximizing,
-                      Color getting_move_for, u_int64_t *board_count) {
-    *board_count += 1;
-
+                      Color getting_move_for, SearchContext *context) {
     if (depth <= 0) {
-        return this->value_for(getting_move_for);
+        return this->quiesce(alpha, beta, is_maximizing, getting_move_for,
+                             context);
+    } // the horizon : the position is only scored once it is quiet
+    context->stats.nodes += 1;
+    if (context->should_stop()) {
+        return 0.;
     }
 
-    state = State::GETTING_LEGAL_MOVES;
-    std::vector<Move> legal_moves = this->get_legal_moves();
+    // a position seen before on this line (or in the game) is a draw :
+    // whatever was best the first time will be best again
+    if (this->is_fifty_moves() ||
+        context->history.repeated(this->key, this->halfmove_clock)) {
+        return 0.;
+    }
 
-    state = State::SORTING_MOVES;
-    std::sort(legal_moves.begin(), legal_moves.end(),
-              [&](Move a, Move b) { return cmp(*this, a, b); });
-    state = State::PLAYING_MOVES;
+
+    // the table stores values for the player to move,
+    // who is the maximizing player
+    double sign = is_maximizing ? 1. : -1.;
+    double alpha_orig = alpha, beta_orig = beta;
+    HashEntry entry;
+    Move hash_move = Move();
+    if (context->tt != nullptr) {
+        context->stats.hash_probes++;
+    }
+    if (context->tt != nullptr && context->tt->probe(this->key, entry)) {
+        context->stats.hash_hits++;
+        hash_move = entry.move;
+        if (entry.depth >= depth) {
+            double value = sign * entry.value;
+            bool is_lower_bound =
+                (entry.bound == TranspositionTable::LowerBound) ==
+                is_maximizing;
+            if (entry.bound == TranspositionTable::Exact ||
+                (is_lower_bound && value >= beta) ||
+                (!is_lower_bound && value <= alpha)) {
+                return value;
+            }
+        }
+    }
+
+    std::vector<Move> legal_moves = this->get_legal_moves();
+    std::vector<int> order; // negative for the captures that lose material
+    {
+        profile_scope(Profile::Sorting);
+        sort_moves(*this, legal_moves, true, &order);
+        hash_move_first(legal_moves, hash_move, &order);
+    }
 
     double best_move_value;
+    Move best_move = Move();
+    context->history.push(this->key);
 
+    // a cutoff by the first move means the ordering was right
+    bool first = true;
     if (is_maximizing) {
         best_move_value = -999999.;
-        for (Move m : legal_moves) {
-            double child_board_value = this->apply_eval_move(m, true).minimax(
-                depth - 1, alpha, beta, !is_maximizing, getting_move_for,
-                board_count);
+        for (std::size_t i = 0; i < legal_moves.size(); i++) {
+            Move m = legal_moves[i];
+            if (i == 1 && context->split != nullptr &&
+                depth >= SplitSearch::MIN_DEPTH &&
+                context->split->split(*this, legal_moves, order, depth, alpha,
+                                      beta, is_maximizing, getting_move_for,
+                                      best_move_value, best_move, context)) {
+                context->stats.cutoffs += beta <= alpha;
+                break;
+            } // the eldest brother is known : the younger ones in parallel
+            double child_board_value =
+                this->search_move(m, depth, alpha, beta, is_maximizing,
+                                  getting_move_for, context,
+                                  i > 0 && order[i] < 0);
 
             if (child_board_value > best_move_value) {
                 best_move_value = child_board_value;
+                best_move = m;
             }
             if (best_move_value > alpha) {
                 alpha = best_move_value;
             }
             if (beta <= alpha) {
-                return best_move_value;
+                context->stats.cutoffs++;
+                context->stats.first_move_cutoffs += first;
+                break;
             }
+            first = false;
         }
     } else {
         best_move_value = 999999.;
-        for (Move m : legal_moves) {
-            double child_board_value = this->apply_eval_move(m, true).minimax(
-                depth - 1, alpha, beta, !is_maximizing, getting_move_for,
-                board_count);
+        for (std::size_t i = 0; i < legal_moves.size(); i++) {
+            Move m = legal_moves[i];
+            if (i == 1 && context->split != nullptr &&
+                depth >= SplitSearch::MIN_DEPTH &&
+                context->split->split(*this, legal_moves, order, depth, alpha,
+                                      beta, is_maximizing, getting_move_for,
+                                      best_move_value, best_move, context)) {
+                context->stats.cutoffs += beta <= alpha;
+                break;
+            } // the eldest brother is known : the younger ones in parallel
+            double child_board_value =
+                this->search_move(m, depth, alpha, beta, is_maximizing,
+                                  getting_move_for, context,
+                                  i > 0 && order[i] < 0);
 
             if (child_board_value < best_move_value) {
                 best_move_value = child_board_value;
+                best_move = m;
             }
             if (best_move_value < beta) {
                 beta = best_move_value;
             }
             if (beta <= alpha) {
-                return best_move_value;
+                context->stats.cutoffs++;
+                context->stats.first_move_cutoffs += first;
+                break;
             }
+            first = false;
+        }
+    }
+    context->history.pop();
+
+    if (context->tt != nullptr && !context->stopped) {
+        int bound = TranspositionTable::Exact;
+        if (best_move_value <= alpha_orig) {
+            bound = is_maximizing ? TranspositionTable::UpperBound
+                                  : TranspositionTable::LowerBound;
+        } else if (best_move_value >= beta_orig) {
+            bound = is_maximizing ? TranspositionTable::LowerBound
+                                  : TranspositionTable::UpperBound;
         }
+        context->tt->store(this->key, best_move, sign * best_move_value, depth,
+                           bound);
+    }
+    return best_move_value;
+}
+
+// least depth left at a node for its losing captures to be reduced
+static const int MIN_REDUCTION_DEPTH = 2;
+
+double Board::search_move(const Move &move, int depth, double alpha,
+                          double beta, bool is_maximizing,
+                          Color getting_move_for, SearchContext *context,
+                          bool losing) {
+    Board child = this->apply_eval_move(move, true);
+    if (losing && depth >= MIN_REDUCTION_DEPTH) {
+        double value = child.minimax(depth - 2, alpha, beta, !is_maximizing,
+                                     getting_move_for, context);
+        if (context->stopped ||
+            (is_maximizing ? value <= alpha : value >= beta)) {
+            return value;
+        } // as bad as it looked : not worth the full depth
+    }
+    return child.minimax(depth - 1, alpha, beta, !is_maximizing,
+                         getting_move_for, context);
+}
+
+double Board::quiesce(double alpha, double beta, bool is_maximizing,
+                      Color getting_move_for, SearchContext *context) {
+    context->stats.qnodes += 1;
+    if (context->should_stop()) {
+        return 0.;
+    }
+    // captures are never repeated : only the first position can be a draw
+    if (this->is_fifty_moves() ||
+        context->history.repeated(this->key, this->halfmove_clock)) {
+        return 0.;
+    }
+
+    // in check, standing pat is no option : every evasion is searched and
+    // none is a mate, otherwise taking is never forced and the evaluation is
+    // a bound already
+    bool in_check = this->is_in_check(this->turn);
+    double best_move_value;
+    std::vector<Move> moves;
+    if (in_check) {
+        best_move_value = is_maximizing ? -999999. : 999999.;
+        moves = this->get_legal_moves(Board::Evasions);
+        {
+            profile_scope(Profile::Sorting);
+            sort_moves(*this, moves);
+        }
+    } else {
+        {
+            profile_scope(Profile::Eval);
+            best_move_value = this->value_for(getting_move_for);
+        }
+        if (is_maximizing ? best_move_value >= beta
+                          : best_move_value <= alpha) {
+            return best_move_value;
+        }
+        if (is_maximizing) {
+            alpha = std::max(alpha, best_move_value);
+        } else {
+            beta = std::min(beta, best_move_value);
+        }
+
+        moves = this->get_legal_moves(Board::Captures);
+        {
+            profile_scope(Profile::Sorting);
+            sort_moves(*this, moves, false);
+        }
+    }
+
+    // quiet evasions can be repeated : checks back and forth are a draw
+    if (in_check) {
+        context->history.push(this->key);
+    }
+    for (const Move &m : moves) {
+        double child_board_value = this->apply_eval_move(m, true).quiesce(
+            alpha, beta, !is_maximizing, getting_move_for, context);
+        if (is_maximizing) {
+            best_move_value = std::max(best_move_value, child_board_value);
+            alpha = std::max(alpha, best_move_value);
+        } else {
+            best_move_value = std::min(best_move_value, child_board_value);
+            beta = std::min(beta, best_move_value);
+        }
+        if (beta <= alpha) {
+            break;
+        }
+    }
+    if (in_check) {
+        context->history.pop();
     }
     return best_move_value;
 }
@@ -0,0 +1,96 @@
+#include "game.h"
+
+#include "piece.h"
+
+Game::Game(const Board &start) { reset(start); }
+
+Game::~Game() {}
+
+void Game::reset(const Board &start) {
+    start_ = start;
+    board_ = start;
+    records_.clear();
+    ply_ = 0;
+    keys_.clear();
+}
+
+const Board &Game::board() const { return board_; }
+
+Board &Game::board() { return board_; }
+
+const Board &Game::start() const { return start_; }
+
+const History &Game::keys() const { return keys_; }
+
+std::size_t Game::ply() const { return ply_; }
+
+std::size_t Game::length() const { return records_.size(); }
+
+const Move &Game::move(std::size_t ply) const {
+    assert_debug(ply < records_.size());
+    return records_[ply].move;
+}
+
+void Game::play(const Move &move) {
+    play(move, board_.apply_eval_move(move, true));
+}
+
+void Game::play(const Move &move, const Board &next) {
+    UndoRecord record = board_.undo_record(move);
+    if (move.move_type() == Move::PieceMove) {
+        Piece *piece = next.get_square(move.to()).get_piece();
+        if (piece != nullptr && piece->get_id() != record.moved) {
+            record.promoted = u_int8_t(piece->get_id());
+        }
+    } // an underpromotion can then be replayed
+
+    records_.resize(ply_); // a new line : the moves taken back are gone
+    keys_.push(board_.get_key());
+    records_.push_back(record);
+    ply_++;
+    board_ = next;
+}
+
+bool Game::pop() {
+    if (ply_ == 0) {
+        return false;
+    }
+    board_ = board_.unmake_move(records_[--ply_]);
+    keys_.pop();
+    return true;
+}
+
+void Game::jump(std::size_t ply) {
+    ply = std::min(ply, records_.size());
+    while (ply_ > ply) {
+        pop();
+    }
+    while (ply_ < ply) {
+        keys_.push(board_.get_key());
+        board_ = redo(board_, records_[ply_++]);
+    }
+}
+
+Board Game::replay(std::size_t ply) const {
+    Board board = start_;
+    for (std::size_t i = 0; i < std::min(ply, records_.size()); i++) {
+        board = redo(board, records_[i]);
+    }
+    return board;
+}
+
+Board Game::redo(const Board &board, const UndoRecord &record) {
+    Board result = board;
+    if (result.get_turn_color() != record.turn) {
+        result = result.set_turn(record.turn);
+    } // the turn was passed
+
+    result = result.apply_eval_move(record.move, true);
+    if (record.promoted != 0) {
+        Position to = record.move.to();
+        result.set_square(to, Square::from_piece(Piece::from_id(
+                                  record.promoted & Piece::type_mask,
+                                  record.turn, to)));
+    }
+    return result;
+}
@@ -0,0 +1,48 @@
+#include "history.h"
+
+History::History() {
+    keys.reserve(256);
+    this->base = nullptr;
+}
+
+History::History(const History *base) {
+    keys.reserve(64);
+    this->base = base;
+}
+
+History::~History() {}
+
+void History::push(u_int64_t key) { keys.push_back(key); }
+
+void History::pop() {
+    if (!keys.empty()) {
+        keys.pop_back();
+    }
+}
+
+std::size_t History::size() const {
+    return keys.size() + (base != nullptr ? base->size() : 0);
+}
+
+void History::clear() { keys.clear(); }
+
+bool History::repeated(u_int64_t key, unsigned halfmove_clock,
+                       unsigned times) const {
+    std::size_t window = std::min<std::size_t>(halfmove_clock, size());
+    unsigned count = 0;
+
+    // the same side is to move every other ply, so skip the odd ones
+    for (std::size_t back = 2; back <= window; back += 2) {
+        if (key_back(back) == key && ++count >= times) {
+            return true;
+        }
+    }
+    return false;
+}
+
+u_int64_t History::key_back(std::size_t back) const {
+    if (back <= keys.size()) {
+        return keys[keys.size() - back];
+    }
+    return base->key_back(back - keys.size());
+}
@@ -95,16 +95,39 @@ std::string operator*(std::string str, unsigned n) {
     return repeat(std::move(str), n);
 }
 
+// lines typed in advance, while the program was busy
+static std::vector<std::string> pending_input;
+
 void input(std::string &str, const std::string &prompt) {
-    // launch a thread to handle input
+    if (!pending_input.empty()) {
+        str = pending_input.front();
+        pending_input.erase(pending_input.begin());
+        std::cout << prompt << str << std::endl;
+        return;
+    }
+
+    // read on the calling thread, which has nothing else to do meanwhile
     state = State::WAITING_FOR_INPUT;
-    std::thread([&str, &prompt]() {
-        std::cout << prompt;
-        std::cout.flush();
-        std::getline(std::cin, str);
-    }).join();
+    std::cout << prompt;
+    std::cout.flush();
+    std::getline(std::cin, str);
+}
+
+bool poll_input(std::string &str, int timeout) {
+    struct pollfd fd = {STDIN_FILENO, POLLIN, 0};
+    int ready = std::cin.good() ? poll(&fd, 1, timeout) : -1;
+    if (ready > 0 && (fd.revents & POLLIN)) {
+        return bool(std::getline(std::cin, str));
+    }
+    if (ready != 0) {
+        // closed input or interrupted poll : do not spin
+        std::this_thread::sleep_for(std::chrono::milliseconds(timeout));
+    }
+    return false;
 }
 
+void unread_input(const std::string &str) { pending_input.push_back(str); }
+
 std::string trim(const std::string &s) {
     std::string::size_type first = s.find_first_not_of(' ');
     std::string::size_type last = s.find_last_not_of(' ');
@@ -41,19 +41,38 @@
 //! @param [in] -n, --filename FILENAME [default: ""]
 //! @param [in] -v, --verbose
 //! @param [in] -q, --quiet
+//! @param [in] -p, --ponder
+//! @param [in] -u, --uci
+//! @param [in] -a, --analyze  FILENAME [default: ""]
+//! @param [in] -d, --depth    DEPTH [default: 5]
+//! @param [in] -N, --nodes    NODES [default: 0]
+//! @param [in] -k, --multipv  K [default: 1]
+//! @param [in] -s, --selfplay FILENAME [default: ""]
+//! @param [in] -g, --games    GAMES [default: 0]
+//! @param [in] -A, --first    ENGINE [default: ""]
+//! @param [in] -B, --second   ENGINE [default: ""]
+//! @param [in] -S, --sprt     ELO0,ELO1 [default: "0,5"]
+//! @param [in] -H, --hash-file FILENAME [default: ""]
+//! @param [in] -F, --hash-prefault
+//! @param [in] -t, --threads  N [default: 0, one per core]
+//! @param [in] -x, --affinity
+//! @param [in] -y, --smp      shared|ybwc [default: ""]
+//! @param [in] -b, --bench
+//! @param [in] -P, --profile
 //! @param [in] -h, --help
 //! @param [in] -V, --version
 //!
-//! @note -f, -m, -n are mutually exclusive and at the time of writing,
-//!   only -f is implemented.
+//! @note -n replays a pgn file from its own positions, -m moves are then
+//!   played from the resulting position (or from -f).
 //!
 //! Move notation is as follows:
-//!  - "e2e4" for a normal move
+//!  - "e2e4" or "Nf3" for a normal move
 //!  - "O-O" or "O-O-O" for a castling move
 //!  - "best" to let the CPU choose the best move
 //!  - "worst" to let the CPU choose the worst move
 //!  - "rate" to rate the current position
 //!  - "pass" to pass
+//!  - "save" to save the transposition table to the --hash-file
 //!  - "/quit" to quit the program
 //!
 //! @see <https://github.com/ThomasByr/chess>
@@ -73,8 +92,8 @@
 const bool WHITE_IS_FILLED = true;
 
 // enum class to represent the current state of the program
-// (e.g. CPU is thinking, waiting for input, etc.)
-State state = State::PROGRAM_STARTING;
+// (e.g. CPU is thinking, waiting for input, etc.), one per thread
+thread_local State state = State::PROGRAM_STARTING;
 
 void at_exit(void) { state = State::REGISTERING_EXIT; }
 
@@ -0,0 +1,311 @@
+#include "match.h"
+
+/**
+ * @brief Get the Elo difference of a mean score
+ *
+ * @param score mean score, strictly between 0 and 1
+ * @return double - Elo
+ */
+static double score_to_elo(double score) {
+    return -400. * std::log10(1. / score - 1.);
+}
+
+/**
+ * @brief Get the mean score of an Elo difference
+ *
+ * @param elo Elo
+ * @return double - mean score
+ */
+static double elo_to_score(double elo) {
+    return 1. / (1. + std::pow(10., -elo / 400.));
+}
+
+EngineConfig::EngineConfig(const SearchLimits &limits, std::size_t megabytes)
+    : limits(limits) {
+    this->megabytes = megabytes;
+}
+
+EngineConfig::~EngineConfig() {}
+
+EngineConfig EngineConfig::from_string(const std::string &spec,
+                                       const EngineConfig &base) {
+    EngineConfig config = base;
+    std::istringstream ss(spec);
+    std::string item;
+    while (std::getline(ss, item, ',')) {
+        item = trim(item);
+        if (item.empty()) {
+            continue;
+        }
+        std::string::size_type equal = item.find('=');
+        if (equal == std::string::npos) {
+            throw std::invalid_argument("expected key=value: " + item);
+        }
+        std::string key = to_lower(trim(item.substr(0, equal)));
+        std::string value = trim(item.substr(equal + 1));
+
+        char *end = nullptr;
+        errno = 0;
+        long long number = std::strtoll(value.c_str(), &end, 10);
+        if (value.empty() || *end != '\0' || errno != 0 || number < 0) {
+            throw std::invalid_argument("invalid value for " + key + ": " +
+                                        value);
+        }
+
+        if (key == "depth" && number >= 1) {
+            config.limits.depth = int(number) - 1;
+        } else if (key == "nodes") {
+            config.limits.nodes = u_int64_t(number);
+        } else if (key == "movetime") {
+            config.limits.movetime = int64_t(number);
+        } else if (key == "hash" && number >= 1) {
+            config.megabytes = std::size_t(number);
+        } else {
+            throw std::invalid_argument("invalid engine option: " + item);
+        }
+    }
+    return config;
+}
+
+MatchStats::MatchStats() {
+    this->wins = 0;
+    this->draws = 0;
+    this->losses = 0;
+}
+
+MatchStats::~MatchStats() {}
+
+unsigned MatchStats::games() const { return wins + draws + losses; }
+
+double MatchStats::score() const {
+    if (games() == 0) {
+        return 0.5;
+    }
+    return (wins + 0.5 * draws) / games();
+}
+
+double MatchStats::elo() const {
+    double s = score();
+    if (s <= 0. || s >= 1.) {
+        return 0.;
+    }
+    return score_to_elo(s);
+}
+
+double MatchStats::elo_error() const {
+    unsigned n = games();
+    if (n == 0) {
+        return 0.;
+    }
+    double s = score();
+    double variance = (wins * (1. - s) * (1. - s) +
+                       draws * (0.5 - s) * (0.5 - s) + losses * s * s) /
+                      n;
+    double margin = 1.959964 * std::sqrt(variance / n);
+
+    // keep the bounds inside ]0, 1[ so that they map to finite Elo
+    double low = std::max(s - margin, 1e-6);
+    double high = std::min(s + margin, 1. - 1e-6);
+    return (score_to_elo(high) - score_to_elo(low)) / 2.;
+}
+
+double MatchStats::llr(double elo0, double elo1) const {
+    unsigned n = games();
+    if (n == 0) {
+        return 0.;
+    }
+    double s = score();
+    double variance = (wins * (1. - s) * (1. - s) +
+                       draws * (0.5 - s) * (0.5 - s) + losses * s * s) /
+                      n;
+    if (variance <= 0.) {
+        return 0.;
+    } // all games alike, nothing can be told yet
+
+    double s0 = elo_to_score(elo0), s1 = elo_to_score(elo1);
+    return n * (s1 - s0) * (2. * s - s0 - s1) / (2. * variance);
+}
+
+int MatchStats::sprt(double elo0, double elo1, double alpha,
+                     double beta) const {
+    double ratio = llr(elo0, elo1);
+    if (ratio >= std::log((1. - beta) / alpha)) {
+        return H1;
+    }
+    if (ratio <= std::log(beta / (1. - alpha))) {
+        return H0;
+    }
+    return Continue;
+}
+
+void MatchStats::report(std::ostream &os, double elo0, double elo1) const {
+    std::stringstream ss;
+    ss << std::fixed;
+    ss << "games " << games() << ": +" << wins << " =" << draws << " -"
+       << losses << "\n";
+    ss.precision(1);
+    ss << "score " << 100. * score() << "%, elo " << elo() << " +/- "
+       << elo_error() << "\n";
+    ss.precision(2);
+    ss << "sprt [" << elo0 << ", " << elo1 << "] llr " << llr(elo0, elo1)
+       << " (" << std::log(0.05 / 0.95) << ", " << std::log(0.95 / 0.05)
+       << "): ";
+    switch (sprt(elo0, elo1)) {
+    case H0:
+        ss << "H0 accepted";
+        break;
+    case H1:
+        ss << "H1 accepted";
+        break;
+    default:
+        ss << "inconclusive";
+        break;
+    }
+    os << ss.str() << std::endl;
+}
+
+Match::Match(const EngineConfig &first, const EngineConfig &second,
+             unsigned threads)
+    : first(first), second(second) {
+    this->threads = std::max(threads, 1u);
+    this->elo0 = 0.;
+    this->elo1 = 5.;
+}
+
+Match::~Match() {}
+
+void Match::sprt(double elo0, double elo1) {
+    this->elo0 = elo0;
+    this->elo1 = elo1;
+}
+
+MatchStats Match::run(const std::string &filename, unsigned games,
+                      std::ostream *log) {
+    std::ifstream file(filename);
+    if (!file) {
+        panic("Could not open " + filename);
+    }
+
+    std::vector<Board> openings;
+    std::string line;
+    for (unsigned number = 1; std::getline(file, line); number++) {
+        line = trim(line);
+        if (line.empty() || line[0] == '#') {
+            continue;
+        }
+        try {
+            openings.push_back(Board::from_epd(line));
+        } catch (std::invalid_argument &e) {
+            panic(filename + ":" + std::to_string(number) + ": " + e.what());
+        }
+    }
+    if (openings.empty()) {
+        panic("No opening in " + filename);
+    }
+    if (games == 0) {
+        games = unsigned(2 * openings.size());
+    }
+
+    MatchStats stats;
+    std::mutex mutex;
+    std::atomic<unsigned> next(0);
+    std::atomic<bool> decided(false);
+
+    // game i plays opening i / 2, the first engine is white on even games
+    std::vector<ThreadPool::Task> workers;
+    unsigned count = std::min(threads, games);
+    for (unsigned i = 0; i < count; i++) {
+        workers.push_back(ThreadPool::global().submit([&]() {
+            TranspositionTable first_tt = TranspositionTable(first.megabytes);
+            TranspositionTable second_tt =
+                TranspositionTable(second.megabytes);
+            unsigned index;
+            while (!decided.load() && (index = next.fetch_add(1)) < games) {
+                const Board &opening = openings[(index / 2) % openings.size()];
+                bool first_white = index % 2 == 0;
+                first_tt.clear();
+                second_tt.clear();
+
+                std::string reason;
+                double white_score =
+                    first_white
+                        ? play(opening, first, second, first_tt, second_tt,
+                               reason)
+                        : play(opening, second, first, second_tt, first_tt,
+                               reason);
+                double score = first_white ? white_score : 1. - white_score;
+
+                std::lock_guard<std::mutex> lock(mutex);
+                if (score == 1.) {
+                    stats.wins++;
+                } else if (score == 0.) {
+                    stats.losses++;
+                } else {
+                    stats.draws++;
+                }
+                if (log != nullptr) {
+                    *log << "game " << index + 1 << ": "
+                         << (first_white ? "first - second " : "second - first ")
+                         << (white_score == 1.   ? "1-0"
+                             : white_score == 0. ? "0-1"
+                                                 : "1/2-1/2")
+                         << " (" << reason << ")" << std::endl;
+                }
+                if (stats.sprt(elo0, elo1) != MatchStats::Continue) {
+                    decided.store(true);
+                }
+            }
+        }));
+    }
+    for (ThreadPool::Task &worker : workers) {
+        worker.wait();
+    }
+    return stats;
+}
+
+double Match::play(const Board &opening, const EngineConfig &white,
+                   const EngineConfig &black, TranspositionTable &white_tt,
+                   TranspositionTable &black_tt, std::string &reason) {
+    Board board = opening;
+    History keys;
+
+    for (unsigned ply = 0;; ply++) {
+        std::vector<Move> legal_moves = board.get_legal_moves();
+        bool white_to_move = board.get_turn_color() == Color::White;
+        if (legal_moves.empty()) {
+            if (board.is_in_check(board.get_turn_color())) {
+                reason = "checkmate";
+                return white_to_move ? 0. : 1.;
+            }
+            reason = "stalemate";
+            return 0.5;
+        }
+        if (board.is_fifty_moves()) {
+            reason = "fifty moves";
+            return 0.5;
+        }
+        if (keys.repeated(board.get_key(), board.get_halfmove_clock(), 2)) {
+            reason = "repetition";
+            return 0.5;
+        }
+        if (board.has_insufficient_material(Color::White) &&
+            board.has_insufficient_material(Color::Black)) {
+            reason = "insufficient material";
+            return 0.5;
+        }
+        if (ply >= MAX_PLIES) {
+            reason = "adjudication";
+            return 0.5;
+        }
+
+        const EngineConfig &engine = white_to_move ? white : black;
+        SearchContext context =
+            SearchContext(keys, white_to_move ? &white_tt : &black_tt);
+        context.limit(engine.limits);
+        Move m = std::get<0>(
+            board.get_next_best_move(engine.limits.depth, context));
+
+        keys.push(board.get_key());
+        board = board.apply_eval_move(m, true);
+    }
+}
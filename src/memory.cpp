@@ -0,0 +1,140 @@
+#include "memory.h"
+
+#include <sys/mman.h>
+
+// blocks smaller than this are never worth a huge page
+static const std::size_t MIN_HUGE_BLOCK = LargeMemory::HUGE_PAGE;
+// alignment of heap blocks (a cache line)
+static const std::size_t HEAP_ALIGNMENT = 64;
+// page size assumed when touching pages one by one
+static const std::size_t SMALL_PAGE = 4096;
+
+/**
+ * @brief if transparent huge pages can be given to a mapping that asks for
+ * them (the `enabled` setting is `always` or `madvise`)
+ *
+ * @return true - if they can
+ * @return false - otherwise
+ */
+static bool transparent_huge_pages() {
+    std::ifstream file("/sys/kernel/mm/transparent_hugepage/enabled");
+    std::string setting;
+    return std::getline(file, setting) &&
+           setting.find("[never]") == std::string::npos;
+}
+
+/**
+ * @brief rounds a size up to a whole number of huge pages
+ *
+ * @param bytes size
+ * @return std::size_t - rounded size
+ */
+static std::size_t huge_size(std::size_t bytes) {
+    return (bytes + LargeMemory::HUGE_PAGE - 1) / LargeMemory::HUGE_PAGE *
+           LargeMemory::HUGE_PAGE;
+}
+
+void *LargeMemory::allocate(std::size_t bytes, int &mode) {
+    bytes = std::max<std::size_t>(bytes, 1);
+    int flags = MAP_PRIVATE | MAP_ANONYMOUS;
+    void *block;
+
+    if (bytes >= MIN_HUGE_BLOCK) {
+        block = mmap(nullptr, huge_size(bytes), PROT_READ | PROT_WRITE,
+                     flags | MAP_HUGETLB, -1, 0);
+        if (block != MAP_FAILED) {
+            mode = HugeTlb;
+            return block;
+        } // no huge page reserved (vm.nr_hugepages) most of the time
+
+        // a huge page more than needed, to cut an aligned block out of it
+        std::size_t length = huge_size(bytes);
+        block = mmap(nullptr, length + HUGE_PAGE, PROT_READ | PROT_WRITE,
+                     flags, -1, 0);
+        if (block != MAP_FAILED) {
+            uintptr_t start = reinterpret_cast<uintptr_t>(block);
+            uintptr_t aligned = (start + HUGE_PAGE - 1) / HUGE_PAGE * HUGE_PAGE;
+            if (aligned > start) {
+                munmap(block, aligned - start);
+            }
+            munmap(reinterpret_cast<void *>(aligned + length),
+                   start + HUGE_PAGE - aligned);
+            block = reinterpret_cast<void *>(aligned);
+            mode = madvise(block, length, MADV_HUGEPAGE) == 0 &&
+                           transparent_huge_pages()
+                       ? Transparent
+                       : SmallPages;
+            return block;
+        }
+    } else {
+        block = mmap(nullptr, bytes, PROT_READ | PROT_WRITE, flags, -1, 0);
+        if (block != MAP_FAILED) {
+            mode = SmallPages;
+            return block;
+        }
+    }
+
+    // no mapping at all : an aligned block from the heap
+    block = std::aligned_alloc(HEAP_ALIGNMENT, (bytes + HEAP_ALIGNMENT - 1) /
+                                                   HEAP_ALIGNMENT *
+                                                   HEAP_ALIGNMENT);
+    if (block == nullptr) {
+        throw std::bad_alloc();
+    }
+    std::memset(block, 0, bytes);
+    mode = Heap;
+    return block;
+}
+
+void LargeMemory::release(void *block, std::size_t bytes, int mode) {
+    if (block == nullptr) {
+        return;
+    }
+    bytes = std::max<std::size_t>(bytes, 1);
+    switch (mode) {
+    case HugeTlb:
+    case Transparent:
+        munmap(block, huge_size(bytes));
+        break;
+    case SmallPages:
+        munmap(block, bytes >= MIN_HUGE_BLOCK ? huge_size(bytes) : bytes);
+        break;
+    case Heap:
+        std::free(block);
+        break;
+    default:
+        panic("unknown memory mode");
+    }
+}
+
+void LargeMemory::prefault(void *block, std::size_t bytes) {
+#ifdef MADV_POPULATE_WRITE
+    if (reinterpret_cast<uintptr_t>(block) % SMALL_PAGE == 0 &&
+        madvise(block, bytes, MADV_POPULATE_WRITE) == 0) {
+        return;
+    } // the kernel faults the whole range in one call (linux 5.14)
+#endif
+    // a write per page, that changes nothing
+    char *base = static_cast<char *>(block);
+    for (std::size_t offset = 0; offset + sizeof(u_int64_t) <= bytes;
+         offset += SMALL_PAGE) {
+        std::atomic_ref<u_int64_t>(
+            *reinterpret_cast<u_int64_t *>(base + offset))
+            .fetch_add(0, std::memory_order_relaxed);
+    }
+}
+
+const char *LargeMemory::name(int mode) {
+    switch (mode) {
+    case HugeTlb:
+        return "huge pages";
+    case Transparent:
+        return "transparent huge pages";
+    case SmallPages:
+        return "small pages";
+    case Heap:
+        return "heap";
+    default:
+        return "unknown";
+    }
+}
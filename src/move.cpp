@@ -28,6 +28,19 @@ void Move::from(const Position &from) { from_ = std::move(from); }
 
 void Move::to(const Position &to) { to_ = std::move(to); }
 
+/**
+ * @brief reads a square such as "e4" without building a string
+ *
+ * @param str square
+ * @return Position - position (off board if unreadable)
+ */
+static Position square(std::string_view str) {
+    if (str.size() != 2) {
+        return Position(-1, -1);
+    }
+    return Position(str[1] - '1', str[0] - 'a');
+}
+
 int Move::update_from_string(const std::string &move_string) {
     if (move_string == "resign" || move_string == "resigns") {
         this->move_type_ = Resign;
@@ -43,29 +56,36 @@ int Move::update_from_string(const std::string &move_string) {
         this->move_type_ = KingSideCastle;
         return KingSideCastle;
     } else {
-        std::vector<std::string> move_parts;
-        std::string delim = " ";
-        size_t last = 0, next = 0;
-        while ((next = move_string.find(delim, last)) != std::string::npos) {
-            move_parts.push_back(move_string.substr(last, next - last));
-            last = next + delim.length();
+        // up to three words, split in place
+        std::string_view parts[3];
+        std::string_view rest = move_string;
+        unsigned count = 0;
+        while (true) {
+            std::string_view::size_type next = rest.find(' ');
+            if (count == 3) {
+                count++;
+                break;
+            }
+            parts[count++] = rest.substr(0, next);
+            if (next == std::string_view::npos) {
+                break;
+            }
+            rest.remove_prefix(next + 1);
         }
-        move_parts.push_back(move_string.substr(last));
 
-        if (move_parts.size() == 1 && move_parts[0].size() == 4) {
-            from_ = Position(move_parts[0].substr(0, 2));
-            to_ = Position(move_parts[0].substr(2, 2));
+        if (count == 1 && parts[0].size() == 4) {
+            from_ = square(parts[0].substr(0, 2));
+            to_ = square(parts[0].substr(2, 2));
             this->move_type_ = PieceMove;
             return PieceMove;
-        } else if (move_parts.size() == 2) {
-            from_ = Position(move_parts[0]);
-            to_ = Position(move_parts[1]);
+        } else if (count == 2) {
+            from_ = square(parts[0]);
+            to_ = square(parts[1]);
             this->move_type_ = PieceMove;
             return PieceMove;
-        } else if (move_parts.size() == 3 &&
-                   (move_parts[1] == "to" || move_parts[1] == "->")) {
-            from_ = Position(move_parts[0]);
-            to_ = Position(move_parts[2]);
+        } else if (count == 3 && (parts[1] == "to" || parts[1] == "->")) {
+            from_ = square(parts[0]);
+            to_ = square(parts[2]);
             this->move_type_ = PieceMove;
             return PieceMove;
         } else {
@@ -75,6 +95,31 @@ int Move::update_from_string(const std::string &move_string) {
     }
 }
 
+u_int16_t Move::pack() const {
+    if (move_type_ != PieceMove) {
+        return u_int16_t(move_type_ << 12);
+    }
+    return u_int16_t((move_type_ << 12) | ((from_.row() * 8 + from_.col()) << 6) |
+                     (to_.row() * 8 + to_.col()));
+}
+
+Move Move::unpack(u_int16_t packed) {
+    Move move;
+    move.move_type_ = (packed >> 12) & 0b111;
+    if (move.move_type_ == PieceMove) {
+        move.from_ = Position((packed >> 9) & 0b111, (packed >> 6) & 0b111);
+        move.to_ = Position((packed >> 3) & 0b111, packed & 0b111);
+    }
+    return move;
+}
+
+bool Move::operator==(const Move &other) const {
+    return move_type_ == other.move_type_ && from_ == other.from_ &&
+           to_ == other.to_;
+}
+
+bool Move::operator!=(const Move &other) const { return !(*this == other); }
+
 std::ostream &operator<<(std::ostream &os, const Move &move) {
     switch (move.move_type_) {
     case Move::PieceMove:
@@ -0,0 +1,176 @@
+#include "notation.h"
+
+/**
+ * @brief Get the piece type of a SAN piece letter
+ *
+ * @param c letter
+ * @return int - piece type, or Piece::None
+ */
+static int piece_type(char c) {
+    switch (c) {
+    case 'K':
+        return Piece::King;
+    case 'Q':
+        return Piece::Queen;
+    case 'R':
+        return Piece::Rook;
+    case 'B':
+        return Piece::Bishop;
+    case 'N':
+        return Piece::Knight;
+    default:
+        return Piece::None;
+    }
+}
+
+int Notation::parse(Board &board, std::string_view str, Move &move,
+                    int *promotion) {
+    std::vector<Move> legal_moves = board.get_legal_moves();
+    return parse(board, str, legal_moves, move, promotion);
+}
+
+int Notation::parse(Board &board, std::string_view str,
+                    const std::vector<Move> &legal_moves, Move &move,
+                    int *promotion) {
+    // annotations and check marks
+    while (!str.empty() && (str.back() == '+' || str.back() == '#' ||
+                            str.back() == '!' || str.back() == '?')) {
+        str.remove_suffix(1);
+    }
+    if (str.empty()) {
+        return Unreadable;
+    }
+
+    int castle = Move::Invalid;
+    if (str == "O-O" || str == "0-0" || str == "o-o") {
+        castle = Move::KingSideCastle;
+    } else if (str == "O-O-O" || str == "0-0-0" || str == "o-o-o") {
+        castle = Move::QueenSideCastle;
+    }
+
+    int type = Piece::None, promoted = Piece::Queen;
+    bool written = false; // if a promotion piece was given
+    int from_col = -1, from_row = -1, to_col = -1, to_row = -1;
+    if (castle == Move::Invalid) {
+        type = piece_type(str.front());
+        if (type != Piece::None) {
+            str.remove_prefix(1);
+        }
+
+        // promotion piece, "=Q" or a trailing letter ("e8Q", "e7e8q")
+        std::string_view::size_type equal = str.find('=');
+        if (equal != std::string_view::npos) {
+            if (equal + 2 != str.size()) {
+                return Unreadable;
+            }
+            promoted = piece_type(char(toupper(str.back())));
+            written = true;
+            str = str.substr(0, equal);
+        } else if (str.size() > 2 && isalpha(str.back()) &&
+                   isdigit(str[str.size() - 2])) {
+            promoted = piece_type(char(toupper(str.back())));
+            written = true;
+            str.remove_suffix(1);
+        } // no letter : a pawn reaching the last row becomes a queen
+        if (promoted == Piece::None || promoted == Piece::King) {
+            return Unreadable;
+        }
+
+        // up to four coordinates, the last two are the destination
+        char coordinates[4];
+        unsigned count = 0;
+        for (char c : str) {
+            if ((c >= 'a' && c <= 'h') || (c >= '1' && c <= '8')) {
+                if (count == 4) {
+                    return Unreadable;
+                }
+                coordinates[count++] = c;
+            } else if (c != 'x' && c != '-' && c != ':') {
+                return Unreadable;
+            }
+        }
+        if (count < 2 || !isalpha(coordinates[count - 2]) ||
+            !isdigit(coordinates[count - 1])) {
+            return Unreadable;
+        }
+        to_col = coordinates[count - 2] - 'a';
+        to_row = coordinates[count - 1] - '1';
+        for (unsigned i = 0; i + 2 < count; i++) {
+            if (isalpha(coordinates[i])) {
+                from_col = coordinates[i] - 'a';
+            } else {
+                from_row = coordinates[i] - '1';
+            }
+        }
+
+        // pawn moves have no letter, unless the origin is given in full
+        if (type == Piece::None && (from_col < 0 || from_row < 0)) {
+            type = Piece::Pawn;
+        }
+    }
+
+    int matches = 0;
+    for (const Move &m : legal_moves) {
+        if (m.move_type() == Move::KingSideCastle ||
+            m.move_type() == Move::QueenSideCastle) {
+            // "O-O", or the king move in long notation (e1g1)
+            bool is_match = m.move_type() == castle;
+            if (castle == Move::Invalid && from_col == 4 &&
+                from_row == to_row && (type == Piece::None ||
+                                       type == Piece::King)) {
+                Piece *king = board.get_piece(Position(from_row, from_col));
+                is_match = king != nullptr &&
+                           king->get_type() == Piece::King &&
+                           to_col == (m.move_type() == Move::KingSideCastle
+                                          ? 6
+                                          : 2);
+            }
+            if (is_match) {
+                move = m;
+                matches++;
+            }
+            continue;
+        }
+        if (castle != Move::Invalid || m.move_type() != Move::PieceMove ||
+            m.to().row() != to_row || m.to().col() != to_col ||
+            (from_col >= 0 && m.from().col() != from_col) ||
+            (from_row >= 0 && m.from().row() != from_row)) {
+            continue;
+        }
+        Piece *piece = board.get_piece(m.from());
+        if (type != Piece::None &&
+            (piece == nullptr || piece->get_type() != type)) {
+            continue;
+        }
+        bool promotes = piece != nullptr && piece->get_type() == Piece::Pawn &&
+                        (to_row == 0 || to_row == 7);
+        if (written && !promotes) {
+            continue;
+        } // a promotion piece after a move that does not promote
+        move = m;
+        matches++;
+    }
+
+    if (matches == 0) {
+        return Illegal;
+    }
+    if (promotion != nullptr) {
+        *promotion = promoted;
+    }
+    return matches == 1 ? Ok : Ambiguous;
+}
+
+const char *Notation::error(int result) {
+    switch (result) {
+    case Ok:
+        return "ok";
+    case Unreadable:
+        return "unreadable move";
+    case Illegal:
+        return "illegal move";
+    case Ambiguous:
+        return "ambiguous move";
+    default:
+        panic("Invalid notation result");
+    }
+}
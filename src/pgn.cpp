@@ -0,0 +1,191 @@
+#include "pgn.h"
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+/**
+ * @brief if the character ends a movetext token
+ *
+ * @param c character
+ * @return true - if delimiter
+ * @return false - otherwise
+ */
+static bool is_delimiter(char c) {
+    return isspace(static_cast<unsigned char>(c)) || c == '{' || c == '}' ||
+           c == '(' || c == ')' || c == '[' || c == ']' || c == ';' ||
+           c == '$';
+}
+
+PgnGame::PgnGame() {}
+
+PgnGame::~PgnGame() {}
+
+void PgnGame::clear() {
+    tags.clear();
+    moves.clear();
+    result = std::string_view();
+}
+
+std::string_view PgnGame::tag(std::string_view name) const {
+    for (const auto &tag : tags) {
+        if (tag.first == name) {
+            return tag.second;
+        }
+    }
+    return std::string_view();
+}
+
+PgnReader::PgnReader(const std::string &filename) {
+    this->data = nullptr;
+    this->length = 0;
+    this->offset = 0;
+
+    int fd = open(filename.c_str(), O_RDONLY);
+    if (fd == -1) {
+        panic("Could not open " + filename);
+    }
+    struct stat st;
+    chk(fstat(fd, &st));
+    length = std::size_t(st.st_size);
+
+    if (length > 0) {
+        void *mapped = mmap(nullptr, length, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (mapped == MAP_FAILED) {
+            panic("Could not map " + filename);
+        }
+        madvise(mapped, length, MADV_SEQUENTIAL); // read once, front to back
+        data = static_cast<const char *>(mapped);
+    }
+    chk(close(fd));
+}
+
+PgnReader::~PgnReader() {
+    if (data != nullptr) {
+        munmap(const_cast<char *>(data), length);
+    }
+}
+
+std::size_t PgnReader::size() const { return length; }
+
+void PgnReader::skip() {
+    while (offset < length) {
+        char c = data[offset];
+        if (isspace(static_cast<unsigned char>(c))) {
+            offset++;
+        } else if (c == '{') {
+            // comment, up to the closing brace
+            while (offset < length && data[offset] != '}') {
+                offset++;
+            }
+            offset++;
+        } else if (c == ';' ||
+                   (c == '%' && (offset == 0 || data[offset - 1] == '\n'))) {
+            // rest of line comment, escaped line
+            while (offset < length && data[offset] != '\n') {
+                offset++;
+            }
+        } else if (c == '$') {
+            // numeric annotation glyph
+            offset++;
+            while (offset < length && isdigit(data[offset])) {
+                offset++;
+            }
+        } else if (c == '(') {
+            // variation, possibly nested and with comments
+            int nesting = 0;
+            while (offset < length) {
+                c = data[offset];
+                if (c == '{') {
+                    while (offset < length && data[offset] != '}') {
+                        offset++;
+                    }
+                } else if (c == '(') {
+                    nesting++;
+                } else if (c == ')' && --nesting == 0) {
+                    break;
+                }
+                offset++;
+            }
+            offset++;
+        } else if (c == ')' || c == '}' || c == ']') {
+            offset++; // unbalanced, ignored
+        } else {
+            return;
+        }
+    }
+}
+
+bool PgnReader::next(PgnGame &game) {
+    game.clear();
+    bool in_moves = false;
+
+    while (true) {
+        skip();
+        if (offset >= length) {
+            return in_moves || !game.tags.empty();
+        }
+
+        if (data[offset] == '[') {
+            if (in_moves) {
+                return true;
+            } // tags of the next game, the result was missing
+
+            // [Name "Value"]
+            std::size_t start = ++offset;
+            while (offset < length && !isspace(data[offset]) &&
+                   data[offset] != '"' && data[offset] != ']') {
+                offset++;
+            }
+            std::string_view name(data + start, offset - start);
+            while (offset < length && data[offset] != '"' &&
+                   data[offset] != ']') {
+                offset++;
+            }
+            std::string_view value;
+            if (offset < length && data[offset] == '"') {
+                start = ++offset;
+                while (offset < length && data[offset] != '"') {
+                    offset += data[offset] == '\\' ? 2 : 1;
+                }
+                value = std::string_view(data + start,
+                                         std::min(offset, length) - start);
+            }
+            while (offset < length && data[offset] != ']' &&
+                   data[offset] != '\n') {
+                offset++;
+            }
+            game.tags.emplace_back(name, value);
+            continue;
+        }
+
+        std::size_t start = offset;
+        while (offset < length && !is_delimiter(data[offset])) {
+            offset++;
+        }
+        std::string_view token(data + start, offset - start);
+        in_moves = true;
+
+        if (token == "1-0" || token == "0-1" || token == "1/2-1/2" ||
+            token == "*") {
+            game.result = token;
+            return true;
+        }
+
+        // move numbers, possibly glued to the move ("12.Nf3", "12...Nf6")
+        std::size_t i = 0;
+        while (i < token.size() && isdigit(token[i])) {
+            i++;
+        }
+        if (i < token.size() && token[i] != '.') {
+            i = 0;
+        } // not a move number : "0-0" or a move
+        while (i < token.size() && token[i] == '.') {
+            i++;
+        }
+        token.remove_prefix(i);
+        if (!token.empty()) {
+            game.moves.push_back(token);
+        }
+    }
+}
@@ -1,5 +1,6 @@
 #include "piece.h"
 
+#include "attacks.h"
 #include "board.h"
 
 double WHITE_KING_POSITION_WEIGHTS[8][8] = {
@@ -160,25 +161,105 @@ Piece::Piece(Color color, Position position, bool starting_piece) {
 
 Piece::~Piece() {}
 
-Piece *Piece::from_id(int type, Color color, const Position pos) {
+/**
+ * @brief The PieceStorage struct
+ *
+ * Room for one piece of any type, the types only differ by their methods.
+ */
+struct PieceStorage {
+    alignas(class Queen) unsigned char bytes[sizeof(class Queen)];
+};
+
+static_assert(sizeof(class King) == sizeof(PieceStorage) &&
+                  sizeof(class Pawn) == sizeof(PieceStorage) &&
+                  sizeof(class Knight) == sizeof(PieceStorage) &&
+                  sizeof(class Bishop) == sizeof(PieceStorage) &&
+                  sizeof(class Rook) == sizeof(PieceStorage),
+              "pieces should all have the same size");
+
+/**
+ * @brief builds a piece in place, only when filling the shared pieces
+ *
+ * @param type type of the piece
+ * @param color color of the piece
+ * @param pos position
+ * @param storage where to build it
+ * @return Piece* - new Piece
+ */
+static Piece *make_piece(int type, Color color, const Position pos,
+                         PieceStorage &storage) {
     switch (type) {
-    case 1:
-        return new class King(color, pos);
-    case 2:
-        return new class Pawn(color, pos);
-    case 3:
-        return new class Knight(color, pos);
-    case 4:
-        return new class Bishop(color, pos);
-    case 5:
-        return new class Rook(color, pos);
-    case 6:
-        return new class Queen(color, pos);
+    case Piece::King:
+        return new (storage.bytes) class King(color, pos);
+    case Piece::Pawn:
+        return new (storage.bytes) class Pawn(color, pos);
+    case Piece::Knight:
+        return new (storage.bytes) class Knight(color, pos);
+    case Piece::Bishop:
+        return new (storage.bytes) class Bishop(color, pos);
+    case Piece::Rook:
+        return new (storage.bytes) class Rook(color, pos);
+    case Piece::Queen:
+        return new (storage.bytes) class Queen(color, pos);
     default:
         panic("Invalid piece id");
     }
 }
 
+/**
+ * @brief if no piece stands strictly between two positions on a line
+ *
+ * @param from first position
+ * @param to second position
+ * @param board board
+ * @return true - if the way is free
+ * @return false - otherwise
+ */
+static bool is_path_clear(const Position &from, const Position &to,
+                          Board &board) {
+    for (u_int64_t between = from.squares_between(to); between != 0;
+         between &= between - 1) {
+        if (board.has_piece(Position::from_index(std::countr_zero(between)))) {
+            return false;
+        }
+    }
+    return true;
+}
+
+Piece *Piece::from_id(int type, Color color, const Position pos) {
+    if (type < Piece::King || type > Piece::Queen) {
+        panic("Invalid piece id");
+    }
+    assert_debug(pos.is_on_board());
+    int id = type | (color == Color::White ? Piece::White : Piece::Black);
+    return Piece::from_square(id, (7 - pos.row()) * 8 + pos.col());
+}
+
+Piece *Piece::from_square(int id, int index) {
+    // every type, color and square : 768 pieces built in static storage on
+    // first use and never destroyed (threads may still search at exit), the
+    // other ids stay nullptr
+    static Piece *const *pieces = []() {
+        static PieceStorage storage[6 * 2 * 64];
+        static Piece *table[32 * 64] = {};
+        PieceStorage *next = storage;
+        for (int type = Piece::King; type <= Piece::Queen; type++) {
+            for (Color color : {Color::White, Color::Black}) {
+                int id = type | (color == Color::White ? Piece::White
+                                                       : Piece::Black);
+                for (int i = 0; i < 64; i++) {
+                    table[id * 64 + i] = make_piece(
+                        type, color, Position(7 - i / 8, i % 8), *next++);
+                }
+            }
+        }
+        return table;
+    }();
+
+    assert_debug(id >= 0 && id < 32 && index >= 0 && index < 64);
+    return pieces[id * 64 + index];
+}
+
 bool Piece::is_sliding_piece(int piece) { return (piece & 0b100) != 0; }
 
 Color Piece::get_color() const { return this->color; }
@@ -187,31 +268,7 @@ Position Piece::get_pos() const { return this->position; }
 
 int Piece::get_type() const { return this->id & Piece::type_mask; }
 
-std::vector<Move> Piece::get_valid_moves(std::vector<Move> &result,
-                                         Board &board) {
-    Color ally_color = this->get_color();
-    std::vector<Move> moves;
-
-    // TODO: Optimize this
-    for (Move move : result) {
-        switch (move.move_type()) {
-        case Move::PieceMove:
-            if (move.from().is_on_board() && move.to().is_on_board()) {
-                if (board.is_legal_move(move, ally_color, true)) {
-                    moves.push_back(move);
-                }
-            }
-            break;
-        default:
-            if (board.is_legal_move(move, ally_color, true)) {
-                moves.push_back(move);
-            }
-            break;
-        }
-    }
-
-    return moves;
-}
+int Piece::get_id() const { return this->id; }
 
 bool Piece::operator==(const Piece &piece) const {
     return this->get_color() == piece.get_color() &&
@@ -224,8 +281,6 @@ Pawn::Pawn(Color color, Position position, bool starting_piece)
     this->id |= Piece::Pawn;
 }
 
-Pawn *Pawn::clone() const { return new Pawn(*this); }
-
 Pawn::~Pawn() {}
 
 std::ostream &Pawn::operator<<(std::ostream &os) const {
@@ -245,7 +300,8 @@ std::string Pawn::to_string() const {
 }
 
 Pawn *Pawn::move_to(Position new_pos) const {
-    return new Pawn(this->color, new_pos);
+    return static_cast<Pawn *>(
+        Piece::from_id(Piece::Pawn, this->color, new_pos));
 }
 
 std::string Pawn::get_name() const { return "pawn"; }
@@ -285,62 +341,6 @@ bool Pawn::is_queenside_rook() const { return false; }
 
 bool Pawn::is_kingside_rook() const { return false; }
 
-std::vector<Move> Pawn::get_legal_moves(Board &board) {
-    std::vector<Move> result;
-    Color ally_color = this->get_color();
-    Position pos = this->get_pos();
-
-    Position up = pos.pawn_up(ally_color); // up or down depending on color
-    Position next_up = up.pawn_up(ally_color);
-    Position up_left = up.next_left();
-    Position up_right = up.next_right();
-
-    Position *en_passant = board.get_en_passant();
-    if (en_passant != nullptr) {
-        if (*en_passant == up_left || *en_passant == up_right) {
-            Move move;
-            move.move_type() = Move::PieceMove;
-            move.from() = pos;
-            move.to() = *en_passant;
-            result.push_back(move);
-        } // if en passant is on the left or right
-    }
-
-    if (next_up.is_on_board() && this->is_starting_pawn() &&
-        board.has_no_piece(up) && board.has_no_piece(next_up)) {
-        Move move;
-        move.move_type() = Move::PieceMove;
-        move.from() = pos;
-        move.to() = next_up;
-        result.push_back(move);
-    } // if pawn is on starting row and can move two squares
-
-    if (up.is_on_board() && board.has_no_piece(up)) {
-        Move move;
-        move.move_type() = Move::PieceMove;
-        move.from() = pos;
-        move.to() = up;
-        result.push_back(move);
-    } // if pawn can move one square
-
-    if (up_left.is_on_board() && board.has_enemy_piece(up_left, ally_color)) {
-        Move move;
-        move.move_type() = Move::PieceMove;
-        move.from() = pos;
-        move.to() = up_left;
-        result.push_back(move);
-    } // if pawn can attack left
-    if (up_right.is_on_board() && board.has_enemy_piece(up_right, ally_color)) {
-        Move move;
-        move.move_type() = Move::PieceMove;
-        move.from() = pos;
-        move.to() = up_right;
-        result.push_back(move);
-    } // if pawn can attack right
-
-    return this->get_valid_moves(result, board);
-}
-
 bool Pawn::is_legal_move(const Position &new_pos, Board &board) {
     if (board.has_ally_piece(new_pos, this->get_color()) ||
         new_pos.is_off_board()) {
@@ -373,20 +373,10 @@ bool Pawn::is_legal_attack(const Position &new_pos, Board &board) {
     if (board.has_ally_piece(new_pos, this->get_color()) ||
         new_pos.is_off_board()) {
         return false;
-    }
-    Color ally_color = this->get_color();
-    Position pos = this->get_pos();
-
-    Position up = pos.pawn_up(ally_color);
-    Position *en_passant = board.get_en_passant();
-    bool tmp = false;
-    if (en_passant != nullptr) {
-        tmp = ((*en_passant == up.next_left() ||
-                *en_passant == up.next_right()) &&
-               new_pos == *en_passant);
-    }
-
-    return tmp || new_pos == up.next_left() || new_pos == up.next_right();
+    } // en passant squares are among the attacked ones
+    return (Attacks::pawn(this->get_color(), this->get_pos()) >>
+            new_pos.index()) &
+           1;
 }
 
 King::King(Color color, Position position, bool starting_piece)
@@ -396,8 +386,6 @@ King::King(Color color, Position position, bool starting_piece)
 
 King::~King() {}
 
-King *King::clone() const { return new King(*this); }
-
 std::ostream &King::operator<<(std::ostream &os) const {
     return os << this->to_string();
 }
@@ -415,7 +403,8 @@ std::string King::to_string() const {
 }
 
 King *King::move_to(Position new_pos) const {
-    return new King(this->color, new_pos);
+    return static_cast<King *>(
+        Piece::from_id(Piece::King, this->color, new_pos));
 }
 
 std::string King::get_name() const { return "king"; }
@@ -453,48 +442,13 @@ bool King::is_queenside_rook() const { return false; }
 
 bool King::is_kingside_rook() const { return false; }
 
-std::vector<Move> King::get_legal_moves(Board &board) {
-    std::vector<Move> result;
-    Color ally_color = this->get_color();
-    Position pos = this->get_pos();
-
-    for (Position p : {
-             pos.next_left(),
-             pos.next_right(),
-             pos.next_above(),
-             pos.next_below(),
-             pos.next_left().next_above(),
-             pos.next_left().next_below(),
-             pos.next_right().next_above(),
-             pos.next_right().next_below(),
-         }) {
-        if (p.is_on_board() && !board.has_ally_piece(p, ally_color)) {
-            Move move;
-            move.move_type() = Move::PieceMove;
-            move.from() = pos;
-            move.to() = p;
-            result.push_back(move);
-        } // for all adjacent squares, if enemy or empty
-    }
-    if (board.can_kingside_castle(ally_color)) {
-        Move move;
-        move.move_type() = Move::KingSideCastle;
-        result.push_back(move);
-    } else if (board.can_queenside_castle(ally_color)) {
-        Move move;
-        move.move_type() = Move::QueenSideCastle;
-        result.push_back(move);
-    } // if can castle
-    return this->get_valid_moves(result, board);
-}
-
 bool King::is_legal_move(const Position &new_pos, Board &board) {
     if (board.has_ally_piece(new_pos, this->get_color()) ||
         new_pos.is_off_board()) {
         return false;
     }
 
-    return this->position.is_adjacent_to(new_pos);
+    return (Attacks::king(this->position).mask >> new_pos.index()) & 1;
 }
 
 bool King::is_legal_attack(const Position &new_pos, Board &board) {
@@ -508,8 +462,6 @@ Queen::Queen(Color color, Position position, bool starting_piece)
 
 Queen::~Queen() {}
 
-Queen *Queen::clone() const { return new Queen(*this); }
-
 std::ostream &Queen::operator<<(std::ostream &os) const {
     return os << this->to_string();
 }
@@ -527,7 +479,8 @@ std::string Queen::to_string() const {
 }
 
 Queen *Queen::move_to(Position new_pos) const {
-    return new Queen(this->color, new_pos);
+    return static_cast<Queen *>(
+        Piece::from_id(Piece::Queen, this->color, new_pos));
 }
 
 std::string Queen::get_name() const { return "queen"; }
@@ -565,49 +518,6 @@ bool Queen::is_queenside_rook() const { return false; }
 
 bool Queen::is_kingside_rook() const { return false; }
 
-std::vector<Move> Queen::get_legal_moves(Board &board) {
-    std::vector<Move> result;
-    Color ally_color = this->get_color();
-    Position pos = this->get_pos();
-
-    for (unsigned row = 0; row < 8; row++) {
-        Position new_pos = Position(row, pos.col());
-        if (new_pos != pos && !board.has_ally_piece(new_pos, ally_color) &&
-            new_pos.is_orthogonal_to(pos)) {
-            Move move;
-            move.move_type() = Move::PieceMove;
-            move.from() = pos;
-            move.to() = new_pos;
-            result.push_back(move);
-        } // for all squares on the same row, if enemy or empty
-    }
-    for (unsigned col = 0; col < 8; col++) {
-        Position new_pos = Position(pos.row(), col);
-        if (new_pos != pos && !board.has_ally_piece(new_pos, ally_color) &&
-            new_pos.is_orthogonal_to(pos)) {
-            Move move;
-            move.move_type() = Move::PieceMove;
-            move.from() = pos;
-            move.to() = new_pos;
-            result.push_back(move);
-        } // for all squares on the same column, if enemy or empty
-    }
-    for (unsigned row = 0; row < 8; row++) {
-        for (unsigned col = 0; col < 8; col++) {
-            Position new_pos = Position(row, col);
-            if (new_pos != pos && !board.has_ally_piece(new_pos, ally_color) &&
-                new_pos.is_diagonal_to(pos)) {
-                Move move;
-                move.move_type() = Move::PieceMove;
-                move.from() = pos;
-                move.to() = new_pos;
-                result.push_back(move);
-            } // for all squares on the same diagonal, if enemy or empty
-        }
-    }
-    return this->get_valid_moves(result, board);
-}
-
 bool Queen::is_legal_move(const Position &new_pos, Board &board) {
     if (board.has_ally_piece(new_pos, this->get_color()) ||
         new_pos.is_off_board()) {
@@ -615,26 +525,8 @@ bool Queen::is_legal_move(const Position &new_pos, Board &board) {
     }
 
     Position pos = this->get_pos();
-    if (pos.is_orthogonal_to(new_pos)) {
-        std::vector<Position> traveling = pos.orthogonals_to(new_pos);
-        traveling.pop_back();
-
-        for (Position p : traveling) {
-            if (board.has_piece(p)) {
-                return false;
-            }
-        }
-        return true;
-    } else if (pos.is_diagonal_to(new_pos)) {
-        std::vector<Position> traveling = pos.diagonals_to(new_pos);
-        traveling.pop_back();
-
-        for (Position p : traveling) {
-            if (board.has_piece(p)) {
-                return false;
-            }
-        }
-        return true;
+    if (pos.is_orthogonal_to(new_pos) || pos.is_diagonal_to(new_pos)) {
+        return is_path_clear(pos, new_pos, board);
     }
     return false;
 }
@@ -650,8 +542,6 @@ Rook::Rook(Color color, Position position, bool starting_piece)
 
 Rook::~Rook() {}
 
-Rook *Rook::clone() const { return new Rook(*this); }
-
 std::ostream &Rook::operator<<(std::ostream &os) const {
     return os << this->to_string();
 }
@@ -669,7 +559,8 @@ std::string Rook::to_string() const {
 }
 
 Rook *Rook::move_to(Position new_pos) const {
-    return new Rook(this->color, new_pos);
+    return static_cast<Rook *>(
+        Piece::from_id(Piece::Rook, this->color, new_pos));
 }
 
 std::string Rook::get_name() const { return "rook"; }
@@ -711,36 +602,6 @@ bool Rook::is_kingside_rook() const {
     return this->get_pos().is_kingside_rook();
 }
 
-std::vector<Move> Rook::get_legal_moves(Board &board) {
-    std::vector<Move> result;
-    Color ally_color = this->get_color();
-    Position pos = this->get_pos();
-
-    for (unsigned row = 0; row < 8; row++) {
-        Position new_pos = Position(row, pos.col());
-        if (new_pos != pos && !board.has_ally_piece(new_pos, ally_color) &&
-            new_pos.is_orthogonal_to(pos)) {
-            Move move;
-            move.move_type() = Move::PieceMove;
-            move.from() = pos;
-            move.to() = new_pos;
-            result.push_back(move);
-        }
-    } // for all squares on the same row, if enemy or empty
-    for (unsigned col = 0; col < 8; col++) {
-        Position new_pos = Position(pos.row(), col);
-        if (new_pos != pos && !board.has_ally_piece(new_pos, ally_color) &&
-            new_pos.is_orthogonal_to(pos)) {
-            Move move;
-            move.move_type() = Move::PieceMove;
-            move.from() = pos;
-            move.to() = new_pos;
-            result.push_back(move);
-        }
-    } // for all squares on the same column, if enemy or empty
-    return this->get_valid_moves(result, board);
-}
-
 bool Rook::is_legal_move(const Position &new_pos, Board &board) {
     if (board.has_ally_piece(new_pos, this->get_color()) ||
         new_pos.is_off_board()) {
@@ -749,15 +610,7 @@ bool Rook::is_legal_move(const Position &new_pos, Board &board) {
 
     Position pos = this->get_pos();
     if (pos.is_orthogonal_to(new_pos)) {
-        std::vector<Position> traveling = pos.orthogonals_to(new_pos);
-        traveling.pop_back();
-
-        for (Position p : traveling) {
-            if (board.has_piece(p)) {
-                return false;
-            }
-        }
-        return true;
+        return is_path_clear(pos, new_pos, board);
     }
     return false;
 }
@@ -773,8 +626,6 @@ Bishop::Bishop(Color color, Position position, bool starting_piece)
 
 Bishop::~Bishop() {}
 
-Bishop *Bishop::clone() const { return new Bishop(*this); }
-
 std::ostream &Bishop::operator<<(std::ostream &os) const {
     return os << this->to_string();
 }
@@ -792,7 +643,8 @@ std::string Bishop::to_string() const {
 }
 
 Bishop *Bishop::move_to(Position new_pos) const {
-    return new Bishop(this->color, new_pos);
+    return static_cast<Bishop *>(
+        Piece::from_id(Piece::Bishop, this->color, new_pos));
 }
 
 std::string Bishop::get_name() const { return "bishop"; }
@@ -830,27 +682,6 @@ bool Bishop::is_queenside_rook() const { return false; }
 
 bool Bishop::is_kingside_rook() const { return false; }
 
-std::vector<Move> Bishop::get_legal_moves(Board &board) {
-    std::vector<Move> result;
-    Color ally_color = this->get_color();
-    Position pos = this->get_pos();
-
-    for (unsigned row = 0; row < 8; row++) {
-        for (unsigned col = 0; col < 8; col++) {
-            Position new_pos = Position(row, col);
-            if (new_pos != pos && !board.has_ally_piece(new_pos, ally_color) &&
-                new_pos.is_diagonal_to(pos)) {
-                Move move;
-                move.move_type() = Move::PieceMove;
-                move.from() = pos;
-                move.to() = new_pos;
-                result.push_back(move);
-            } // for all squares on the same diagonal, if enemy or empty
-        }
-    }
-    return this->get_valid_moves(result, board);
-}
-
 bool Bishop::is_legal_move(const Position &new_pos, Board &board) {
     if (board.has_ally_piece(new_pos, this->get_color()) ||
         new_pos.is_off_board()) {
@@ -859,15 +690,7 @@ bool Bishop::is_legal_move(const Position &new_pos, Board &board) {
 
     Position pos = this->get_pos();
     if (pos.is_diagonal_to(new_pos)) {
-        std::vector<Position> traveling = pos.diagonals_to(new_pos);
-        traveling.pop_back();
-
-        for (Position p : traveling) {
-            if (board.has_piece(p)) {
-                return false;
-            }
-        }
-        return true;
+        return is_path_clear(pos, new_pos, board);
     }
     return false;
 }
@@ -883,8 +706,6 @@ Knight::Knight(Color color, Position position, bool starting_piece)
 
 Knight::~Knight() {}
 
-Knight *Knight::clone() const { return new Knight(*this); }
-
 std::ostream &Knight::operator<<(std::ostream &os) const {
     return os << this->to_string();
 }
@@ -902,7 +723,8 @@ std::string Knight::to_string() const {
 }
 
 Knight *Knight::move_to(Position new_pos) const {
-    return new Knight(this->color, new_pos);
+    return static_cast<Knight *>(
+        Piece::from_id(Piece::Knight, this->color, new_pos));
 }
 
 std::string Knight::get_name() const { return "knight"; }
@@ -940,39 +762,13 @@ bool Knight::is_queenside_rook() const { return false; }
 
 bool Knight::is_kingside_rook() const { return false; }
 
-std::vector<Move> Knight::get_legal_moves(Board &board) {
-    std::vector<Move> result;
-    Color ally_color = this->get_color();
-    Position pos = this->get_pos();
-
-    for (Position p : {
-             pos.next_left().next_left().next_above(),
-             pos.next_left().next_above().next_above(),
-             pos.next_left().next_left().next_below(),
-             pos.next_left().next_below().next_below(),
-             pos.next_right().next_right().next_above(),
-             pos.next_right().next_above().next_above(),
-             pos.next_right().next_right().next_below(),
-             pos.next_right().next_below().next_below(),
-         }) {
-        if (p.is_on_board() && !board.has_ally_piece(p, ally_color)) {
-            Move move;
-            move.move_type() = Move::PieceMove;
-            move.from() = pos;
-            move.to() = p;
-            result.push_back(move);
-        } // for all squares on the "L" shape, if enemy or empty
-    }
-    return this->get_valid_moves(result, board);
-}
-
 bool Knight::is_legal_move(const Position &new_pos, Board &board) {
     if (board.has_ally_piece(new_pos, this->get_color()) ||
         new_pos.is_off_board()) {
         return false;
     }
 
-    return this->get_pos().is_knight_move(new_pos);
+    return (Attacks::knight(this->get_pos()).mask >> new_pos.index()) & 1;
 }
 
 bool Knight::is_legal_attack(const Position &new_pos, Board &board) {
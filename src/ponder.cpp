@@ -0,0 +1,67 @@
+#include "ponder.h"
+
+Ponder::Ponder(TranspositionTable *tt, int depth) : search(tt) {
+    this->tt = tt;
+    this->depth = depth;
+    this->waiting_key = 0;
+    this->pondering_key = 0;
+}
+
+Ponder::~Ponder() { stop(); }
+
+bool Ponder::start(Board &board, const History &keys) {
+    if (is_running()) {
+        return false;
+    }
+
+    // the reply we expect is the refutation found by the last search
+    HashEntry entry;
+    if (!tt->probe(board.get_key(), entry)) {
+        return false;
+    }
+    std::vector<Move> legal_moves = board.get_legal_moves();
+    if (std::find(legal_moves.begin(), legal_moves.end(), entry.move) ==
+        legal_moves.end()) {
+        return false;
+    } // collision or stale entry
+
+    Board next = board.apply_eval_move(entry.move, true);
+    History next_keys = keys;
+    next_keys.push(board.get_key());
+
+    expected = entry.move;
+    waiting_key = board.get_key();
+    pondering_key = next.get_key();
+    search.start(next, next_keys, depth);
+    return true;
+}
+
+void Ponder::update(const Board &board) {
+    if (is_running() && board.get_key() != waiting_key &&
+        board.get_key() != pondering_key) {
+        stop();
+    }
+}
+
+void Ponder::stop() {
+    if (search.is_running()) {
+        search.stop();
+        search.wait();
+    }
+    expected = Move();
+}
+
+bool Ponder::is_running() const { return search.is_running(); }
+
+bool Ponder::is_pondering(const Board &board) const {
+    return is_running() && board.get_key() == pondering_key;
+}
+
+const Move &Ponder::expected_move() const { return expected; }
+
+std::tuple<Move, u_int64_t, double> Ponder::result() {
+    expected = Move();
+    return search.wait();
+}
+
+SearchThread &Ponder::search_thread() { return search; }
@@ -0,0 +1,189 @@
+#include "pool.h"
+
+#include <pthread.h>
+#include <sched.h>
+
+#include "profile.h"
+
+/**
+ * @brief The Task::State class
+ *
+ * Done flag of one job, set by the worker and waited for by the submitter.
+ */
+class ThreadPool::Task::State {
+  public:
+    std::mutex mutex;
+    std::condition_variable over;
+    bool done = false;
+};
+
+/**
+ * @brief pins a thread to one core
+ *
+ * @param thread thread
+ * @param core core number
+ */
+static void pin(std::thread &thread, int core) {
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    CPU_SET(core, &set);
+    pthread_setaffinity_np(thread.native_handle(), sizeof(set), &set);
+}
+
+ThreadPool::Task::Task() {}
+
+ThreadPool::Task::~Task() {}
+
+bool ThreadPool::Task::valid() const { return state != nullptr; }
+
+bool ThreadPool::Task::finished() const {
+    if (state == nullptr) {
+        return false;
+    }
+    std::lock_guard<std::mutex> lock(state->mutex);
+    return state->done;
+}
+
+void ThreadPool::Task::wait() {
+    if (state == nullptr) {
+        return;
+    }
+    std::function<void()> job;
+    if (pool != nullptr && pool->claim(state, job)) {
+        job();
+        std::lock_guard<std::mutex> lock(state->mutex);
+        state->done = true;
+        state->over.notify_all();
+    } // no worker took it : run here rather than wait for one
+
+    std::unique_lock<std::mutex> lock(state->mutex);
+    state->over.wait(lock, [this]() { return state->done; });
+    lock.unlock();
+    state.reset();
+}
+
+ThreadPool::ThreadPool() {
+    this->idle = 0;
+    this->wanted = 0;
+    this->stopping = false;
+}
+
+ThreadPool::~ThreadPool() {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+    }
+    wake.notify_all();
+    for (std::thread &worker : workers) {
+        worker.join();
+    }
+}
+
+ThreadPool &ThreadPool::global() {
+    static ThreadPool *pool = new ThreadPool(); // never joined at exit
+    return *pool;
+}
+
+void ThreadPool::start(unsigned threads, bool affinity) {
+    std::lock_guard<std::mutex> lock(mutex);
+    if (affinity && cores.empty()) {
+        cpu_set_t set;
+        CPU_ZERO(&set);
+        if (sched_getaffinity(0, sizeof(set), &set) == 0) {
+            for (int core = 0; core < CPU_SETSIZE; core++) {
+                if (CPU_ISSET(core, &set)) {
+                    cores.push_back(core);
+                }
+            }
+        }
+        for (std::size_t i = 0; i < workers.size() && !cores.empty(); i++) {
+            pin(workers[i], cores[i % cores.size()]);
+        }
+    }
+    wanted = std::max(wanted, threads);
+    while (workers.size() < threads) {
+        spawn();
+    }
+}
+
+ThreadPool::Task ThreadPool::submit(std::function<void()> job) {
+    Task task;
+    task.state = std::make_shared<Task::State>();
+    task.pool = this;
+
+    std::lock_guard<std::mutex> lock(mutex);
+    jobs.push_back(Job{std::move(job), task.state});
+    // an idle worker for every waiting job, or one more worker if allowed,
+    // or the job waits for a worker to be free
+    unsigned most = OVERFLOW_FACTOR * std::max(wanted, 1u);
+    if (idle < jobs.size() && workers.size() < most) {
+        spawn();
+    } else {
+        wake.notify_one();
+    }
+    return task;
+}
+
+unsigned ThreadPool::size() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return unsigned(workers.size());
+}
+
+unsigned ThreadPool::limit() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return OVERFLOW_FACTOR * std::max(wanted, 1u);
+}
+
+bool ThreadPool::pinned() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return !cores.empty();
+}
+
+void ThreadPool::spawn() {
+    unsigned index = unsigned(workers.size());
+    idle++; // until it takes a job
+    workers.emplace_back([this]() { work(); });
+    if (!cores.empty()) {
+        pin(workers.back(), cores[index % cores.size()]);
+    }
+}
+
+bool ThreadPool::claim(const std::shared_ptr<Task::State> &state,
+                       std::function<void()> &job) {
+    std::lock_guard<std::mutex> lock(mutex);
+    for (auto it = jobs.begin(); it != jobs.end(); ++it) {
+        if (it->state == state) {
+            job = std::move(it->run);
+            jobs.erase(it);
+            return true;
+        }
+    }
+    return false;
+}
+
+void ThreadPool::work() {
+    std::unique_lock<std::mutex> lock(mutex);
+    while (true) {
+        wake.wait(lock, [this]() { return stopping || !jobs.empty(); });
+        if (jobs.empty()) {
+            return;
+        } // stopping, and nothing left to run
+
+        Job job = std::move(jobs.front());
+        jobs.pop_front();
+        idle--;
+        lock.unlock();
+        job.run();
+        if (Profile::enabled()) {
+            Profile::flush();
+        } // the thread lives on : its counters are merged after every job
+
+        // idle again before the submitter learns the job is over, so that
+        // its next job does not start another worker
+        lock.lock();
+        idle++;
+        std::lock_guard<std::mutex> done(job.state->mutex);
+        job.state->done = true;
+        job.state->over.notify_all();
+    }
+}
@@ -1,40 +1,68 @@
 #include "position.h"
 
-Position::Position() {
-    row_ = -1;
-    col_ = -1;
+/**
+ * @brief The Geometry struct
+ *
+ * Relations between every two squares, index 64 (off the board) is related to
+ * nothing.
+ */
+struct Geometry {
+    static const int Orthogonal = 1; // same row or col
+    static const int Diagonal = 2;   // same diagonal
+
+    u_int8_t lines[65][65];      // Orthogonal | Diagonal
+    u_int8_t distances[65][65];  // king steps from one square to the other
+    bool knight_moves[65][65];   // a knight jump apart
+    u_int64_t between[65][65];   // squares strictly between two on a line
+};
+
+/**
+ * @brief computes the geometry tables (at compile time)
+ *
+ * @return Geometry - tables
+ */
+static constexpr Geometry build_geometry() {
+    Geometry g = {};
+    for (int a = 0; a < 64; a++) {
+        for (int b = 0; b < 64; b++) {
+            int rows = b / 8 - a / 8, cols = b % 8 - a % 8;
+            int abs_rows = rows < 0 ? -rows : rows;
+            int abs_cols = cols < 0 ? -cols : cols;
+
+            g.lines[a][b] =
+                (rows == 0 || cols == 0 ? Geometry::Orthogonal : 0) |
+                (abs_rows == abs_cols ? Geometry::Diagonal : 0);
+            g.distances[a][b] = u_int8_t(abs_rows > abs_cols ? abs_rows
+                                                             : abs_cols);
+            g.knight_moves[a][b] = (abs_rows == 2 && abs_cols == 1) ||
+                                   (abs_rows == 1 && abs_cols == 2);
+            if (g.lines[a][b] != 0 && a != b) {
+                int step = (rows > 0 ? 8 : rows < 0 ? -8 : 0) +
+                           (cols > 0 ? 1 : cols < 0 ? -1 : 0);
+                for (int s = a + step; s != b; s += step) {
+                    g.between[a][b] |= u_int64_t(1) << s;
+                }
+            }
+        }
+    }
+    return g;
 }
 
-Position::Position(int row, int col) {
-    this->row_ = row;
-    this->col_ = col;
-}
+static constexpr Geometry GEOMETRY = build_geometry();
+
+static_assert(sizeof(Position) == 1, "positions should be one byte");
 
-Position::Position(const std::string &position_string) {
-    if (position_string.size() != 2) {
-        row_ = -1;
-        col_ = -1;
-    } else {
-        row_ = position_string[1] - '1';
-        col_ = position_string[0] - 'a';
+Position::Position(const std::string &position_string) : Position() {
+    if (position_string.size() == 2) {
+        *this = Position(position_string[1] - '1', position_string[0] - 'a');
     }
 }
 
-Position::~Position() {}
-
 std::ostream &operator<<(std::ostream &os, const Position &position) {
-    os << (char)('a' + position.col_) << (position.row_ + 1);
+    os << (char)('a' + position.col()) << (position.row() + 1);
     return os;
 }
 
-bool Position::operator==(const Position &other) const {
-    return row_ == other.row_ && col_ == other.col_;
-}
-
-bool Position::operator!=(const Position &other) const {
-    return !(*this == other);
-}
-
 const Position Position::king_position(Color color) {
     switch (color) {
     case Color::White:
@@ -57,77 +85,55 @@ const Position Position::queen_position(Color color) {
     }
 }
 
-bool Position::is_off_board() const {
-    return row_ < 0 || row_ > 7 || col_ < 0 || col_ > 7;
-}
-
-bool Position::is_on_board() const { return !is_off_board(); }
-
-const int &Position::row() const { return row_; }
-
-const int &Position::col() const { return col_; }
-
-int &Position::row() { return row_; }
-
-int &Position::col() { return col_; }
-
-void Position::row(const int &row) { row_ = std::move(row); }
-
-void Position::col(const int &col) { col_ = std::move(col); }
-
 Position Position::add_row(int row) const {
-    return Position(this->row_ + row, this->col_);
+    return is_on_board() ? Position(this->row() + row, this->col())
+                         : Position();
 }
 
 Position Position::add_col(int col) const {
-    return Position(this->row_, this->col_ + col);
+    return is_on_board() ? Position(this->row(), this->col() + col)
+                         : Position();
 }
 
 bool Position::is_diagonal_to(const Position &other) const {
-    return abs(row_ - other.row_) == abs(col_ - other.col_);
+    return GEOMETRY.lines[square_][other.square_] & Geometry::Diagonal;
 }
 
 int Position::diagonal_distance(const Position &other) const {
-    return abs(row_ - other.row_);
+    return abs(this->row() - other.row());
 }
 
 bool Position::is_orthogonal_to(const Position &other) const {
-    return row_ == other.row_ || col_ == other.col_;
+    return GEOMETRY.lines[square_][other.square_] & Geometry::Orthogonal;
 }
 
 int Position::orthogonal_distance(const Position &other) const {
-    return abs(row_ - other.row_) + abs(col_ - other.col_);
+    return abs(this->row() - other.row()) + abs(this->col() - other.col());
 }
 
 bool Position::is_adjacent_to(const Position &other) const {
-    if (is_orthogonal_to(other)) {
-        return orthogonal_distance(other) == 1;
-    } else if (is_diagonal_to(other)) {
-        return diagonal_distance(other) == 1;
-    } else {
-        return false;
-    }
+    return GEOMETRY.distances[square_][other.square_] == 1;
 }
 
 bool Position::is_below(const Position &other) const {
-    return row_ < other.row_;
+    return this->row() < other.row();
 }
 
 bool Position::is_above(const Position &other) const {
-    return row_ > other.row_;
+    return this->row() > other.row();
 }
 
 bool Position::is_left_of(const Position &other) const {
-    return col_ < other.col_;
+    return this->col() < other.col();
 }
 
 bool Position::is_right_of(const Position &other) const {
-    return col_ > other.col_;
+    return this->col() > other.col();
 }
 
-Position Position::next_below() const { return Position(row_ - 1, col_); }
+Position Position::next_below() const { return add_row(-1); }
 
-Position Position::next_above() const { return Position(row_ + 1, col_); }
+Position Position::next_above() const { return add_row(1); }
 
 Position Position::pawn_up(Color ally_color) const {
     switch (ally_color) {
@@ -144,84 +150,33 @@ Position Position::pawn_back(Color ally_color) const {
     return pawn_up(!ally_color);
 }
 
-Position Position::next_left() const { return Position(row_, col_ - 1); }
+Position Position::next_left() const { return add_col(-1); }
 
-Position Position::next_right() const { return Position(row_, col_ + 1); }
+Position Position::next_right() const { return add_col(1); }
 
 bool Position::is_starting_pawn(Color color) const {
     switch (color) {
     case Color::White:
-        return row_ == 1;
+        return this->row() == 1;
     case Color::Black:
-        return row_ == 6;
+        return this->row() == 6;
     default:
         panic("Invalid color");
     }
 }
 
 bool Position::is_kingside_rook() const {
-    return (row_ == 0 || row_ == 7) && col_ == 7;
+    return *this == H1 || *this == H8;
 }
 
 bool Position::is_queenside_rook() const {
-    return (row_ == 0 || row_ == 7) && col_ == 0;
+    return *this == A1 || *this == A8;
 }
 
-std::vector<Position> Position::diagonals_to(const Position &to) const {
-    if (!is_diagonal_to(to)) {
-        return {};
-    }
-
-    int row_step, col_step;
-    if (is_left_of(to)) {
-        col_step = 1;
-    } else {
-        col_step = -1;
-    }
-
-    if (is_below(to)) {
-        row_step = 1;
-    } else {
-        row_step = -1;
-    }
-
-    Position acc = *this;
-    std::vector<Position> result;
-    for (int i = 0; i < diagonal_distance(to); i++) {
-        acc = acc.add_row(row_step).add_col(col_step);
-        result.push_back(acc);
-    }
-
-    return result;
-}
-
-std::vector<Position> Position::orthogonals_to(const Position &to) const {
-    if (!is_orthogonal_to(to)) {
-        return {};
-    }
-
-    int row_step = 0, col_step = 0;
-    if (is_left_of(to)) {
-        col_step = 1;
-    } else if (is_right_of(to)) {
-        col_step = -1;
-    } else if (is_above(to)) {
-        row_step = -1;
-    } else if (is_below(to)) {
-        row_step = 1;
-    }
-
-    Position acc = *this;
-    std::vector<Position> result;
-    for (int i = 0; i < orthogonal_distance(to); i++) {
-        acc = acc.add_row(row_step).add_col(col_step);
-        result.push_back(acc);
-    }
-
-    return result;
+u_int64_t Position::squares_between(const Position &to) const {
+    return GEOMETRY.between[square_][to.square_];
 }
 
 bool Position::is_knight_move(const Position &other) const {
-    return (abs(row_ - other.row_) == 2 && abs(col_ - other.col_) == 1) ||
-           (abs(row_ - other.row_) == 1 && abs(col_ - other.col_) == 2);
+    return GEOMETRY.knight_moves[square_][other.square_];
 }
@@ -0,0 +1,84 @@
+#include "profile.h"
+
+/**
+ * @brief The PhaseCounters struct
+ *
+ * Calls and cycles of every phase, merged into the totals when the owning
+ * thread ends.
+ */
+struct PhaseCounters {
+    u_int64_t calls[Profile::PHASES] = {};
+    u_int64_t cycles[Profile::PHASES] = {};
+
+    void merge();
+    ~PhaseCounters() { merge(); }
+};
+
+static std::atomic<bool> profiling(false);
+static std::mutex totals_mutex;
+static u_int64_t total_calls[Profile::PHASES] = {};
+static u_int64_t total_cycles[Profile::PHASES] = {};
+static thread_local PhaseCounters counters;
+
+void PhaseCounters::merge() {
+    std::lock_guard<std::mutex> lock(totals_mutex);
+    for (int phase = 0; phase < Profile::PHASES; phase++) {
+        total_calls[phase] += calls[phase];
+        total_cycles[phase] += cycles[phase];
+        calls[phase] = 0;
+        cycles[phase] = 0;
+    }
+}
+
+void Profile::enable(bool enabled) { profiling.store(enabled); }
+
+bool Profile::enabled() { return profiling.load(std::memory_order_relaxed); }
+
+bool Profile::available() {
+#ifdef PROFILE
+    return true;
+#else
+    return false;
+#endif
+}
+
+void Profile::add(int phase, u_int64_t cycles) {
+    counters.calls[phase]++;
+    counters.cycles[phase] += cycles;
+}
+
+void Profile::flush() { counters.merge(); }
+
+void Profile::report(std::ostream &os) {
+    std::lock_guard<std::mutex> lock(totals_mutex);
+    std::stringstream ss;
+    ss << "profile (inclusive cycles)\n";
+    for (int phase = 0; phase < PHASES; phase++) {
+        u_int64_t calls = total_calls[phase];
+        ss << "  " << name(phase) << ": " << calls << " calls, "
+           << total_cycles[phase] << " cycles";
+        if (calls > 0) {
+            ss << ", " << total_cycles[phase] / calls << " cycles/call";
+        }
+        ss << "\n";
+    }
+    os << ss.str();
+    os.flush();
+}
+
+const char *Profile::name(int phase) {
+    switch (phase) {
+    case MoveGen:
+        return "movegen";
+    case Legality:
+        return "legality";
+    case Apply:
+        return "apply";
+    case Sorting:
+        return "sorting";
+    case Eval:
+        return "eval";
+    default:
+        panic("Invalid profile phase");
+    }
+}
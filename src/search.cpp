@@ -0,0 +1,226 @@
+#include "search.h"
+
+#include "board.h"
+#include "split.h"
+
+// nodes between two polls of the stop flag
+static const u_int64_t POLL_INTERVAL = 128;
+
+/**
+ * @brief milliseconds on a clock that never goes back
+ *
+ * @return int64_t - ms
+ */
+static int64_t steady_ms() {
+    return std::chrono::duration_cast<std::chrono::milliseconds>(
+               std::chrono::steady_clock::now().time_since_epoch())
+        .count();
+}
+
+SearchLimits::SearchLimits(int depth) {
+    this->depth = depth;
+    this->nodes = 0;
+    this->movetime = 0;
+    this->multipv = 1;
+    this->threads = 1;
+}
+
+SearchLimits::~SearchLimits() {}
+
+SearchStats::SearchStats() {
+    this->nodes = 0;
+    this->qnodes = 0;
+    this->cutoffs = 0;
+    this->first_move_cutoffs = 0;
+    this->hash_probes = 0;
+    this->hash_hits = 0;
+    this->splits = 0;
+    this->tasks = 0;
+    this->steals = 0;
+    this->aborted = 0;
+}
+
+SearchStats::~SearchStats() {}
+
+u_int64_t SearchStats::total_nodes() const { return nodes + qnodes; }
+
+double SearchStats::branching_factor() const {
+    std::size_t n = iterations.size();
+    if (n == 0 || iterations[n - 1].nodes == 0) {
+        return 0.;
+    }
+    if (n == 1 || iterations[n - 2].nodes == 0) {
+        return std::pow(double(iterations[n - 1].nodes),
+                        1. / double(std::max(iterations[n - 1].plies, 1)));
+    }
+    return double(iterations[n - 1].nodes) / double(iterations[n - 2].nodes);
+}
+
+double SearchStats::first_move_cutoff_rate() const {
+    return cutoffs == 0 ? 0. : 100. * first_move_cutoffs / cutoffs;
+}
+
+double SearchStats::hash_hit_rate() const {
+    return hash_probes == 0 ? 0. : 100. * hash_hits / hash_probes;
+}
+
+double SearchStats::steal_rate() const {
+    return tasks == 0 ? 0. : 100. * steals / tasks;
+}
+
+void SearchStats::merge(const SearchStats &other) {
+    nodes += other.nodes;
+    qnodes += other.qnodes;
+    cutoffs += other.cutoffs;
+    first_move_cutoffs += other.first_move_cutoffs;
+    hash_probes += other.hash_probes;
+    hash_hits += other.hash_hits;
+    splits += other.splits;
+    tasks += other.tasks;
+    steals += other.steals;
+    aborted += other.aborted;
+}
+
+std::ostream &operator<<(std::ostream &os, const SearchStats &stats) {
+    std::stringstream ss;
+    ss << std::fixed;
+    ss.precision(1);
+    ss << "nodes: " << stats.nodes << " (quiescence: " << stats.qnodes
+       << ")\n";
+    ss << "branching factor: " << stats.branching_factor()
+       << ", first move cutoffs: " << stats.first_move_cutoff_rate()
+       << "%, hash hits: " << stats.hash_hit_rate() << "%\n";
+    if (stats.splits > 0) {
+        ss << "splits: " << stats.splits << ", younger brothers: "
+           << stats.tasks << " (stolen: " << stats.steal_rate()
+           << "%, cancelled: " << stats.aborted << ")\n";
+    }
+    for (const IterationStats &iteration : stats.iterations) {
+        ss << "depth " << iteration.plies << ": " << iteration.nodes
+           << " nodes, " << iteration.ms << " ms\n";
+    }
+    return os << ss.str();
+}
+
+SearchContext::SearchContext(const History &history, TranspositionTable *tt,
+                             const std::atomic<bool> *stop)
+    : history(history) {
+    this->depth = -1;
+    this->tt = tt;
+    this->stop = stop;
+    this->stopped = false;
+    this->split = nullptr;
+    this->parent = nullptr;
+    this->worker = 0;
+    this->reported = 0;
+    this->max_nodes = 0;
+    this->deadline = 0;
+}
+
+SearchContext::SearchContext(const SplitPoint *parent, unsigned worker)
+    : history(&parent->owner->history) {
+    this->depth = -1;
+    this->tt = parent->owner->tt;
+    this->stop = parent->owner->stop;
+    this->stopped = false;
+    this->split = parent->owner->split;
+    this->parent = parent;
+    this->worker = worker;
+    this->reported = 0;
+    this->max_nodes = parent->owner->max_nodes; // against the shared count
+    this->deadline = parent->owner->deadline;
+    should_stop(); // brothers are often smaller than a poll interval
+}
+
+SearchContext::~SearchContext() {}
+
+bool SearchContext::should_stop() {
+    u_int64_t nodes = stats.total_nodes();
+    if (!stopped && nodes % POLL_INTERVAL == 0) {
+        if (split != nullptr) {
+            u_int64_t own = nodes;
+            nodes = split->spend(own - reported);
+            reported = own;
+        } // the budget covers the nodes of every thread
+        stopped = (stop != nullptr && stop->load(std::memory_order_relaxed)) ||
+                  (max_nodes != 0 && nodes >= max_nodes) ||
+                  (deadline != 0 && steady_ms() >= deadline) ||
+                  (parent != nullptr && parent->cancelled());
+    }
+    return stopped;
+}
+
+void SearchContext::limit(const SearchLimits &limits) {
+    max_nodes = limits.nodes;
+    deadline = limits.movetime > 0 ? steady_ms() + limits.movetime : 0;
+    root_moves = limits.moves;
+}
+
+bool SearchContext::can_stop() const {
+    return stop != nullptr || max_nodes != 0 || deadline != 0;
+}
+
+SearchThread::SearchThread(TranspositionTable *tt) : abort(false), done(false) {
+    this->tt = tt;
+    this->reached = -1;
+}
+
+SearchThread::~SearchThread() {
+    stop();
+    task.wait();
+}
+
+void SearchThread::start(const Board &board, const History &history,
+                         int depth, bool best) {
+    start(board, history, SearchLimits(depth), best);
+}
+
+void SearchThread::start(const Board &board, const History &history,
+                         const SearchLimits &limits, bool best) {
+    task.wait();
+    abort.store(false);
+    done.store(false);
+
+    Board position = board; // searched on its own copy
+    task = ThreadPool::global().submit([this, position, history, limits,
+                                        best]() mutable {
+        SearchContext context = SearchContext(history, tt, &abort);
+        context.limit(limits);
+        std::unique_ptr<SplitSearch> split;
+        if (limits.threads > 1) {
+            split = std::make_unique<SplitSearch>(limits.threads);
+            split->attach(context);
+        } // helpers wait for split points until the search returns
+        if (best && limits.multipv > 1) {
+            std::vector<PvLine> lines =
+                position.get_best_moves(limits.depth, limits.multipv, context);
+            outcome = std::make_tuple(lines.front().move,
+                                      context.stats.total_nodes(),
+                                      lines.front().value);
+        } else if (best) {
+            outcome = position.get_next_best_move(limits.depth, context);
+        } else {
+            outcome = position.get_next_worst_move(limits.depth, context);
+        }
+        statistics = context.stats;
+        reached = context.depth;
+        done.store(true);
+    });
+}
+
+void SearchThread::stop() { abort.store(true); }
+
+std::tuple<Move, u_int64_t, double> SearchThread::wait() {
+    task.wait();
+    return outcome;
+}
+
+bool SearchThread::is_running() const { return task.valid(); }
+
+bool SearchThread::is_done() const { return done.load(); }
+
+const SearchStats &SearchThread::stats() const { return statistics; }
+
+int SearchThread::depth() const { return reached; }
+
+std::atomic<bool> *SearchThread::stop_flag() { return &abort; }
@@ -0,0 +1,258 @@
+#include "split.h"
+
+// longest sleep of a helper that found nothing to steal
+static const std::chrono::microseconds IDLE_WAIT(1000);
+// longest sleep of a worker waiting for its split point between two steals
+static const std::chrono::microseconds SPLIT_WAIT(100);
+
+SplitPoint::SplitPoint() : parent(nullptr), pending(0), cutoff(false) {
+    this->depth = 0;
+    this->is_maximizing = true;
+    this->getting_move_for = Color::White;
+    this->owner = nullptr;
+    this->worker = 0;
+    this->alpha = 0.;
+    this->beta = 0.;
+    this->best_value = 0.;
+    this->interrupted = false;
+    this->count = 0;
+    for (SplitTask &task : tasks) {
+        task.split = this;
+    }
+}
+
+SplitPoint::~SplitPoint() {}
+
+void SplitPoint::reset(const Board &board, int depth, double alpha,
+                       double beta, bool is_maximizing,
+                       Color getting_move_for, const SearchContext *owner) {
+    this->board = board;
+    this->depth = depth;
+    this->is_maximizing = is_maximizing;
+    this->getting_move_for = getting_move_for;
+    this->owner = owner;
+    this->worker = owner->worker;
+    this->alpha = alpha;
+    this->beta = beta;
+    this->best_value = is_maximizing ? -999999. : 999999.;
+    this->best_move = Move();
+    this->interrupted = false;
+    this->stats = SearchStats();
+    this->count = 0;
+    this->pending.store(0);
+    this->cutoff.store(false);
+    this->parent.store(owner->parent);
+}
+
+bool SplitPoint::cancelled() const {
+    for (const SplitPoint *sp = this; sp != nullptr;
+         sp = sp->parent.load(std::memory_order_relaxed)) {
+        if (sp->cutoff.load(std::memory_order_relaxed)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+bool SplitPoint::descends_from(const SplitPoint *ancestor) const {
+    for (const SplitPoint *sp = this; sp != nullptr;
+         sp = sp->parent.load(std::memory_order_relaxed)) {
+        if (sp == ancestor) {
+            return true;
+        }
+    }
+    return false;
+}
+
+SplitSearch::SplitSearch(unsigned threads)
+    : finished(false), sleeping(0), spent(0) {
+    threads = std::max(threads, 1u);
+    for (unsigned i = 0; i < threads; i++) {
+        workers.push_back(std::make_unique<Worker>());
+    }
+    for (unsigned i = 1; i < threads; i++) {
+        helpers.push_back(
+            ThreadPool::global().submit([this, i]() { help(i); }));
+    }
+}
+
+SplitSearch::~SplitSearch() {
+    finished.store(true);
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        work.notify_all();
+    }
+    for (ThreadPool::Task &helper : helpers) {
+        helper.wait();
+    }
+}
+
+void SplitSearch::attach(SearchContext &context) {
+    context.split = this;
+    context.parent = nullptr;
+    context.worker = 0;
+}
+
+unsigned SplitSearch::threads() const { return unsigned(workers.size()); }
+
+u_int64_t SplitSearch::spend(u_int64_t nodes) {
+    return spent.fetch_add(nodes, std::memory_order_relaxed) + nodes;
+}
+
+bool SplitSearch::split(const Board &board, const std::vector<Move> &moves,
+                        const std::vector<int> &order, int depth,
+                        double &alpha, double &beta, bool is_maximizing,
+                        Color getting_move_for, double &best_value,
+                        Move &best_move, SearchContext *context) {
+    unsigned worker = context->worker;
+    Worker &self = *workers[worker];
+    if (self.used == MAX_SPLITS || moves.size() < 2 ||
+        moves.size() - 1 > SplitPoint::MAX_MOVES) {
+        return false;
+    }
+    SplitPoint &sp = self.points[self.used++];
+    sp.reset(board, depth, alpha, beta, is_maximizing, getting_move_for,
+             context);
+    for (std::size_t i = 1; i < moves.size(); i++) {
+        sp.tasks[sp.count].move = moves[i];
+        sp.tasks[sp.count++].losing = order[i] < 0;
+    }
+    sp.pending.store(unsigned(sp.count));
+    context->stats.splits++;
+    context->stats.tasks += sp.count;
+
+    // the first moves at the bottom : this thread goes through them in
+    // order, as it would alone, while thieves take the last ones
+    for (std::size_t i = sp.count; i-- > 0;) {
+        if (!self.deque.push(&sp.tasks[i])) {
+            run(&sp.tasks[i], worker);
+        } // deque full : searched at once
+    }
+    if (sleeping.load() > 0) {
+        std::lock_guard<std::mutex> lock(mutex);
+        work.notify_all();
+    }
+
+    // the brothers left on the deque, then help the threads that took the
+    // others (only below this node), until every brother is done
+    bool own = true;
+    SplitTask *task;
+    while (sp.pending.load(std::memory_order_acquire) > 0) {
+        if (own && self.deque.pop(task)) {
+            if (task->split == &sp) {
+                run(task, worker);
+                continue;
+            }
+            self.deque.push(task);
+        } // a task of an outer split point : left for the thieves
+        own = false;
+
+        if (steal(worker, &sp, task)) {
+            run(task, worker);
+            continue;
+        }
+        std::unique_lock<std::mutex> lock(sp.mutex);
+        sp.over.wait_for(lock, SPLIT_WAIT,
+                         [&sp]() { return sp.pending.load() == 0; });
+    }
+
+    std::lock_guard<std::mutex> lock(sp.mutex);
+    context->stats.merge(sp.stats);
+    context->reported += sp.stats.total_nodes(); // counted by the brothers
+    if (sp.interrupted) {
+        context->stopped = true;
+    } // a brother was stopped from outside : the node is not searched
+    if (is_maximizing ? sp.best_value > best_value
+                      : sp.best_value < best_value) {
+        best_value = sp.best_value;
+        best_move = sp.best_move;
+    }
+    alpha = sp.alpha;
+    beta = sp.beta;
+    sp.parent.store(nullptr); // no chain through a finished split point
+    self.used--;
+    return true;
+}
+
+void SplitSearch::run(SplitTask *task, unsigned worker) {
+    SplitPoint &sp = *task->split;
+    SearchContext context = SearchContext(&sp, worker);
+    if (worker != sp.worker) {
+        context.stats.steals++;
+    }
+
+    double value = 0.;
+    if (!context.stopped) {
+        double alpha, beta;
+        {
+            std::lock_guard<std::mutex> lock(sp.mutex);
+            alpha = sp.alpha;
+            beta = sp.beta;
+        } // the window narrowed by the brothers done so far
+        Board node = sp.board;
+        value = node.search_move(task->move, sp.depth, alpha, beta,
+                                 sp.is_maximizing, sp.getting_move_for,
+                                 &context, task->losing);
+    }
+
+    spend(context.stats.total_nodes() - context.reported);
+
+    std::lock_guard<std::mutex> lock(sp.mutex);
+    if (context.stopped) {
+        if (sp.cutoff.load()) {
+            context.stats.aborted++;
+        } else {
+            sp.interrupted = true;
+        } // stopped by the stop flag, the deadline or an outer cutoff
+    } else if (sp.is_maximizing) {
+        if (value > sp.best_value) {
+            sp.best_value = value;
+            sp.best_move = task->move;
+        }
+        sp.alpha = std::max(sp.alpha, sp.best_value);
+    } else {
+        if (value < sp.best_value) {
+            sp.best_value = value;
+            sp.best_move = task->move;
+        }
+        sp.beta = std::min(sp.beta, sp.best_value);
+    }
+    if (sp.beta <= sp.alpha) {
+        sp.cutoff.store(true);
+    } // the brothers still searching give up at their next poll
+    sp.stats.merge(context.stats);
+    if (sp.pending.fetch_sub(1) == 1) {
+        sp.over.notify_all();
+    }
+}
+
+bool SplitSearch::steal(unsigned worker, const SplitPoint *below,
+                        SplitTask *&task) {
+    unsigned n = unsigned(workers.size());
+    for (unsigned i = 1; i < n; i++) {
+        unsigned victim = (worker + i) % n;
+        if (workers[victim]->deque.steal(task, [below](SplitTask *t) {
+                return below == nullptr || t->split->descends_from(below);
+            })) {
+            return true;
+        }
+    }
+    return false;
+}
+
+void SplitSearch::help(unsigned worker) {
+    SplitTask *task;
+    while (!finished.load()) {
+        if (steal(worker, nullptr, task)) {
+            run(task, worker);
+            continue;
+        }
+        std::unique_lock<std::mutex> lock(mutex);
+        if (finished.load()) {
+            break;
+        }
+        sleeping++;
+        work.wait_for(lock, IDLE_WAIT);
+        sleeping--;
+    }
+}
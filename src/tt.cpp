@@ -0,0 +1,319 @@
+#include "tt.h"
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include "board.h"
+
+// first bytes of every hash file
+static const char FILE_MAGIC[8] = "chesstt";
+// slots copied per write when saving
+static const std::size_t SAVE_CHUNK = 4096;
+
+// data layout : move (16 bits) | depth (8 bits) | bound (8 bits) | value (32)
+static u_int64_t pack_entry(const Move &move, double value, int depth,
+                            int bound) {
+    int32_t v = int32_t(std::lround(value));
+    return (u_int64_t(move.pack()) << 48) |
+           (u_int64_t(std::clamp(depth, 0, 255)) << 40) |
+           (u_int64_t(bound & 0xff) << 32) | u_int64_t(u_int32_t(v));
+}
+
+static HashEntry unpack_entry(u_int64_t data) {
+    HashEntry entry;
+    entry.move = Move::unpack(u_int16_t(data >> 48));
+    entry.depth = int((data >> 40) & 0xff);
+    entry.bound = int((data >> 32) & 0xff);
+    entry.value = double(int32_t(u_int32_t(data & 0xffffffff)));
+    return entry;
+}
+
+/**
+ * @brief reads a word of a slot, other threads may be writing it
+ *
+ * @param word word
+ * @return u_int64_t - value
+ */
+static u_int64_t load_word(const u_int64_t &word) {
+    return std::atomic_ref<u_int64_t>(const_cast<u_int64_t &>(word))
+        .load(std::memory_order_relaxed);
+}
+
+/**
+ * @brief writes a word of a slot, other threads may be reading it
+ *
+ * @param word word
+ * @param value value
+ */
+static void store_word(u_int64_t &word, u_int64_t value) {
+    std::atomic_ref<u_int64_t>(word).store(value, std::memory_order_relaxed);
+}
+
+TranspositionTable::TranspositionTable(std::size_t megabytes) {
+    slots = nullptr;
+    mask = 0;
+    mode = LargeMemory::Heap;
+    touch = false;
+    resize(megabytes);
+}
+
+TranspositionTable::~TranspositionTable() {
+    LargeMemory::release(slots, (mask + 1) * sizeof(Slot), mode);
+}
+
+void TranspositionTable::resize(std::size_t megabytes) {
+    std::size_t count = 1;
+    std::size_t wanted = std::max<std::size_t>(megabytes, 1) * 1024 * 1024 /
+                         sizeof(Slot);
+    while (count * 2 <= wanted) {
+        count *= 2;
+    }
+
+    // zeroed memory is a table of empty slots, pages are faulted on use
+    LargeMemory::release(slots, (mask + 1) * sizeof(Slot), mode);
+    slots = static_cast<Slot *>(
+        LargeMemory::allocate(count * sizeof(Slot), mode));
+    mask = count - 1;
+    if (touch) {
+        prefault(true);
+    }
+}
+
+void TranspositionTable::clear() {
+    for (std::size_t i = 0; i <= mask; i++) {
+        store_word(slots[i].check, 0);
+        store_word(slots[i].data, 0);
+    }
+}
+
+std::size_t TranspositionTable::size() const { return mask + 1; }
+
+const char *TranspositionTable::memory() const {
+    return LargeMemory::name(mode);
+}
+
+void TranspositionTable::prefault(bool always) {
+    touch = touch || always;
+    LargeMemory::prefault(slots, (mask + 1) * sizeof(Slot));
+}
+
+bool TranspositionTable::probe(u_int64_t key, HashEntry &entry) const {
+    const Slot &slot = slots[key & mask];
+    u_int64_t data = load_word(slot.data);
+    u_int64_t check = load_word(slot.check);
+    if ((check ^ data) != key || data == 0) {
+        return false;
+    }
+    entry = unpack_entry(data);
+    return true;
+}
+
+void TranspositionTable::store(u_int64_t key, const Move &move, double value,
+                               int depth, int bound) {
+    Slot &slot = slots[key & mask];
+    u_int64_t old_data = load_word(slot.data);
+    u_int64_t old_check = load_word(slot.check);
+
+    // keep deeper results for the same position unless the new one is exact
+    if ((old_check ^ old_data) == key && old_data != 0 && bound != Exact &&
+        int((old_data >> 40) & 0xff) > depth) {
+        return;
+    }
+
+    u_int64_t data = pack_entry(move, value, depth, bound);
+    store_word(slot.data, data);
+    store_word(slot.check, key ^ data);
+}
+
+/**
+ * @brief folds words into a checksum (FNV-1a, a word at a time)
+ *
+ * @param checksum running checksum
+ * @param word next word
+ * @return u_int64_t - new checksum
+ */
+static u_int64_t fold(u_int64_t checksum, u_int64_t word) {
+    return (checksum ^ word) * 0x100000001B3ULL;
+}
+
+// the checksum of no word at all
+static const u_int64_t CHECKSUM_BASIS = 0xCBF29CE484222325ULL;
+
+/**
+ * @brief writes a whole buffer, retrying short writes
+ *
+ * @param fd file descriptor
+ * @param data buffer
+ * @param length number of bytes
+ * @return true - if everything was written
+ * @return false - otherwise (errno is set)
+ */
+static bool write_all(int fd, const void *data, std::size_t length) {
+    const char *bytes = static_cast<const char *>(data);
+    while (length > 0) {
+        ssize_t written = write(fd, bytes, length);
+        if (written < 0 && errno == EINTR) {
+            continue;
+        }
+        if (written <= 0) {
+            return false;
+        }
+        bytes += written;
+        length -= std::size_t(written);
+    }
+    return true;
+}
+
+/**
+ * @brief syncs the directory of a file, so that a rename into it survives a
+ * crash
+ *
+ * @param path path of the file
+ * @return true - if synced
+ * @return false - otherwise (errno is set)
+ */
+static bool sync_directory(const std::string &path) {
+    std::size_t slash = path.rfind('/');
+    std::string directory = slash == std::string::npos ? "."
+                            : slash == 0              ? "/"
+                                                      : path.substr(0, slash);
+    int fd = open(directory.c_str(), O_RDONLY | O_DIRECTORY);
+    if (fd == -1) {
+        return false;
+    }
+    bool ok = fsync(fd) == 0;
+    int error = errno;
+    close(fd);
+    errno = error;
+    return ok;
+}
+
+std::size_t TranspositionTable::save(const std::string &path) const {
+    FileHeader header = {};
+    std::memcpy(header.magic, FILE_MAGIC, sizeof(header.magic));
+    header.version = FileVersion;
+    header.word_size = sizeof(u_int64_t);
+    header.zobrist = Board::new_board().get_key();
+    header.count = mask + 1;
+    header.checksum = CHECKSUM_BASIS;
+
+    // written beside the file, then renamed over it
+    std::string temporary = path + ".tmp";
+    int fd = open(temporary.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (fd == -1) {
+        throw std::runtime_error("Could not create " + temporary + ": " +
+                                 std::strerror(errno));
+    }
+
+    // the header goes first once the checksum is known, searches may still
+    // be writing : every slot is read once, torn ones are saved empty
+    std::vector<u_int64_t> words;
+    words.reserve(2 * SAVE_CHUNK);
+    std::size_t entries = 0;
+    bool ok = lseek(fd, off_t(sizeof(header)), SEEK_SET) != -1;
+    for (std::size_t i = 0; ok && i <= mask; i++) {
+        u_int64_t data = load_word(slots[i].data);
+        u_int64_t check = load_word(slots[i].check);
+        if (data == 0 || ((check ^ data) & mask) != i) {
+            data = check = 0;
+        }
+        words.push_back(check);
+        words.push_back(data);
+        header.checksum = fold(fold(header.checksum, check), data);
+        entries += data != 0;
+        if (words.size() == 2 * SAVE_CHUNK || i == mask) {
+            ok = write_all(fd, words.data(), words.size() * sizeof(u_int64_t));
+            words.clear();
+        }
+    }
+    ok = ok && lseek(fd, 0, SEEK_SET) != -1 &&
+         write_all(fd, &header, sizeof(header)) && fsync(fd) == 0;
+    int error = errno;
+    ok = close(fd) == 0 && ok;
+    if (ok && rename(temporary.c_str(), path.c_str()) == 0) {
+        if (sync_directory(path)) {
+            return entries;
+        }
+        throw std::runtime_error("Could not sync the directory of " + path +
+                                 ": " + std::strerror(errno));
+    } // renamed : the temporary file is gone
+    error = ok ? errno : error;
+    unlink(temporary.c_str());
+    throw std::runtime_error("Could not write " + path + ": " +
+                             std::strerror(error));
+}
+
+std::size_t TranspositionTable::load(const std::string &path) {
+    int fd = open(path.c_str(), O_RDONLY);
+    if (fd == -1) {
+        throw std::runtime_error("Could not open " + path + ": " +
+                                 std::strerror(errno));
+    }
+    struct stat st;
+    chk(fstat(fd, &st));
+    std::size_t length = std::size_t(st.st_size);
+    if (length < sizeof(FileHeader)) {
+        chk(close(fd));
+        throw std::invalid_argument(path + " is not a hash file");
+    }
+    void *mapped = mmap(nullptr, length, PROT_READ, MAP_PRIVATE, fd, 0);
+    chk(close(fd));
+    if (mapped == MAP_FAILED) {
+        throw std::runtime_error("Could not map " + path);
+    }
+    madvise(mapped, length, MADV_SEQUENTIAL); // read once, front to back
+
+    FileHeader header;
+    std::memcpy(&header, mapped, sizeof(header));
+    const u_int64_t *words = reinterpret_cast<const u_int64_t *>(
+        static_cast<const char *>(mapped) + sizeof(header));
+    std::size_t count = std::size_t(header.count);
+
+    std::string error;
+    if (std::memcmp(header.magic, FILE_MAGIC, sizeof(header.magic)) != 0) {
+        error = " is not a hash file";
+    } else if (header.version != FileVersion ||
+               header.word_size != sizeof(u_int64_t)) {
+        error = " is a hash file of another version";
+    } else if (header.zobrist != Board::new_board().get_key()) {
+        error = " was hashed with other zobrist keys";
+    } else if (count == 0 || (count & (count - 1)) != 0 ||
+               (length - sizeof(header)) / (2 * sizeof(u_int64_t)) != count ||
+               (length - sizeof(header)) % (2 * sizeof(u_int64_t)) != 0) {
+        error = " is truncated";
+    } else {
+        u_int64_t checksum = CHECKSUM_BASIS;
+        for (std::size_t i = 0; i < 2 * count; i++) {
+            checksum = fold(checksum, words[i]);
+        }
+        if (checksum != header.checksum) {
+            error = " is corrupted (checksum mismatch)";
+        }
+    }
+    if (!error.empty()) {
+        munmap(mapped, length);
+        throw std::invalid_argument(path + error);
+    }
+
+    // entries are placed by their own keys, the table may be of another size
+    std::size_t entries = 0;
+    for (std::size_t i = 0; i < count; i++) {
+        u_int64_t check = words[2 * i], data = words[2 * i + 1];
+        u_int64_t key = check ^ data;
+        if (data == 0 || (key & (count - 1)) != i) {
+            continue;
+        }
+        Slot &slot = slots[key & mask];
+        u_int64_t old_data = load_word(slot.data);
+        if (old_data != 0 &&
+            ((old_data >> 40) & 0xff) > ((data >> 40) & 0xff)) {
+            continue;
+        } // the deeper result is kept
+        store_word(slot.data, data);
+        store_word(slot.check, check);
+        entries++;
+    }
+    munmap(mapped, length);
+    return entries;
+}
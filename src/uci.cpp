@@ -0,0 +1,387 @@
+#include "uci.h"
+
+// depth of searches limited only by time, nodes or `stop`
+static const int MAX_DEPTH = 63;
+// moves left to play when the clock gives no `movestogo`
+static const int64_t MOVES_TO_GO = 30;
+// maximum number of search threads
+static const int MAX_THREADS = 256;
+// maximum number of best moves given a score
+static const int MAX_MULTIPV = 64;
+
+Uci::Uci(TranspositionTable *tt, const std::string &hash_file) : search(tt) {
+    this->tt = tt;
+    this->hash_file = hash_file;
+    this->multipv = 1;
+    this->ybwc = false;
+    this->held = false;
+    this->board = Board::new_board();
+}
+
+Uci::~Uci() {
+    stop();
+    for (SearchThread *helper : helpers) {
+        delete helper;
+    }
+}
+
+int Uci::run() {
+    std::string line;
+    while (std::getline(std::cin, line)) {
+        if (!execute(line)) {
+            break;
+        }
+    }
+    stop();
+    return EXIT_SUCCESS;
+}
+
+bool Uci::execute(const std::string &line) {
+    std::istringstream args(line);
+    std::string command;
+    args >> command;
+
+    if (command == "uci") {
+        std::stringstream ss;
+        ss << "id name chess-cli " << __VERSION_MAJOR__ << "."
+           << __VERSION_MINOR__ << "." << __VERSION_PATCH__ << "\n";
+        ss << "id author " << __AUTHOR__ << "\n";
+        ss << "option name Hash type spin default 16 min 1 max 65536\n";
+        ss << "option name Threads type spin default 1 min 1 max "
+           << MAX_THREADS << "\n";
+        ss << "option name MultiPV type spin default 1 min 1 max "
+           << MAX_MULTIPV << "\n";
+        ss << "option name SMP type combo default SharedHash var SharedHash "
+              "var YBWC\n";
+        ss << "uciok";
+        send(ss.str());
+    } else if (command == "isready") {
+        send("readyok");
+    } else if (command == "ucinewgame") {
+        stop();
+        tt->clear();
+    } else if (command == "position") {
+        stop();
+        set_position(args);
+    } else if (command == "go") {
+        stop();
+        go(args);
+    } else if (command == "stop") {
+        stop();
+    } else if (command == "ponderhit") {
+        release(); // the search goes on, its bestmove is no longer held
+    } else if (command == "setoption") {
+        stop();
+        set_option(args);
+    } else if (command == "savehash") {
+        save_hash(); // a running search keeps going
+    } else if (command == "quit") {
+        return false;
+    } else if (!command.empty()) {
+        send("info string unknown command " + command);
+    }
+    return true;
+}
+
+const Board &Uci::position() const { return board; }
+
+std::string Uci::move_to_string(Board &board, const Move &move) {
+    std::stringstream ss;
+    std::string row = board.get_turn_color() == Color::White ? "1" : "8";
+    Piece *piece;
+
+    switch (move.move_type()) {
+    case Move::PieceMove:
+        ss << move.from() << move.to();
+        piece = board.get_piece(move.from());
+        if (piece != nullptr && piece->get_type() == Piece::Pawn &&
+            (move.to().row() == 0 || move.to().row() == 7)) {
+            ss << "q";
+        } // the cpu always promotes to a queen
+        break;
+    case Move::KingSideCastle:
+        ss << "e" << row << "g" << row;
+        break;
+    case Move::QueenSideCastle:
+        ss << "e" << row << "c" << row;
+        break;
+    default:
+        ss << "0000";
+        break;
+    }
+    return ss.str();
+}
+
+std::string Uci::pv_to_string(Board board, const std::vector<Move> &moves) {
+    std::string result;
+    for (const Move &m : moves) {
+        if (!result.empty()) {
+            result += ' ';
+        }
+        result += move_to_string(board, m);
+        board = board.apply_eval_move(m, true);
+    }
+    return result;
+}
+
+void Uci::set_position(std::istringstream &args) {
+    std::string token, fen;
+    Board next;
+    args >> token;
+    if (token == "startpos") {
+        next = Board::new_board();
+        args >> token;
+    } else if (token == "fen") {
+        while (args >> token && token != "moves") {
+            if (!fen.empty()) {
+                fen += ' ';
+            }
+            fen += token;
+        }
+        try {
+            next = Board::from_fen(fen);
+        } catch (std::invalid_argument &e) {
+            send(std::string("info string ") + e.what());
+            return;
+        }
+    } else {
+        send("info string expected startpos or fen");
+        return;
+    }
+
+    // the moves are played on a copy : a bad one leaves the position alone
+    History next_keys;
+    if (token == "moves") {
+        while (args >> token) {
+            Move move;
+            int promotion;
+            int result = Notation::parse(next, token, move, &promotion);
+            if (result != Notation::Ok) {
+                send(std::string("info string ") + Notation::error(result) +
+                     " " + token);
+                return;
+            }
+            next_keys.push(next.get_key());
+            next = next.apply_promotion(move, promotion);
+        }
+    }
+    board = next;
+    keys = next_keys;
+}
+
+/**
+ * @brief reads a number of milliseconds, nodes or plies
+ *
+ * @param token token
+ * @param value set to the number
+ * @return true - if the whole token is a number
+ * @return false - otherwise
+ */
+static bool read_number(const std::string &token, int64_t &value) {
+    std::istringstream ss(token);
+    return (ss >> value) && ss.eof();
+}
+
+void Uci::go(std::istringstream &args) {
+    SearchLimits limits = SearchLimits(MAX_DEPTH);
+    int64_t time_left = 0, increment = 0, moves_to_go = 0;
+    bool white = board.get_turn_color() == Color::White;
+    bool infinite = false, ponder = false;
+
+    std::vector<std::string> tokens;
+    std::string token;
+    while (args >> token) {
+        tokens.push_back(token);
+    }
+    for (std::size_t i = 0; i < tokens.size(); i++) {
+        const std::string &name = tokens[i];
+        if (name == "infinite") {
+            infinite = true;
+            continue;
+        }
+        if (name == "ponder") {
+            ponder = true;
+            continue;
+        }
+        if (name == "searchmoves") {
+            Move move;
+            while (i + 1 < tokens.size() &&
+                   Notation::parse(board, tokens[i + 1], move) ==
+                       Notation::Ok) {
+                limits.moves.push_back(move);
+                i++;
+            } // up to the next argument (never a legal move)
+            continue;
+        }
+        if (name != "depth" && name != "nodes" && name != "movetime" &&
+            name != "wtime" && name != "btime" && name != "winc" &&
+            name != "binc" && name != "movestogo" && name != "mate") {
+            send("info string unknown go argument " + name);
+            continue;
+        }
+
+        int64_t value;
+        if (i + 1 == tokens.size() || !read_number(tokens[i + 1], value)) {
+            send("info string expected a number after " + name);
+            continue;
+        }
+        i++;
+        if (name == "depth") {
+            limits.depth = std::max(int(value) - 1, 0);
+        } else if (name == "nodes") {
+            limits.nodes = u_int64_t(std::max(value, int64_t(1)));
+        } else if (name == "movetime") {
+            limits.movetime = std::max(value, int64_t(1));
+        } else if (name == (white ? "wtime" : "btime")) {
+            time_left = value;
+        } else if (name == (white ? "winc" : "binc")) {
+            increment = value;
+        } else if (name == "movestogo") {
+            moves_to_go = value;
+        } // `mate` is read but not searched for
+    }
+
+    // spend an even share of the clock, never more than half of it
+    if (!infinite && limits.movetime == 0 && time_left > 0) {
+        int64_t share = moves_to_go > 0 ? moves_to_go : MOVES_TO_GO;
+        limits.movetime = std::min(time_left / share + increment / 2,
+                                   time_left / 2);
+        limits.movetime = std::max(limits.movetime, int64_t(1));
+    }
+
+    limits.multipv = multipv;
+    if (ybwc) {
+        limits.threads = unsigned(helpers.size()) + 1;
+    } // the helpers are left idle, the main search splits its nodes
+
+    {
+        std::lock_guard<std::mutex> lock(hold);
+        held = infinite || ponder;
+    } // the gui may not get a bestmove before it says so
+    start = std::chrono::steady_clock::now();
+    search.start(board, keys, limits);
+    for (SearchThread *helper : helpers) {
+        if (!ybwc) {
+            helper->start(board, keys, limits);
+        }
+    }
+    reporter = ThreadPool::global().submit([this]() { report(); });
+}
+
+void Uci::set_option(std::istringstream &args) {
+    std::string token, name, value;
+    args >> token; // name
+    while (args >> token && token != "value") {
+        name += name.empty() ? token : " " + token;
+    }
+    args >> value;
+    name = to_lower(name);
+
+    int number = std::atoi(value.c_str());
+    if (name == "hash" && number > 0) {
+        tt->resize(std::size_t(number));
+        send("info string hash " + std::to_string(tt->size()) +
+             " entries on " + tt->memory());
+    } else if (name == "threads" && number > 0 && number <= MAX_THREADS) {
+        while (int(helpers.size()) + 1 < number) {
+            helpers.push_back(new SearchThread(tt));
+        }
+        while (int(helpers.size()) + 1 > number) {
+            delete helpers.back();
+            helpers.pop_back();
+        }
+    } else if (name == "multipv" && number > 0 && number <= MAX_MULTIPV) {
+        multipv = unsigned(number);
+    } else if (name == "smp" && (value == "SharedHash" || value == "YBWC")) {
+        ybwc = value == "YBWC";
+    } else {
+        send("info string unsupported option " + name + " " + value);
+    }
+}
+
+void Uci::save_hash() {
+    if (hash_file.empty()) {
+        send("info string no hash file (see --hash-file)");
+        return;
+    }
+    try {
+        std::size_t entries = tt->save(hash_file);
+        send("info string saved " + std::to_string(entries) + " entries to " +
+             hash_file);
+    } catch (std::exception &e) {
+        send(std::string("info string ") + e.what());
+    }
+}
+
+void Uci::stop() {
+    if (!reporter.valid()) {
+        return;
+    }
+    search.stop();
+    release();
+    reporter.wait();
+}
+
+void Uci::release() {
+    std::lock_guard<std::mutex> lock(hold);
+    held = false;
+    released.notify_all();
+}
+
+void Uci::report() {
+    std::tuple<Move, u_int64_t, double> r = search.wait();
+    SearchStats stats = search.stats();
+    for (SearchThread *helper : helpers) {
+        if (!ybwc) {
+            helper->stop();
+            helper->wait();
+            stats.merge(helper->stats());
+        }
+    }
+    u_int64_t nodes = stats.total_nodes();
+
+    int64_t ms = std::chrono::duration_cast<std::chrono::milliseconds>(
+                     std::chrono::steady_clock::now() - start)
+                     .count();
+    std::string move = move_to_string(board, std::get<0>(r));
+
+    std::stringstream ss;
+    ss << std::fixed;
+    ss.precision(1);
+    u_int64_t nps = nodes * 1000 / u_int64_t(std::max(ms, int64_t(1)));
+    if (stats.lines.size() > 1) {
+        for (std::size_t i = 0; i < stats.lines.size(); i++) {
+            const PvLine &line = stats.lines[i];
+            ss << "info depth " << search.depth() + 1 << " multipv " << i + 1
+               << " score cp " << std::lround(line.value) << " nodes "
+               << nodes << " time " << ms << " nps " << nps << " pv "
+               << (line.pv.empty() ? move_to_string(board, line.move)
+                                   : pv_to_string(board, line.pv))
+               << "\n";
+        }
+    } else {
+        ss << "info depth " << search.depth() + 1 << " score cp "
+           << std::lround(std::get<2>(r)) << " nodes " << nodes << " time "
+           << ms << " nps " << nps << " pv "
+           << (stats.pv.empty() ? move : pv_to_string(board, stats.pv))
+           << "\n";
+    } // one line per best move in multipv mode
+    ss << "info string qnodes " << stats.qnodes << " ebf "
+       << stats.branching_factor() << " fmc " << stats.first_move_cutoff_rate()
+       << "% hashhits " << stats.hash_hit_rate() << "%";
+    if (stats.splits > 0) {
+        ss << " splits " << stats.splits << " stolen " << stats.steal_rate()
+           << "% cancelled " << stats.aborted;
+    }
+    ss << "\n";
+    ss << "bestmove " << move;
+
+    std::unique_lock<std::mutex> lock(hold);
+    released.wait(lock, [this]() { return !held; });
+    send(ss.str());
+}
+
+void Uci::send(const std::string &line) {
+    std::lock_guard<std::mutex> lock(output);
+    std::cout << line << std::endl;
+}
@@ -0,0 +1,53 @@
+#include "zobrist.h"
+
+/**
+ * @brief all random keys, generated at compile time from a fixed seed
+ * so that keys (and thus hash files or logs) are stable between runs
+ */
+struct ZobristKeys {
+    u_int64_t pieces[2][7][64];
+    u_int64_t castling[16];
+    u_int64_t en_passant[8];
+    u_int64_t side;
+
+    constexpr ZobristKeys() : pieces(), castling(), en_passant(), side() {
+        u_int64_t seed = 0x5EED0F5CA11AB1E5ULL;
+        for (auto &color : pieces) {
+            for (auto &type : color) {
+                for (auto &square : type) {
+                    square = next(seed);
+                }
+            }
+        }
+        for (auto &rights : castling) {
+            rights = next(seed);
+        }
+        for (auto &file : en_passant) {
+            file = next(seed);
+        }
+        side = next(seed);
+    }
+
+    // splitmix64 generator
+    static constexpr u_int64_t next(u_int64_t &seed) {
+        u_int64_t z = (seed += 0x9E3779B97F4A7C15ULL);
+        z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+        z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+        return z ^ (z >> 31);
+    }
+};
+
+static constexpr ZobristKeys KEYS = ZobristKeys();
+
+u_int64_t Zobrist::piece(int type, Color color, const Position &pos) {
+    return KEYS.pieces[color == Color::White ? 0 : 1][type]
+                      [pos.row() * 8 + pos.col()];
+}
+
+u_int64_t Zobrist::castling(int rights) { return KEYS.castling[rights & 15]; }
+
+u_int64_t Zobrist::en_passant(const Position &pos) {
+    return KEYS.en_passant[pos.col()];
+}
+
+u_int64_t Zobrist::side() { return KEYS.side; }
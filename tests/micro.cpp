@@ -0,0 +1,217 @@
+/* micro.cpp
+Micro-benchmarks of the board primitives.
+
+Every call of `Board::get_legal_moves`, `apply_move`, `value_for`,
+`is_in_check`, `from_fen` and `to_fen` is timed on its own over a corpus of
+positions (the bench positions, or an EPD file given with `-c`). The median,
+the 99th percentile and the number of heap allocations per call are written
+as JSON (on the standard output, or in the file given with `-o`) so that two
+commits can be compared component by component.
+
+usage: ./micro [-c CORPUS.epd] [-r ROUNDS] [-o OUTPUT.json]
+*/
+
+#include "lib.h"
+
+#include <iomanip>
+
+#include "bench.h"
+#include "board.h"
+
+const bool WHITE_IS_FILLED = true;
+thread_local State state = State::PROGRAM_STARTING;
+
+// heap allocations since the start of the program
+static u_int64_t allocations = 0;
+
+void *operator new(std::size_t size) {
+    allocations++;
+    void *p = std::malloc(size == 0 ? 1 : size);
+    if (p == nullptr) {
+        throw std::bad_alloc();
+    }
+    return p;
+}
+
+void *operator new[](std::size_t size) { return operator new(size); }
+
+void operator delete(void *p) noexcept { std::free(p); }
+
+void operator delete[](void *p) noexcept { std::free(p); }
+
+void operator delete(void *p, std::size_t) noexcept { std::free(p); }
+
+void operator delete[](void *p, std::size_t) noexcept { std::free(p); }
+
+/**
+ * @brief The Component struct
+ *
+ * Timings of one primitive.
+ */
+struct Component {
+    std::string name;
+    std::vector<int64_t> samples; // ns per call
+    u_int64_t allocations;        // during the timed calls
+};
+
+// keeps the results alive so that the calls are not optimized away
+static volatile u_int64_t sink = 0;
+
+/**
+ * @brief times one call and records it
+ *
+ * @param component where the sample goes
+ * @param f call
+ */
+template <typename F> static void measure(Component &component, F f) {
+    u_int64_t before = allocations;
+    auto start = std::chrono::steady_clock::now();
+    f();
+    auto end = std::chrono::steady_clock::now();
+    component.allocations += allocations - before;
+    component.samples.push_back(
+        std::chrono::duration_cast<std::chrono::nanoseconds>(end - start)
+            .count());
+}
+
+/**
+ * @brief Get a percentile of sorted samples
+ *
+ * @param samples sorted samples
+ * @param p percentile (0 to 100)
+ * @return int64_t - sample
+ */
+static int64_t percentile(const std::vector<int64_t> &samples, double p) {
+    if (samples.empty()) {
+        return 0;
+    }
+    std::size_t i = std::size_t(p / 100. * double(samples.size() - 1) + 0.5);
+    return samples[std::min(i, samples.size() - 1)];
+}
+
+/**
+ * @brief reads the positions of an EPD file
+ *
+ * @param filename path
+ * @return std::vector<std::string> - FEN strings (operations dropped)
+ */
+static std::vector<std::string> read_corpus(const std::string &filename) {
+    std::ifstream file(filename);
+    if (!file) {
+        panic("Could not open " + filename);
+    }
+    std::vector<std::string> fens;
+    std::string line;
+    while (std::getline(file, line)) {
+        line = trim(line);
+        if (!line.empty() && line[0] != '#') {
+            fens.push_back(Board::from_epd(line).to_fen());
+        }
+    }
+    return fens;
+}
+
+int main(int argc, char *argv[]) {
+    std::vector<std::string> fens = Bench::positions();
+    unsigned rounds = 200;
+    std::string output;
+
+    int opt;
+    while ((opt = getopt(argc, argv, "c:r:o:")) != -1) {
+        switch (opt) {
+        case 'c':
+            fens = read_corpus(optarg);
+            break;
+        case 'r':
+            rounds = std::max(unsigned(std::atoi(optarg)), 1u);
+            break;
+        case 'o':
+            output = optarg;
+            break;
+        default:
+            std::cerr << "usage: " << argv[0]
+                      << " [-c CORPUS.epd] [-r ROUNDS] [-o OUTPUT.json]"
+                      << std::endl;
+            return EXIT_FAILURE;
+        }
+    }
+
+    std::vector<Board> boards;
+    std::vector<std::vector<Move>> moves;
+    for (const std::string &fen : fens) {
+        boards.push_back(Board::from_fen(fen));
+        moves.push_back(boards.back().get_legal_moves());
+    }
+
+    Component movegen = {"get_legal_moves", {}, 0};
+    Component apply = {"apply_move", {}, 0};
+    Component eval = {"value_for", {}, 0};
+    Component check = {"is_in_check", {}, 0};
+    Component parse = {"from_fen", {}, 0};
+    Component serialize = {"to_fen", {}, 0};
+
+    for (unsigned round = 0; round < rounds; round++) {
+        for (std::size_t i = 0; i < boards.size(); i++) {
+            Board &board = boards[i];
+            Color color = board.get_turn_color();
+
+            measure(movegen,
+                    [&]() { sink = sink + board.get_legal_moves().size(); });
+            for (const Move &m : moves[i]) {
+                measure(apply, [&]() {
+                    sink = sink + board.apply_move(m, true).get_key();
+                });
+            }
+            measure(eval, [&]() {
+                sink = sink + u_int64_t(board.value_for(color));
+            });
+            measure(check,
+                    [&]() { sink = sink + board.is_in_check(color); });
+            measure(parse, [&]() {
+                sink = sink + Board::from_fen(fens[i]).get_key();
+            });
+            measure(serialize,
+                    [&]() { sink = sink + board.to_fen().size(); });
+        }
+    }
+
+    std::stringstream json;
+    json << "{\"positions\": " << fens.size() << ", \"rounds\": " << rounds
+         << ", \"components\": [";
+    std::cerr << std::left << std::setw(18) << "component" << std::right
+              << std::setw(10) << "calls" << std::setw(12) << "median ns"
+              << std::setw(12) << "p99 ns" << std::setw(14) << "allocs/call"
+              << "\n";
+
+    bool first = true;
+    for (Component *c :
+         {&movegen, &apply, &eval, &check, &parse, &serialize}) {
+        std::sort(c->samples.begin(), c->samples.end());
+        std::size_t calls = c->samples.size();
+        double allocs = calls == 0 ? 0. : double(c->allocations) / calls;
+
+        json << (first ? "" : ", ") << "{\"name\": \"" << c->name
+             << "\", \"calls\": " << calls
+             << ", \"median_ns\": " << percentile(c->samples, 50.)
+             << ", \"p99_ns\": " << percentile(c->samples, 99.)
+             << ", \"allocs_per_call\": " << allocs << "}";
+        std::cerr << std::left << std::setw(18) << c->name << std::right
+                  << std::setw(10) << calls << std::setw(12)
+                  << percentile(c->samples, 50.) << std::setw(12)
+                  << percentile(c->samples, 99.) << std::setw(14) << allocs
+                  << "\n";
+        first = false;
+    }
+    json << "]}";
+
+    if (output.empty()) {
+        std::cout << json.str() << std::endl;
+    } else {
+        std::ofstream file(output);
+        if (!file) {
+            panic("Could not open " + output);
+        }
+        file << json.str() << std::endl;
+    }
+    return EXIT_SUCCESS;
+}
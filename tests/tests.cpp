@@ -7,7 +7,7 @@
 unsigned long _no_asserts = 0;
 
 const bool WHITE_IS_FILLED = true;
-State state = State::PROGRAM_STARTING;
+thread_local State state = State::PROGRAM_STARTING;
 
 
 void dummy_test() {
@@ -19,8 +19,962 @@ void dummy_test() {
     assert_geq(2, 2);
 }
 
+Move parse_move(const std::string &s) {
+    Move m;
+    m.update_from_string(s);
+    return m;
+}
+
+void repetition_test() {
+    Board board = Board::new_board();
+    History keys;
+    assert_eq(board.get_key(), board.compute_key());
+
+    // shuffle knights back and forth twice
+    for (int i = 0; i < 2; i++) {
+        for (const char *s : {"g1f3", "g8f6", "f3g1", "f6g8"}) {
+            assert(!keys.repeated(board.get_key(), board.get_halfmove_clock(),
+                                  2));
+            keys.push(board.get_key());
+            board = board.play_move(parse_move(s), true).next_board();
+            assert_eq(board.get_key(), board.compute_key());
+        }
+    }
+    assert_eq(board.get_halfmove_clock(), 8u);
+    assert_eq(board.get_fullmove_number(), 5u);
+    assert(keys.repeated(board.get_key(), board.get_halfmove_clock(), 2));
+
+    // a stack laid on another one sees its keys too
+    History line = History(&keys);
+    assert_eq(line.size(), keys.size());
+    assert(line.repeated(board.get_key(), board.get_halfmove_clock(), 2));
+    line.push(board.get_key());
+    line.push(board.get_key());
+    assert(line.repeated(board.get_key(), 10, 3));
+    line.pop();
+    line.pop();
+    line.pop();
+    assert_eq(line.size(), keys.size());
+
+    // a pawn move resets the clock, earlier positions can not repeat
+    keys.push(board.get_key());
+    board = board.play_move(parse_move("e2e4"), true).next_board();
+    assert_eq(board.get_halfmove_clock(), 0u);
+    assert(!keys.repeated(board.get_key(), board.get_halfmove_clock()));
+}
+
+void fifty_moves_test() {
+    Board board = Board::from_fen("8/8/4k3/8/8/4K3/8/7R w - - 99 80");
+    assert_eq(board.get_halfmove_clock(), 99u);
+    assert_eq(board.get_fullmove_number(), 80u);
+    assert(!board.is_fifty_moves());
+
+    board = board.play_move(parse_move("h1h2"), true).next_board();
+    assert(board.is_fifty_moves());
+}
+
+void transposition_table_test() {
+    TranspositionTable tt = TranspositionTable(1);
+    Move m = parse_move("e2e4");
+    HashEntry entry;
+
+    assert_eq(Move::unpack(m.pack()), m);
+    assert(!tt.probe(42, entry));
+
+    tt.store(42, m, -150., 3, TranspositionTable::LowerBound);
+    assert(tt.probe(42, entry));
+    assert_eq(entry.move, m);
+    assert_eq(entry.value, -150.);
+    assert_eq(entry.depth, 3);
+    assert_eq(entry.bound, TranspositionTable::LowerBound);
+
+    // shallower bounds do not replace deeper results
+    tt.store(42, Move(), 0., 1, TranspositionTable::UpperBound);
+    assert(tt.probe(42, entry));
+    assert_eq(entry.depth, 3);
+    assert(!tt.probe(42 + tt.size(), entry));
+}
+
+void hash_file_test() {
+    std::string path = "hash_file_test.tt";
+    TranspositionTable tt = TranspositionTable(1);
+    Move m = parse_move("e2e4");
+    HashEntry entry;
+
+    tt.store(42, m, -150., 3, TranspositionTable::LowerBound);
+    tt.store(u_int64_t(1) << 40 | 7, Move(), 25., 5, TranspositionTable::Exact);
+    assert_eq(tt.save(path), 2u);
+    assert(access((path + ".tmp").c_str(), F_OK) != 0);
+
+    // entries are placed again by their keys, whatever the table size
+    TranspositionTable bigger = TranspositionTable(2);
+    assert_eq(bigger.load(path), 2u);
+    assert(bigger.probe(42, entry));
+    assert_eq(entry.move, m);
+    assert_eq(entry.value, -150.);
+    assert_eq(entry.depth, 3);
+    assert(bigger.probe(u_int64_t(1) << 40 | 7, entry));
+    assert_eq(entry.bound, TranspositionTable::Exact);
+    assert(!bigger.probe(43, entry));
+
+    // a damaged file is refused and leaves the table alone
+    std::fstream file(path, std::ios::in | std::ios::out | std::ios::binary);
+    file.seekp(100);
+    file.put('x');
+    file.close();
+    bool refused = false;
+    try {
+        bigger.load(path);
+    } catch (std::invalid_argument &) {
+        refused = true;
+    }
+    assert(refused);
+    assert(bigger.probe(42, entry));
+    assert_eq(truncate(path.c_str(), 16), 0);
+    refused = false;
+    try {
+        tt.load(path);
+    } catch (std::invalid_argument &) {
+        refused = true;
+    }
+    assert(refused);
+    std::remove(path.c_str());
+}
+
+void large_memory_test() {
+    // zeroed, writable, and left alone by a prefault
+    for (std::size_t bytes : {std::size_t(100), 3 * LargeMemory::HUGE_PAGE}) {
+        int mode = -1;
+        char *block = static_cast<char *>(LargeMemory::allocate(bytes, mode));
+        assert(mode >= LargeMemory::HugeTlb && mode <= LargeMemory::Heap);
+        assert_eq(reinterpret_cast<uintptr_t>(block) % 64, 0u);
+        assert_eq(block[0], 0);
+        assert_eq(block[bytes - 1], 0);
+        block[bytes / 2] = 7;
+        LargeMemory::prefault(block, bytes);
+        assert_eq(block[bytes / 2], 7);
+        assert_eq(block[bytes - 1], 0);
+        LargeMemory::release(block, bytes, mode);
+    }
+
+    // a prefaulted table keeps its entries, and is empty after a resize
+    TranspositionTable tt = TranspositionTable(4);
+    HashEntry entry;
+    tt.store(42, parse_move("e2e4"), 10., 2, TranspositionTable::Exact);
+    tt.prefault(true);
+    assert(tt.probe(42, entry));
+    assert_neq(std::string(tt.memory()), std::string("unknown"));
+    tt.resize(2);
+    assert(!tt.probe(42, entry));
+}
+
+void stopped_search_test() {
+    TranspositionTable tt = TranspositionTable(1);
+    SearchThread search = SearchThread(&tt);
+    Board board = Board::from_fen(
+        "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1");
+
+    // stopped before it could finish : still a legal move, not a resign
+    search.start(board, History(), 8);
+    search.stop();
+    Move m = std::get<0>(search.wait());
+    std::vector<Move> legal_moves = board.get_legal_moves();
+    assert(std::find(legal_moves.begin(), legal_moves.end(), m) !=
+           legal_moves.end());
+    assert_eq(search.is_done(), true);
+}
+
+void thread_pool_test() {
+    ThreadPool pool;
+    pool.start(2);
+    assert_eq(pool.size(), 2u);
+    assert_eq(pool.pinned(), false);
+
+    // jobs one after the other reuse the parked workers
+    std::atomic<int> count = 0;
+    for (int i = 0; i < 50; i++) {
+        ThreadPool::Task task = pool.submit([&count]() { count++; });
+        task.wait();
+        assert_eq(task.valid(), false);
+    }
+    assert_eq(count.load(), 50);
+    assert_eq(pool.size(), 2u);
+
+    // a job waiting for another one gets a worker of its own
+    ThreadPool::Task outer = pool.submit([&pool, &count]() {
+        std::vector<ThreadPool::Task> inner;
+        for (int i = 0; i < 3; i++) {
+            inner.push_back(pool.submit([&count]() { count++; }));
+        }
+        for (ThreadPool::Task &task : inner) {
+            task.wait();
+        }
+    });
+    outer.wait();
+    assert_eq(count.load(), 53);
+    assert_leq(pool.size(), 4u);
+
+    // no more workers than allowed : a job left in the queue is run by the
+    // thread that waits for it
+    ThreadPool small;
+    small.start(1);
+    assert_eq(small.limit(), ThreadPool::OVERFLOW_FACTOR);
+    std::atomic<bool> release = false;
+    std::vector<ThreadPool::Task> busy;
+    for (unsigned i = 0; i < small.limit(); i++) {
+        busy.push_back(small.submit([&release]() {
+            while (!release.load()) {
+                std::this_thread::yield();
+            }
+        }));
+    }
+    ThreadPool::Task queued = small.submit([&count]() { count++; });
+    assert_eq(small.size(), small.limit());
+    queued.wait();
+    assert_eq(count.load(), 54);
+    release.store(true);
+    for (ThreadPool::Task &task : busy) {
+        task.wait();
+    }
+    assert_eq(small.size(), small.limit());
+
+    // searches run on the global pool
+    TranspositionTable tt = TranspositionTable(1);
+    SearchThread search = SearchThread(&tt);
+    search.start(Board::new_board(), History(), 2);
+    assert_eq(search.is_running(), true);
+    Move m = std::get<0>(search.wait());
+    assert_eq(search.is_running(), false);
+    std::vector<Move> legal_moves = Board::new_board().get_legal_moves();
+    assert(std::find(legal_moves.begin(), legal_moves.end(), m) !=
+           legal_moves.end());
+}
+
+void split_search_test() {
+    // the owner works at the bottom, thieves at the top
+    WorkDeque<int *> deque;
+    int items[3] = {1, 2, 3};
+    int *item = nullptr;
+    auto any = [](int *) { return true; };
+    for (int &i : items) {
+        assert(deque.push(&i));
+    }
+    assert(deque.pop(item));
+    assert_eq(*item, 3);
+    assert(!deque.steal(item, [](int *i) { return *i == 2; }));
+    assert(deque.steal(item, any));
+    assert_eq(*item, 1);
+    assert(deque.pop(item));
+    assert_eq(*item, 2);
+    assert(!deque.pop(item));
+    assert(!deque.steal(item, any));
+    assert(deque.empty());
+
+    // without a table, splitting the nodes gives the sequential value
+    SplitSearch split = SplitSearch(3);
+    assert_eq(split.threads(), 3u);
+    u_int64_t splits = 0;
+    for (std::size_t i = 0; i < 4; i++) {
+        Board board = Board::from_fen(Bench::positions()[i]);
+        SearchContext alone = SearchContext();
+        SearchContext parallel = SearchContext();
+        split.attach(parallel);
+        double expected = std::get<2>(board.get_next_best_move(3, alone));
+        double value = std::get<2>(board.get_next_best_move(3, parallel));
+        assert_eq(value, expected);
+        assert_eq(parallel.stopped, false);
+        assert_leq(parallel.stats.steals, parallel.stats.tasks);
+        splits += parallel.stats.splits;
+    }
+    assert_gt(splits, 0u);
+
+    // a cutoff by a younger brother cancels the ones after it, whose values
+    // (0, returned as they unwind) never reach the split point
+    SplitSearch one = SplitSearch(1);
+    SearchContext owner_cut = SearchContext();
+    one.attach(owner_cut);
+    Board lost = Board::from_fen("qqqqk3/8/8/8/8/8/8/4K3 w - - 0 1");
+    std::vector<Move> moves = lost.get_legal_moves();
+    assert_eq(moves.size(), 3u);
+    SearchContext reference = SearchContext();
+    Board copy = lost;
+    double first = copy.search_move(moves[1], 2, -999999., -999998., true,
+                                    Color::White, &reference, false);
+    assert_lt(first, 0.);
+    double alpha = -999999., beta = -999998., best_value = -999999.;
+    Move best_move = Move();
+    std::vector<int> order = std::vector<int>(moves.size(), 0);
+    assert(one.split(lost, moves, order, 2, alpha, beta, true, Color::White,
+                     best_value, best_move, &owner_cut));
+    assert_eq(best_move, moves[1]);
+    assert_eq(best_value, first);
+    assert_eq(owner_cut.stats.aborted, 1u);
+    assert_eq(owner_cut.stopped, false);
+
+    // the same on whole searches : brothers are cancelled, values unchanged
+    u_int64_t aborted = 0;
+    for (std::size_t i = 0; i < 4; i++) {
+        Board board = Board::from_fen(Bench::positions()[i]);
+        SearchContext alone = SearchContext();
+        SearchContext parallel = SearchContext();
+        one.attach(parallel);
+        double expected = std::get<2>(board.get_next_best_move(3, alone));
+        double value = std::get<2>(board.get_next_best_move(3, parallel));
+        assert_eq(value, expected);
+        aborted += parallel.stats.aborted;
+    }
+    assert_gt(aborted, 0u);
+
+    // the node budget covers the nodes of every thread
+    SearchContext budget = SearchContext();
+    SearchLimits nodes = SearchLimits(8);
+    nodes.nodes = 20000;
+    budget.limit(nodes);
+    split.attach(budget);
+    Board::new_board().get_next_best_move(8, budget);
+    assert(budget.stopped);
+    assert_leq(budget.stats.total_nodes(), nodes.nodes + 4096);
+
+    // a younger brother gets the budget and reads the keys of its owner
+    SearchContext owner = SearchContext();
+    owner.limit(nodes);
+    owner.history.push(Board::new_board().get_key());
+    SplitPoint point;
+    point.reset(Board::new_board(), 2, -999999., 999999., true, Color::White,
+                &owner);
+    SearchContext brother = SearchContext(&point, 1);
+    assert(brother.can_stop());
+    assert_eq(brother.history.size(), owner.history.size());
+
+    // a stopped split search still answers with a legal move
+    TranspositionTable tt = TranspositionTable(1);
+    SearchThread search = SearchThread(&tt);
+    SearchLimits limits = SearchLimits(8);
+    limits.threads = 2;
+    search.start(Board::new_board(), History(), limits);
+    search.stop();
+    Move m = std::get<0>(search.wait());
+    std::vector<Move> legal_moves = Board::new_board().get_legal_moves();
+    assert(std::find(legal_moves.begin(), legal_moves.end(), m) !=
+           legal_moves.end());
+}
+
+void rating_test() {
+    Board board = Board::new_board();
+    double score = board.score();
+
+    // the cached rating is shared by the display and `score`
+    assert_eq(board.score(), score);
+    assert_eq(board.rating_bar(16).empty(), false);
+    Board::enable_rating(false);
+    assert_eq(board.rating_bar(16).empty(), true);
+    Board::enable_rating(true);
+}
+
+void uci_test() {
+    TranspositionTable tt = TranspositionTable(1);
+    Uci engine(&tt);
+    Board board = Board::new_board();
+    Move m;
+
+    assert_eq(Notation::parse(board, "g1f3", m), Notation::Ok);
+    assert_eq(Uci::move_to_string(board, m), std::string("g1f3"));
+    assert(engine.execute("position startpos moves e2e4 e7e5 g1f3 g8f6 f1c4 "
+                          "f8c5 e1g1"));
+    board = engine.position();
+    assert_eq(board.get_turn_color(), Color::Black);
+    assert_eq(board.get_piece(Position("g1"))->get_type(), Piece::King);
+    assert_eq(Notation::parse(board, "e8g8", m), Notation::Ok);
+    assert_eq(m.move_type(), Move::KingSideCastle);
+    assert_eq(Uci::move_to_string(board, m), std::string("e8g8"));
+
+    // the replies are read back from the standard output
+    std::stringstream out;
+    std::streambuf *console = std::cout.rdbuf(out.rdbuf());
+
+    // an illegal move leaves the position as it was
+    assert(engine.execute("position startpos moves d2d4 d7d5 e1e5"));
+    board = engine.position();
+    assert_eq(board.get_turn_color(), Color::Black);
+    assert_eq(board.get_piece(Position("g1"))->get_type(), Piece::King);
+    assert(out.str().find("info string") != std::string::npos);
+
+    // flags without a value, restricted root moves
+    out.str("");
+    assert(engine.execute("position startpos"));
+    assert(engine.execute("go searchmoves a2a3 h2h4 depth 2"));
+    assert(engine.execute("isready"));
+    assert(engine.execute("stop"));
+    assert(out.str().find("bestmove a2a3") != std::string::npos ||
+           out.str().find("bestmove h2h4") != std::string::npos);
+    assert(out.str().find("unknown go argument") == std::string::npos);
+    out.str("");
+    assert(engine.execute("go depth"));
+    assert(engine.execute("stop"));
+    assert(out.str().find("expected a number after depth") !=
+           std::string::npos);
+
+    // an infinite search keeps its bestmove until stop, ponder until
+    // ponderhit
+    out.str("");
+    assert(engine.execute("go infinite depth 1"));
+    std::this_thread::sleep_for(std::chrono::milliseconds(200));
+    assert(out.str().find("bestmove") == std::string::npos);
+    assert(engine.execute("stop"));
+    assert(out.str().find("bestmove") != std::string::npos);
+    out.str("");
+    assert(engine.execute("go ponder depth 1"));
+    std::this_thread::sleep_for(std::chrono::milliseconds(200));
+    assert(out.str().find("bestmove") == std::string::npos);
+    assert(engine.execute("ponderhit"));
+    assert(engine.execute("stop"));
+    assert(out.str().find("bestmove") != std::string::npos);
+
+    std::cout.rdbuf(console);
+}
+
+void notation_test() {
+    Board board = Board::from_fen(
+        "r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq - 0 1");
+    Move m;
+
+    assert_eq(Notation::parse(board, "Nxf7", m), Notation::Ok);
+    assert_eq(m, parse_move("e5f7"));
+    assert_eq(Notation::parse(board, "e5-f7", m), Notation::Ok);
+    assert_eq(Notation::parse(board, "dxe6!?", m), Notation::Ok);
+    assert_eq(m, parse_move("d5e6"));
+    assert_eq(Notation::parse(board, "Rb1", m), Notation::Ok);
+    assert_eq(Notation::parse(board, "O-O-O", m), Notation::Ok);
+    assert_eq(m.move_type(), Move::QueenSideCastle);
+    assert_eq(Notation::parse(board, "e1c1", m), Notation::Ok);
+    assert_eq(m.move_type(), Move::QueenSideCastle);
+    assert_eq(Notation::parse(board, "Nb5", m), Notation::Ok);
+    assert_eq(Notation::parse(board, "Bd3", m), Notation::Ok);
+    assert_eq(Notation::parse(board, "N5g4", m), Notation::Ok);
+    assert_eq(Notation::parse(board, "Ng4", m), Notation::Ok);
+    assert_eq(Notation::parse(board, "Nd1", m), Notation::Ok);
+    assert_eq(Notation::parse(board, "Ne4", m), Notation::Illegal);
+    assert_eq(Notation::parse(board, "Qe2", m), Notation::Illegal);
+    assert_eq(Notation::parse(board, "Rd1", m), Notation::Ok);
+    assert_eq(Notation::parse(board, "z9", m), Notation::Unreadable);
+
+    board = Board::from_fen("7k/8/8/8/8/8/4K3/R6R w - - 0 1");
+    assert_eq(Notation::parse(board, "Rd1", m), Notation::Ambiguous);
+    assert_eq(Notation::parse(board, "Rhd1", m), Notation::Ok);
+    assert_eq(m, parse_move("h1d1"));
+
+    // promotions keep the piece asked for, a queen when none is written
+    board = Board::from_fen("3nk3/2P5/8/8/8/8/8/4K3 w - - 0 1");
+    int promotion = Piece::None;
+    assert_eq(Notation::parse(board, "c8=N+", m, &promotion), Notation::Ok);
+    assert_eq(promotion, int(Piece::Knight));
+    Board next = board.apply_promotion(m, promotion);
+    assert_eq(next.get_piece(Position("c8"))->get_type(), Piece::Knight);
+    assert_eq(next.get_key(), next.compute_key());
+    assert_eq(Notation::parse(board, "cxd8=R", m, &promotion), Notation::Ok);
+    assert_eq(promotion, int(Piece::Rook));
+    assert_eq(m, parse_move("c7d8"));
+    assert_eq(Notation::parse(board, "c7c8b", m, &promotion), Notation::Ok);
+    assert_eq(promotion, int(Piece::Bishop));
+    assert_eq(Notation::parse(board, "c8", m, &promotion), Notation::Ok);
+    assert_eq(promotion, int(Piece::Queen));
+    assert_eq(Notation::parse(board, "c8=K", m), Notation::Unreadable);
+    assert_eq(Notation::parse(board, "c8=X", m), Notation::Unreadable);
+    assert_eq(Notation::parse(board, "e1e2q", m), Notation::Illegal);
+
+    // the game records the piece, a jump back and forth replays it
+    Game game = Game(board);
+    assert_eq(Notation::parse(game.board(), "c8=N", m, &promotion),
+              Notation::Ok);
+    game.play(m, game.board().apply_promotion(m, promotion));
+    game.jump(0);
+    game.jump(1);
+    assert_eq(game.board().get_piece(Position("c8"))->get_type(),
+              Piece::Knight);
+}
+
+void analyzer_test() {
+    TranspositionTable tt = TranspositionTable(1);
+    std::string json = Analyzer::analyze(
+        "6k1/5ppp/8/8/8/8/5PPP/3R2K1 w - - id \"back rank\";", 7,
+        SearchLimits(1), tt);
+
+    assert_eq(json.rfind("{\"line\": 7, \"id\": \"back rank\"", 0), 0u);
+    assert_neq(json.find("\"bestmove\": \"d1d8\""), std::string::npos);
+    assert_neq(json.find("\"depth\": 2"), std::string::npos);
+}
+
+void multipv_test() {
+    Board board = Board::from_fen(
+        "r1bqkbnr/pppp1ppp/2n5/4p3/4P3/5N2/PPPP1PPP/RNBQKB1R w KQkq - 2 3");
+    std::size_t count = board.get_legal_moves().size();
+    TranspositionTable tt = TranspositionTable(1);
+    SearchContext context = SearchContext(History(), &tt);
+    std::vector<PvLine> all = board.get_best_moves(2, unsigned(count), context);
+
+    // every move once, best first, with the value of the usual search
+    assert_eq(all.size(), count);
+    assert_eq(all.front().value, std::get<2>(board.get_next_best_move(2)));
+    for (std::size_t i = 0; i < all.size(); i++) {
+        assert_eq(all[i].pv.front(), all[i].move);
+        for (std::size_t j = 0; j < i; j++) {
+            assert_neq(all[j].move, all[i].move);
+            assert(all[j].value >= all[i].value);
+        }
+    }
+
+    // fewer lines are the same exact values, from a cold table too
+    tt.clear();
+    context = SearchContext(History(), &tt);
+    std::vector<PvLine> three = board.get_best_moves(2, 3, context);
+    assert_eq(three.size(), 3u);
+    assert_eq(context.stats.lines.size(), 3u);
+    for (std::size_t i = 0; i < three.size(); i++) {
+        assert_eq(three[i].value, all[i].value);
+    }
+
+    // checkmated : a single resign line
+    board = Board::from_fen(
+        "rnb1kbnr/pppp1ppp/8/4p3/6Pq/5P2/PPPPP2P/RNBQKBNR w KQkq - 1 3");
+    context = SearchContext();
+    std::vector<PvLine> none = board.get_best_moves(2, 3, context);
+    assert_eq(none.size(), 1u);
+    assert_eq(none.front().move.move_type(), Move::Resign);
+}
+
+void pgn_test() {
+    PgnReader reader("games.pgn");
+    PgnGame game;
+    unsigned games = 0;
+
+    while (reader.next(game)) {
+        std::string_view fen = game.tag("FEN");
+        Board board = fen.empty() ? Board::new_board()
+                                  : Board::from_fen(fen);
+        for (std::string_view san : game.moves) {
+            Move m;
+            assert_eq(Notation::parse(board, san, m), Notation::Ok);
+            board = board.apply_eval_move(m, true);
+        }
+        if (games++ == 0) {
+            // comments, variations and annotations are skipped
+            assert_eq(game.tag("White"), std::string_view("Morphy, Paul"));
+            assert_eq(game.moves.size(), 33u);
+            assert_eq(game.result, std::string_view("1-0"));
+            assert_eq(board.is_checkmate(), true);
+        }
+    }
+    assert_eq(games, 3u);
+}
+
+void match_test() {
+    MatchStats stats;
+    stats.wins = 600;
+    stats.draws = 200;
+    stats.losses = 200;
+    assert_eq(stats.games(), 1000u);
+    assert_eq(stats.elo() > 140. && stats.elo() < 150., true);
+    assert_eq(stats.elo_error() > 0. && stats.elo_error() < 30., true);
+    assert_eq(stats.sprt(0., 5.), MatchStats::H1);
+    std::swap(stats.wins, stats.losses);
+    assert_eq(stats.sprt(0., 5.), MatchStats::H0);
+
+    EngineConfig engine =
+        EngineConfig::from_string("depth=2,nodes=1000", EngineConfig());
+    assert_eq(engine.limits.depth, 1);
+    assert_eq(engine.limits.nodes, 1000u);
+
+    TranspositionTable white_tt = TranspositionTable(1);
+    TranspositionTable black_tt = TranspositionTable(1);
+    std::string reason;
+    double score =
+        Match::play(Board::from_fen("6k1/5ppp/8/8/8/8/5PPP/3R2K1 w - - 0 1"),
+                    engine, engine, white_tt, black_tt, reason);
+    assert_eq(score, 1.);
+    assert_eq(reason, std::string("checkmate"));
+}
+
+void bench_test() {
+    std::stringstream ss;
+    Bench bench = Bench(2);
+    u_int64_t signature = bench.run(ss);
+
+    // same positions, same depth, same nodes
+    assert_neq(signature, 0u);
+    assert_eq(bench.run(ss), signature);
+}
+
+void profile_test() {
+    Profile::add(Profile::Sorting, 40);
+    Profile::add(Profile::Sorting, 20);
+    Profile::flush();
+
+    std::stringstream ss;
+    Profile::report(ss);
+    assert_neq(ss.str().find("sorting: 2 calls, 60 cycles, 30 cycles/call"),
+               std::string::npos);
+}
+
+void search_stats_test() {
+    Board board = Board::from_fen(
+        "r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq - 0 1");
+    TranspositionTable tt = TranspositionTable(1);
+    SearchContext context = SearchContext(History(), &tt);
+    SearchLimits limits = SearchLimits(2);
+    limits.nodes = 1000000; // a budget makes the search deepen iteratively
+    context.limit(limits);
+    std::tuple<Move, u_int64_t, double> r =
+        board.get_next_best_move(limits.depth, context);
+
+    const SearchStats &stats = context.stats;
+    assert_eq(std::get<1>(r), stats.total_nodes());
+    assert_eq(stats.iterations.size(), 3u);
+    assert_eq(stats.iterations.back().plies, 3);
+    assert_eq(stats.pv.empty(), false);
+    assert_eq(stats.pv.front(), std::get<0>(r));
+    assert_eq(stats.first_move_cutoffs <= stats.cutoffs, true);
+    assert_eq(stats.hash_hits <= stats.hash_probes, true);
+    assert_eq(stats.branching_factor() > 1., true);
+}
+
+void fen_test() {
+    for (const std::string &fen : Bench::positions()) {
+        assert_eq(Board::from_fen(fen).to_fen(), fen);
+    }
+    assert_eq(Board::new_board().to_fen(),
+              "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1");
+
+    // the double push leaves an en passant square, the counters move on
+    Board board = Board::new_board();
+    Move m;
+    assert_eq(Notation::parse(board, "e4", m), Notation::Ok);
+    board = board.apply_eval_move(m, true);
+    assert_eq(board.to_fen(),
+              "rnbqkbnr/pppppppp/8/8/4P3/8/PPPP1PPP/RNBQKBNR b KQkq e3 0 1");
+    assert_eq(Board::from_fen(board.to_fen()).get_key(), board.get_key());
+
+    // the counters may be left out, EPD operations are handed back
+    assert_eq(Board::from_fen("8/8/4k3/8/8/4K3/8/7R b - -").to_fen(),
+              "8/8/4k3/8/8/4K3/8/7R b - - 0 1");
+    std::string_view operations;
+    board = Board::from_epd("8/8/4k3/8/8/4K3/8/7R w - - bm Rh6+; id \"x\";",
+                            &operations);
+    assert_eq(operations, std::string_view("bm Rh6+; id \"x\";"));
+
+    unsigned errors = 0;
+    for (const char *fen : {
+             "8/8/4k3/8/8/4K3/8/7R",             // no side to move
+             "8/8/4k3/8/8/4K3/7R w - - 0 1",     // 7 ranks
+             "8/8/4k3/9/8/4K3/8/7R w - - 0 1",   // 9 squares
+             "8/8/4k3/44/8/4K3/8/7R w - - 0 1",  // consecutive digits
+             "8/8/4k3/8/8/4K3/8/7X w - - 0 1",   // unknown piece
+             "8/8/4k3/8/8/4K3/8/7R x - - 0 1",   // unknown side
+             "8/8/4k3/8/8/4K3/8/7R w qK - 0 1",  // castling order
+             "8/8/4k3/8/8/4K3/8/7R w - e3 0 1",  // e3 with white to move
+             "8/8/4k3/8/8/4K3/8/7R w - - 0 0",   // fullmove 0
+             "8/8/4k3/8/8/4K3/8/7R w - - 01 1",  // leading zero
+             "8/8/4k3/8/8/4K3/8/7R w - - 0",     // one counter
+             "8/8/4k3/8/8/4K3/8/7R w  - - 0 1",  // two spaces
+             "8/8/4k3/8/8/4K3/8/7R w - - 0 1 "}) { // trailing space
+        try {
+            Board::from_fen(fen);
+        } catch (std::invalid_argument &e) {
+            errors++;
+        }
+    }
+    assert_eq(errors, 13u);
+}
+
+void geometry_test() {
+    assert_eq(A1.index(), 0);
+    assert_eq(H8.index(), 63);
+    assert_eq(A1.next_left().is_off_board(), true);
+    assert_eq(H8.next_above(), Position());
+    assert_eq(Position("e4"), E4);
+
+    // squares strictly between, nothing if not on a line
+    assert_eq(std::popcount(A1.squares_between(H8)), 6);
+    assert_eq(A1.squares_between(A8), (u_int64_t(1) << A2.index()) |
+                                          (u_int64_t(1) << A3.index()) |
+                                          (u_int64_t(1) << A4.index()) |
+                                          (u_int64_t(1) << A5.index()) |
+                                          (u_int64_t(1) << A6.index()) |
+                                          (u_int64_t(1) << A7.index()));
+    assert_eq(A1.squares_between(B3), 0u);
+    assert_eq(E4.squares_between(E5), 0u);
+
+    assert_eq(E4.is_diagonal_to(H7), true);
+    assert_eq(E4.is_orthogonal_to(E8), true);
+    assert_eq(E4.is_adjacent_to(F5), true);
+    assert_eq(E4.is_adjacent_to(E6), false);
+    assert_eq(G1.is_knight_move(F3), true);
+    assert_eq(G1.is_knight_move(Position()), false);
+}
+
+/**
+ * @brief counts the leaf nodes of the legal move tree
+ *
+ * @param board position
+ * @param depth plies left
+ * @return u_int64_t - leaf nodes
+ */
+static u_int64_t perft(Board board, int depth) {
+    std::vector<Move> legal_moves = board.get_legal_moves();
+    if (depth == 1) {
+        return legal_moves.size();
+    }
+    u_int64_t nodes = 0;
+    for (const Move &m : legal_moves) {
+        nodes += perft(board.apply_eval_move(m, true), depth - 1);
+    }
+    return nodes;
+}
+
+void movegen_test() {
+    assert_eq(perft(Board::new_board(), 3), 8902u);
+    assert_eq(perft(Board::from_fen("r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/"
+                                    "2N2Q1p/PPPBBPPP/R3K2R w KQkq - 0 1"),
+                    2),
+              2039u);
+    assert_eq(perft(Board::from_fen(
+                        "8/2p5/3p4/KP5r/1R3p1k/8/4P1P1/8 w - - 0 1"),
+                    4),
+              43238u);
+
+    // captures and quiets split the moves, keeping their order
+    for (const std::string &fen : Bench::positions()) {
+        Board board = Board::from_fen(fen);
+        std::vector<Move> all = board.get_legal_moves();
+        std::vector<Move> captures = board.get_legal_moves(Board::Captures);
+        std::vector<Move> quiets = board.get_legal_moves(Board::Quiets);
+        std::vector<Move> merged;
+        std::merge(captures.begin(), captures.end(), quiets.begin(),
+                   quiets.end(), std::back_inserter(merged),
+                   [&](const Move &a, const Move &b) {
+                       return std::find(all.begin(), all.end(), a) <
+                              std::find(all.begin(), all.end(), b);
+                   });
+        assert_eq(merged == all, true);
+        for (const Move &m : captures) {
+            assert_eq(board.has_piece(m.to()) ||
+                          (board.get_en_passant() != nullptr &&
+                           *board.get_en_passant() == m.to()),
+                      true);
+        }
+    }
+
+    // in check, evasions are all the legal moves
+    Board check = Board::from_fen(
+        "rnb1kbnr/pppp1ppp/8/4p3/5PPq/8/PPPPP2P/RNBQKBNR w KQkq - 1 3");
+    assert_eq(check.get_legal_moves(Board::Evasions).empty(), true);
+    check = Board::from_fen("4k3/8/8/8/8/8/3q4/R3K2R w KQ - 0 1");
+    assert_eq(check.get_legal_moves(Board::Evasions).size(), 2u);
+
+    // taking en passant must not uncover the king
+    Board pinned = Board::from_fen("8/8/8/KPp4r/8/8/8/7k w - c6 0 1");
+    assert_eq(pinned.get_legal_moves(Board::Captures).empty(), true);
+    assert_eq(pinned.is_legal_move(parse_move("b5c6"), Color::White), false);
+
+    // a king stepping on the en passant square takes nothing
+    Board step = Board::from_fen("7k/8/8/2KpP3/8/8/8/8 w - d6 0 1");
+    assert_eq(step.apply_eval_move(parse_move("c5d6"), true).has_piece(D5),
+              true);
+
+    // the king may not castle queenside onto an attacked square
+    Board castle = Board::from_fen("2r1k3/8/8/8/8/8/8/R3K3 w Q - 0 1");
+    std::vector<Move> castle_moves = castle.get_legal_moves();
+    assert_eq(std::count_if(castle_moves.begin(), castle_moves.end(),
+                            [](const Move &m) {
+                                return m.move_type() == Move::QueenSideCastle;
+                            }),
+              0);
+}
+
+void see_test() {
+    // a queen taking a pawn defended by a pawn loses the queen for it
+    Board board = Board::from_fen("4k3/8/2p5/3p4/8/8/8/3QK3 w - - 0 1");
+    assert_eq(board.see(parse_move("d1d5")), 100 - 900);
+    // an undefended pawn is won, en passant as well
+    board = Board::from_fen("4k3/8/8/3p4/8/4N3/8/4K3 w - - 0 1");
+    assert_eq(board.see(parse_move("e3d5")), 100);
+    board = Board::from_fen("4k3/8/8/3pP3/8/8/8/4K3 w - d6 0 1");
+    assert_eq(board.see(parse_move("e5d6")), 100);
+    // the rook behind the one taking first takes back (x-ray)
+    board = Board::from_fen("4k3/8/3r4/3p4/8/8/3R4/3RK3 w - - 0 1");
+    assert_eq(board.see(parse_move("d2d5")), 100);
+    board = Board::from_fen("4k3/8/3r4/3p4/8/8/3R4/4K3 w - - 0 1");
+    assert_eq(board.see(parse_move("d2d5")), 100 - 500);
+    // the queen takes back the lone rook, not the one backed by a rook
+    board = Board::from_fen("4k3/8/2q5/3n4/8/8/8/3RK3 w - - 0 1");
+    assert_eq(board.see(parse_move("d1d5")), 320 - 500);
+    board = Board::from_fen("4k3/8/2q5/3n4/8/8/3R4/3RK3 w - - 0 1");
+    assert_eq(board.see(parse_move("d2d5")), 320);
+
+    // past the horizon, the quiescence search sees the pawn take back
+    board = Board::from_fen("4k3/8/2p5/3p4/8/8/8/3QK3 w - - 0 1");
+    SearchContext context = SearchContext();
+    Move m = std::get<0>(board.get_next_best_move(1, context));
+    assert(m != parse_move("d1d5"));
+    assert_gt(context.stats.qnodes, 0u);
+
+    // a player in check at the horizon does not stand pat : the mate is
+    // worth more than the queen
+    board = Board::from_fen("r3k3/5p2/8/1q5Q/2B5/8/8/3RK3 w - - 0 1");
+    context = SearchContext();
+    std::tuple<Move, u_int64_t, double> r =
+        board.get_next_best_move(0, context);
+    assert_eq(std::get<0>(r), parse_move("h5f7"));
+    assert_gt(std::get<2>(r), 900000.);
+}
+
+void undo_test() {
+    // every move taken back gives the same bytes
+    std::vector<std::string> fens = Bench::positions();
+    fens.push_back("r3k2r/8/8/8/8/8/8/R3K2R b KQkq - 3 20");
+    fens.push_back("4k3/8/8/3pP3/8/8/8/4K3 w - d6 0 2");
+    fens.push_back("1n2k3/P7/8/8/8/8/8/4K3 w - - 0 1");
+    for (const std::string &fen : fens) {
+        Board board = Board::from_fen(fen);
+        for (const Move &m : board.get_legal_moves()) {
+            UndoRecord record = board.undo_record(m);
+            Board next = board.apply_eval_move(m, true);
+            assert_eq(next.unmake_move(record).snapshot(), board.snapshot());
+        }
+    }
+
+    // a long game : pops and jumps back unmake, jumps forward and replays
+    // play the moves again
+    Game game;
+    std::vector<std::string> snapshots = {game.board().snapshot()};
+    for (int ply = 0; ply < 300 && !game.board().is_checkmate() &&
+                      !game.board().is_stalemate();
+         ply++) {
+        std::vector<Move> legal_moves = game.board().get_legal_moves();
+        game.play(legal_moves[ply % legal_moves.size()]);
+        snapshots.push_back(game.board().snapshot());
+    }
+    std::size_t plies = game.ply();
+    assert_eq(game.keys().size(), plies);
+    assert_eq(game.replay(plies / 2).snapshot(), snapshots[plies / 2]);
+    assert_eq(game.pop(), true);
+    assert_eq(game.board().snapshot(), snapshots[plies - 1]);
+    game.jump(plies / 3);
+    assert_eq(game.ply(), plies / 3);
+    assert_eq(game.length(), plies);
+    assert_eq(game.board().snapshot(), snapshots[plies / 3]);
+    game.jump(plies);
+    assert_eq(game.board().snapshot(), snapshots[plies]);
+    assert_eq(game.keys().size(), plies);
+    game.jump(0);
+    assert_eq(game.pop(), false);
+    assert_eq(game.board().snapshot(), game.start().snapshot());
+    // a move played after a jump back forgets the moves that followed
+    game.jump(2);
+    game.play(game.board().get_legal_moves().back());
+    assert_eq(game.length(), 3u);
+    assert_eq(game.ply(), 3u);
+
+    // an underpromotion is replayed as played
+    game.reset(Board::from_fen("4k3/P7/8/8/8/8/8/4K3 w - - 0 1"));
+    Move promotion = parse_move("a7a8");
+    Board next = game.board().apply_eval_move(promotion, true);
+    next.set_square(A8, Square::from_piece(
+                            Piece::from_id(Piece::Knight, Color::White, A8)));
+    game.play(promotion, next);
+    assert_eq(game.replay(1).snapshot(), next.snapshot());
+    assert_eq(game.pop(), true);
+    assert_eq(game.board().to_fen(), "4k3/P7/8/8/8/8/8/4K3 w - - 0 1");
+}
+
+void snapshot_test() {
+    assert_eq(sizeof(Board), 96u);
+    for (const std::string &fen : Bench::positions()) {
+        Board board = Board::from_fen(fen);
+        std::string bytes = board.snapshot();
+        assert_eq(bytes.size(), sizeof(Board));
+        assert_eq(Board::from_snapshot(bytes).to_fen(), fen);
+    }
+
+    // the key is checked, as well as every field
+    std::string bytes = Board::new_board().snapshot();
+    unsigned errors = 0;
+    for (std::size_t i : {std::size_t(0), std::size_t(8), bytes.size() - 1}) {
+        std::string corrupted = bytes;
+        corrupted[i] = char(corrupted[i] ^ 0x40);
+        try {
+            Board::from_snapshot(corrupted);
+        } catch (std::invalid_argument &e) {
+            errors++;
+        }
+    }
+    try {
+        Board::from_snapshot(bytes.substr(1));
+    } catch (std::invalid_argument &e) {
+        errors++;
+    }
+    assert_eq(errors, 4u);
+}
+
+/**
+ * @brief Get the resident memory of the process
+ *
+ * @return std::size_t - bytes, 0 if unknown
+ */
+static std::size_t resident_memory() {
+    std::ifstream statm("/proc/self/statm");
+    std::size_t pages = 0, resident = 0;
+    statm >> pages >> resident;
+    return resident * std::size_t(sysconf(_SC_PAGESIZE));
+}
+
+void memory_test() {
+    std::vector<Board> boards;
+    for (const std::string &fen : Bench::positions()) {
+        boards.push_back(Board::from_fen(fen));
+    }
+
+    // a long session of short searches must not grow the process
+    auto session = [&](unsigned searches) {
+        for (unsigned i = 0; i < searches; i++) {
+            SearchContext context = SearchContext();
+            boards[i % boards.size()].get_next_best_move(0, context);
+        }
+    };
+    session(1000);
+    std::size_t before = resident_memory();
+    session(10000);
+    std::size_t after = resident_memory();
+    assert_neq(before, 0u);
+    assert_lt(after, before + 1024 * 1024);
+}
+
 int main() {
     test_case(dummy_test);
+    test_case(repetition_test);
+    test_case(fifty_moves_test);
+    test_case(transposition_table_test);
+    test_case(hash_file_test);
+    test_case(large_memory_test);
+    test_case(stopped_search_test);
+    test_case(thread_pool_test);
+    test_case(split_search_test);
+    test_case(rating_test);
+    test_case(uci_test);
+    test_case(notation_test);
+    test_case(analyzer_test);
+    test_case(multipv_test);
+    test_case(pgn_test);
+    test_case(match_test);
+    test_case(bench_test);
+    test_case(profile_test);
+    test_case(search_stats_test);
+    test_case(fen_test);
+    test_case(geometry_test);
+    test_case(movegen_test);
+    test_case(see_test);
+    test_case(undo_test);
+    test_case(snapshot_test);
+    test_case(memory_test);
 
     return 0;
 }